@@ -5,26 +5,44 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../MC1_application.c \
+../crc.c \
 ../gpio.c \
 ../kepad.c \
 ../lcd.c \
+../lcd_buffer.c \
+../profiler.c \
+../protocol.c \
+../scheduler.c \
 ../timer1.c \
+../timer2.c \
 ../uart.c 
 
 OBJS += \
 ./MC1_application.o \
+./crc.o \
 ./gpio.o \
 ./kepad.o \
 ./lcd.o \
+./lcd_buffer.o \
+./profiler.o \
+./protocol.o \
+./scheduler.o \
 ./timer1.o \
+./timer2.o \
 ./uart.o 
 
 C_DEPS += \
 ./MC1_application.d \
+./crc.d \
 ./gpio.d \
 ./kepad.d \
 ./lcd.d \
+./lcd_buffer.d \
+./profiler.d \
+./protocol.d \
+./scheduler.d \
 ./timer1.d \
+./timer2.d \
 ./uart.d 
 
 
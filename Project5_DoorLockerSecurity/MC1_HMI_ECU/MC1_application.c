@@ -7,10 +7,13 @@
 /*******************************************************************************
  *                                Header Files                                  *
  *******************************************************************************/
-#include	"lcd.h"
+#include	"lcd_buffer.h"
 #include	"keypad.h"
 #include	"uart.h"
+#include	"protocol.h"
 #include	"timer1.h"
+#include	"scheduler.h"
+#include	"profiler.h"
 #include	<util/delay.h>
 
 /*******************************************************************************
@@ -19,57 +22,65 @@
 #define ZERO							0
 
 #ifdef TIMER1_COMPARE
-#define COMPARE_VALUE					7812
+#define COMPARE_VALUE					7999
 #endif
 
-/* UART Values Between MC1 & MC2 */
-#define MC1_READY 						0x01	// MC1 is ready
-#define MC2_READY 						0x02	// MC2 is ready
-
-#define CHANGE_PASSWORD					0x13	// change the password
-#define SAVE_PASSWORD 					0x04	// save the password
-#define PASSWORD_SAVED					0x05	// password has been saved
-#define UNLOCK_THE_DOOR					0x12	// open the door [door sequence]
-#define BUZZER_ON_BYTE					0x11	// turn the buzzer on	[buzzer sequence]
-#define SEND_PASSWORD_TO_BE_CHECKED 	0x06	// send the password to be checked
-#define PASSWORD_CHECK					0x12	// check if the password correct
-#define PASSWORD_DOESNT_MATCH			0x08	// password WRONG
-#define PASSWORD_MATCH					0x09	// password correct
+/* UART Commands Between MC1 & MC2 are defined in protocol.h */
 #define BEGGINING_OF_EEPROM_ADDRESS		0x70	// the first address of the password at EEPROM
 
 /* Password Configurations */
 #define PASSWORD_SIZE					5		// Size of the password
 #define WRONG_PASSWORD					0		// Indicates that is a wrong password
 #define RIGHT_PASSWORD					1		// Indicates that is a correct password
+#define NO_RESPONSE						0		// Indicates that MC2 didn't answer the request, not a command
 
 #define MAX_NO_OF_WRONG_TIMES			3		// Maximum no of wrong times before buzzer turned ON
 
 /* Main Options Configurations*/
 #define OPEN_DOOR_OPTION				'+'		// Option that enable Opening the door
 #define CHANGE_PASSWORD_OPTION			'-'		// Option that change the password of the system
+#define EMERGENCY_LOCK_KEY				'%'		// Key that locks the door while it is unlocking or open
 
 /* Password Symbols */
 #define SUBMIT_PASSWORD					'='		// Indicates that the user want to submit the password
 #define PASSWORD_MARK					'*'		// Password mark that appears on LCD
 
-/* Door Times & Error */
-#define UNLOCK_DOOR_TIME				15
-#define OPEN_DOOR_TIME					3
-#define LOCK_DOOR_TIME					15
-#define ERROR_TIME						60
+/* Error Time (ms), the door steps are timed by MC2 */
+#define ERROR_TIME						60000
 
 /* Delays Configurations */
 #define LCD_DISPLAY_DELAY				1000
-#define KEY_BUTTON_DELAY				500
+#define DOOR_STATUS_PERIOD				250		// Door state polling period while the door sequence runs (ms)
+#define DOOR_START_TIMEOUT				1000	// Time for MC2 to report the door moving before UNLOCK_THE_DOOR is sent again (ms)
 /******************************************************************************/
 
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* States of the door & buzzer sequences displayed by the HMI */
+typedef enum
+{
+	HMI_IDLE, HMI_DOOR_UNLOCKING, HMI_DOOR_OPEN, HMI_DOOR_LOCKING, HMI_DOOR_LOCKED, HMI_ERROR
+}HMI_SequenceStateType;
+
 /*******************************************************************************
  *                           Global Variables                                  *
  *******************************************************************************/
-static uint8 volatile g_tick = 0;		/* to count ticks */
+/* state of the running sequence, the main options are shown only in HMI_IDLE */
+static HMI_SequenceStateType g_sequenceState = HMI_IDLE;
+
+/* timer of the running sequence step */
+static SCHEDULER_TimerId g_sequenceTimer = SCHEDULER_INVALID_TIMER;
+
+/* MC2 reported the door moving since UNLOCK_THE_DOOR, a locked door before means it wasn't received */
+static boolean g_doorMoved = FALSE;
+static uint32 g_unlockSentTick;		/* tick when UNLOCK_THE_DOOR was sent */
+static uint8 g_unlockTries;			/* number of UNLOCK_THE_DOOR sent */
 
 uint8 g_flagPassword; // to store the response
 
+PROTOCOL_FrameType g_responseFrame; // to store the frame received from MC2
+
 /*******************************************************************************
  *                           Structure Configurations                          *
  *******************************************************************************/
@@ -77,23 +88,23 @@ uint8 g_flagPassword; // to store the response
 UART_ConfigType UART_Configurations = {EIGHT_BITS, DISABLED, ONE_BIT, BD_9600, ASYNCHRONOUS, ASYNCHRONOUS_DOUBLE_SPEED};
 
 /*
- * create configuration for timer to get interrupt every 1 second
- * To calculate 1second -> F = 1Hz
+ * create configuration for timer to get interrupt every 1 ms [scheduler tick]
+ * To calculate 1ms -> F = 1KHz
     	F = F(CPU)/N(1+x) = 8Mhz/ N(1+x) try different pre-scalar
-    	N = 64  , x = 124999
-    	N = 256 , x = 31249
-    	N = 1024 , x = 7812
-    so the better is N = 1024
+    	N = 1  , x = 7999
+    	N = 8  , x = 999
+    	N = 64 , x = 124
+    so the better is N = 1, the timer counts the CPU cycles inside each tick
  * Set The Timer 1 Configurations
  */
-Timer1_ConfigType Timer1_Configuration = {ZERO, COMPARE_VALUE, F_CPU_1024, CTC_OCR1A};
+Timer1_ConfigType Timer1_Configuration = {ZERO, COMPARE_VALUE, F_CPU_CLOCK, CTC_OCR1A};
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 /*
  * Description:
  * This is the call back function called by the Timer 1 driver.
- * It is used to calculate the required time for each event.
+ * It is used to count the scheduler ticks and scan the keypad.
  */
 void Timer_callBack(void);
 
@@ -125,19 +136,46 @@ void checkPasswordAfterCreation(void);
  * Description:
  * Function that after choosing the option +
  * and entered the password 3 times wrong
- 	 	 It display ERROR for 60 seconds
+ 	 	 It display ERROR for 60 seconds without blocking
  */
 void buzzerSequence(void);
 /*
  * Description:
  * Function that after choosing the option +
- * and entered the password correctly
- 	 	 1. Door Unlocking 15 seconds
+ * and entered the password correctly starts the door sequence without blocking
+ 	 	 1. Door Unlocking until the bolt is unlocked (15 seconds at most)
  	 	 2. Door Open 3 seconds
- 	 	 3. Door Locking 15 seconds
+ 	 	 3. Door Locking until the bolt is locked (15 seconds at most)
+ * MC2 stops the motor at the end positions, the steps follow the door state it reports.
  */
 void doorSequence(void);
 
+/*
+ * Description:
+ * Scheduler task that moves the door & buzzer sequences to their next step.
+ */
+void sequenceNextStep(void);
+
+/*
+ * Description:
+ * Handle the keys & the frames received while a sequence is running.
+ */
+void sequenceEvents(void);
+
+/*
+ * Description:
+ * Function that after pressing the emergency key while the door is unlocking or open
+ * asks MC2 to lock the door now and waits for its door state.
+ */
+void emergencyLock(void);
+
+/*
+ * Description:
+ * Scheduler task that asks MC2 for the door state, UNLOCK_THE_DOOR is sent again
+ * while MC2 doesn't report the door moving.
+ */
+void requestDoorStatus(void);
+
 /*Description: Function to save the  password
  * Inputs:
 	1. array: to store the password
@@ -152,26 +190,42 @@ int main(void)
 	/*Enable I-bit = 1*/
 	S_REG.Bits.I_Bit = 1;
 
-	/* initialize LCD driver*/
-	LCD_init();
+	/* initialize LCD driver & its framebuffer*/
+	LCD_bufferInit();
 
 	/*initiate UART driver*/
 	UART_init(&UART_Configurations);
 
-	/*send byte to MC2 to tell him that MC1 is ready*/
-	UART_sendByte(MC1_READY);
+	/*send frame to MC2 to tell him that MC1 is ready*/
+	PROTOCOL_sendFrame(MC1_READY, NULL_PTR, 0);
+
+	/* initialize the scheduler & keypad before their timer starts ticking */
+	SCHEDULER_init();
+	KEYPAD_init();
 
-	/* initialize LCD driver*/
+	/* initialize timer 1 driver*/
 	Timer1_init(&Timer1_Configuration);
 	/* set the call back to pointer in the Timer 1 */
 	Timer1_setCallBack(Timer_callBack);
 
+	/* the profiler counts the Timer 1 cycles of the scheduler tick */
+	PROFILER_init();
 
 	createAndCheckPassword();
 
 	while(1)
 	{
-		mainOptions();
+		/* run the steps of the door & buzzer sequences that are due */
+		SCHEDULER_dispatch();
+
+		if(g_sequenceState == HMI_IDLE)
+		{
+			mainOptions();
+		}
+		else
+		{
+			sequenceEvents();
+		}
 	}
 
 }
@@ -194,86 +248,104 @@ void createAndCheckPassword(void)
 	uint8 arr_confirm_pass[PASSWORD_SIZE];
 
 	/* variable to count from 0 to password size*/
-	uint8 passCounter = 0;
+	uint8 passCounter;
 
 	/* variable to check the state of the password whether right or wrong */
-	uint8 password_checking_state = RIGHT_PASSWORD;
+	uint8 password_checking_state;
 
-	/* Clear LCD & display Enter Pass*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("plz enter pass: ");
-	LCD_moveCursor(1,0);
+	/* TRUE when MC2 has saved the password */
+	boolean password_saved = FALSE;
 
-	/* save the entered Password*/
-	savePassword(arr_pass,PASSWORD_SIZE,key);
-
-
-	/* Clear LCD & display re-enter Pass*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("plz re-enter");
-	LCD_moveCursor(1,0);
-	LCD_displayString("pass:");
-
-	/*
-		- Enter password of PASSWORD_SIZE characters using keypad
-	  	- save the re-entered password , confirmation
-	*/
-	savePassword(arr_confirm_pass,PASSWORD_SIZE,key);
-
-	/* check if the two arrays of password are identical or not*/
-	/* Check whether the two password are identical or not while creating new password
-	 * Inputs :
-			1. array contains the values of first password
-			2. array contains the values of second password
-			3. size: to know the size of the password [size of the array]
-			4. state: check whether both matched or not
-	 */
-	while(passCounter < PASSWORD_SIZE)
+	/* the password is asked again until both entries match and MC2 saves it, a loop and
+	 * not a new call so the stack doesn't grow while the EEPROM keeps failing */
+	do
 	{
-		if(arr_pass[passCounter] != arr_confirm_pass[passCounter])
+		passCounter = 0;
+		password_checking_state = RIGHT_PASSWORD;
+
+		/* Clear LCD & display Enter Pass*/
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,0);
+		LCD_bufferDisplayString("plz enter pass: ");
+		LCD_bufferMoveCursor(1,0);
+
+		/* save the entered Password*/
+		savePassword(arr_pass,PASSWORD_SIZE,key);
+
+
+		/* Clear LCD & display re-enter Pass*/
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,0);
+		LCD_bufferDisplayString("plz re-enter");
+		LCD_bufferMoveCursor(1,0);
+		LCD_bufferDisplayString("pass:");
+
+		/*
+			- Enter password of PASSWORD_SIZE characters using keypad
+		  	- save the re-entered password , confirmation
+		*/
+		savePassword(arr_confirm_pass,PASSWORD_SIZE,key);
+
+		/* check if the two arrays of password are identical or not*/
+		/* Check whether the two password are identical or not while creating new password
+		 * Inputs :
+				1. array contains the values of first password
+				2. array contains the values of second password
+				3. size: to know the size of the password [size of the array]
+				4. state: check whether both matched or not
+		 */
+		while(passCounter < PASSWORD_SIZE)
 		{
-			/* if any character is different then both are not identical then it is not matched*/
-			password_checking_state = WRONG_PASSWORD;
-			break;
+			if(arr_pass[passCounter] != arr_confirm_pass[passCounter])
+			{
+				/* if any character is different then both are not identical then it is not matched*/
+				password_checking_state = WRONG_PASSWORD;
+				break;
+			}
+			passCounter++;
 		}
-		passCounter++;
-	}
-
-	if(password_checking_state == RIGHT_PASSWORD)
-	{
-		/* since the password is identical in both array we need to save it in the EEPROM*/
-		UART_sendByte(SAVE_PASSWORD);
-		_delay_ms(10);
 
-		/* [send the array]send the password */
-		for(passCounter = 0; passCounter < PASSWORD_SIZE; passCounter++)
+		if(password_checking_state == RIGHT_PASSWORD)
 		{
-
-			/* Waits until MC2 ready to receive the password */
-			while(UART_recieveByte() != MC2_READY);
-			/* send the password byte by byte*/
-			UART_sendByte(arr_pass[passCounter]);
+			/* since the password is identical in both array we need to save it in the EEPROM
+			 * send the whole password in one frame and wait until MC2 save it */
+			if(PROTOCOL_request(SAVE_PASSWORD, arr_pass, PASSWORD_SIZE, PASSWORD_SAVED, PASSWORD_SAVE_FAILED,
+					&g_responseFrame) != PROTOCOL_FRAME_READY)
+			{
+				g_responseFrame.command = NO_RESPONSE;
+			}
+
+			if(g_responseFrame.command != PASSWORD_SAVED)
+			{
+				/* the EEPROM write failed or MC2 didn't answer, the password has to be entered again */
+				LCD_bufferClear();
+				LCD_bufferMoveCursor(0,1);
+				LCD_bufferDisplayString((g_responseFrame.command == NO_RESPONSE) ? "NO RESPONSE" : "SAVE FAILED");
+				LCD_bufferMoveCursor(1,1);
+				LCD_bufferDisplayString("	TRY AGAIN!!!");
+				LCD_flush();
+				_delay_ms(LCD_DISPLAY_DELAY);
+				continue;
+			}
+
+			LCD_bufferClear();
+			LCD_bufferMoveCursor(0,1);
+			LCD_bufferDisplayString("Saved The Pass");
+			LCD_flush();
+			_delay_ms(LCD_DISPLAY_DELAY);
+			password_saved = TRUE;
 		}
-
-		/* wait until MC2 save the password in the EEPROM*/
-		while(UART_recieveByte()!=PASSWORD_SAVED);
-		LCD_clearScreen();
-		LCD_moveCursor(0,1);
-		LCD_displayString("Saved The Pass");
-		_delay_ms(LCD_DISPLAY_DELAY);
-	}
-	else
-	{
-		LCD_clearScreen();
-		LCD_moveCursor(0,1);
-		LCD_displayString("WRONG PASS");
-		LCD_moveCursor(1,1);
-		LCD_displayString("	TRY AGAIN!!!");
-		_delay_ms(LCD_DISPLAY_DELAY);
-		createAndCheckPassword();
-	}
+		else
+		{
+			LCD_bufferClear();
+			LCD_bufferMoveCursor(0,1);
+			LCD_bufferDisplayString("WRONG PASS");
+			LCD_bufferMoveCursor(1,1);
+			LCD_bufferDisplayString("	TRY AGAIN!!!");
+			LCD_flush();
+			_delay_ms(LCD_DISPLAY_DELAY);
+		}
+	}while(password_saved == FALSE);
 }
 
 /*Description: Function to save the  password
@@ -287,31 +359,29 @@ void savePassword(uint8 *arr_pass , uint8 arr_size, uint8 key_num)
 	/* send the 5bytes of the Password*/
 	for(uint8 passCounter = 0; passCounter < PASSWORD_SIZE; passCounter++)
 	{
-		/* Get the pressed key number, if any switch pressed for more than 500 ms
-		 * it will considered more than one press */
-		key_num = KEYPAD_getPressedKey();
-		_delay_ms(10);
+		/* show the prompt & the marks written so far before waiting for the keypad */
+		LCD_flush();
 
+		/* Get the pressed key number, the keypad driver debounces it and
+		 * repeats it if it is held */
 		/* if the user enter any character except from 0 to 9 don't accept it*/
 		do
 		{
 			key_num = KEYPAD_getPressedKey();
-			_delay_ms(10);
-		}while((!((key_num>=0) && (key_num<=9))));
+		}while(key_num > 9);
 
 		/*when this loop end this means that the user entered from 0 to 9*/
 
 		/*set the pass in the confirmation array*/
 		arr_pass[passCounter] = key_num;
 		/* display on the LCD as ASCII '*' */
-		LCD_displayCharacter(PASSWORD_MARK);
-		_delay_ms(KEY_BUTTON_DELAY);	/*press time*/
+		LCD_bufferDisplayCharacter(PASSWORD_MARK);
 	}
+	LCD_flush();
 	do
 	{
 		/* won't save the password until the person press =*/
 		key_num = KEYPAD_getPressedKey();
-		_delay_ms(50);
 	}while(key_num != SUBMIT_PASSWORD);
 }
 
@@ -327,56 +397,49 @@ void checkPasswordAfterCreation(void)
 	/* array to get the pass */
 	uint8 arr_pass[PASSWORD_SIZE];
 
-	/* variable to count the size of actual password*/
-	uint8 passCounter = 0;
-
 	/* variable to store the value while receiving if the password is wrong or not */
 	uint8 password_receivig ;
 
-	uint8 wrong_times = 0;	/* variable to store the wrong times that password have been submitted*/
-
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("plz enter pass: ");
-	LCD_moveCursor(1,0);
+	LCD_bufferClear();
+	LCD_bufferMoveCursor(0,0);
+	LCD_bufferDisplayString("plz enter pass: ");
+	LCD_bufferMoveCursor(1,0);
 
 	/*enter your password that contains of 5 characters using keypad*/
 	savePassword(arr_pass,PASSWORD_SIZE,key);
-	LCD_clearScreen();
-
-	/* send the password to EEPROM to check whether the password is right or wrong*/
-	UART_sendByte(PASSWORD_CHECK);
-	_delay_ms(10);
-
-	/* loop to send the password to the EEPROM to be checked*/
-	passCounter = 0;
-
+	LCD_bufferClear();
+	LCD_flush();
 
-	/* check if the two arrays of password are identical or not*/
-	while(passCounter < PASSWORD_SIZE)
+	/* send the whole password in one frame to MC2 to check whether the password is right or wrong
+	 * and wait until MC2 send the verdict in one frame */
+	if(PROTOCOL_request(PASSWORD_CHECK, arr_pass, PASSWORD_SIZE, PASSWORD_MATCH, PASSWORD_DOESNT_MATCH,
+			&g_responseFrame) == PROTOCOL_FRAME_READY)
 	{
-		/* waits until MC2 receive*/
-		while(UART_recieveByte()!=MC2_READY);
-
-		/*send each byte*/
-		UART_sendByte(arr_pass[passCounter]);
-
-		password_receivig = UART_recieveByte();
-		if(password_receivig == PASSWORD_DOESNT_MATCH)
-		{
-			wrong_times++;
-		}
-		passCounter++;
+		password_receivig = g_responseFrame.command;
+	}
+	else
+	{
+		password_receivig = NO_RESPONSE;
 	}
 
 	/* this means that u have entered the password correct*/
-	if(wrong_times == 0)
+	if(password_receivig == PASSWORD_MATCH)
 	{
-		LCD_clearScreen();
-		LCD_moveCursor(0,1);
-		LCD_displayString("Correct");
-		LCD_moveCursor(1,0);
-		LCD_displayString("Password");
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,1);
+		LCD_bufferDisplayString("Correct");
+		LCD_bufferMoveCursor(1,0);
+		LCD_bufferDisplayString("Password");
+		LCD_flush();
+		_delay_ms(LCD_DISPLAY_DELAY);
+	}
+	else if(password_receivig == NO_RESPONSE)
+	{
+		/* the password isn't counted as wrong, the main options are shown again */
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,1);
+		LCD_bufferDisplayString("NO RESPONSE");
+		LCD_flush();
 		_delay_ms(LCD_DISPLAY_DELAY);
 	}
 	else
@@ -389,87 +452,217 @@ void checkPasswordAfterCreation(void)
 /*
  * Description:
  * Function that after choosing the option +
- * and entered the password correctly
- 	 	 1. Door Unlocking 15 seconds
+ * and entered the password correctly starts the door sequence without blocking
+ 	 	 1. Door Unlocking until the bolt is unlocked (15 seconds at most)
  	 	 2. Door Open 3 seconds
- 	 	 3. Door Locking 15 seconds
+ 	 	 3. Door Locking until the bolt is locked (15 seconds at most)
+ * MC2 stops the motor at the end positions, the steps follow the door state it reports.
  */
 void doorSequence(void)
 {
-	Timer1_init(&Timer1_Configuration);
-	Timer1_setCallBack(Timer_callBack);
-
 	/*1. Display The Door is Unlocking*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("Door is ");
-		LCD_moveCursor(1,0);
-		LCD_displayString("Unlocking");
-
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the door unlock time be done then break the loop*/
-	while (g_tick != UNLOCK_DOOR_TIME) {} ;
-
-	/*2. Display The Door is OPEN*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("Door is open");
-
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the door open time be done then break the loop*/
-	while (g_tick != OPEN_DOOR_TIME) {} ;
-
-
-	/*3. Display The Door is Locking*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("Door is Locking");
-
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the door lock time be done then break the loop*/
-	while (g_tick != LOCK_DOOR_TIME) {} ;
-	Timer1_deInit();		/* stop the timer */
-
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("Door is Locked");
-	_delay_ms(LCD_DISPLAY_DELAY);	// to see this message
-
+	LCD_bufferClear();
+	LCD_bufferMoveCursor(0,0);
+	LCD_bufferDisplayString("Door is ");
+		LCD_bufferMoveCursor(1,0);
+		LCD_bufferDisplayString("Unlocking");
+
+	/* the next steps run when MC2 reports the door moved on */
+	PROTOCOL_sendFrame(UNLOCK_THE_DOOR, NULL_PTR, 0);
+	g_unlockSentTick = SCHEDULER_getTicks();
+	g_unlockTries = 1;
+	g_doorMoved = FALSE;
+	g_sequenceState = HMI_DOOR_UNLOCKING;
+	LCD_flush();
+	g_sequenceTimer = SCHEDULER_startPeriodic(DOOR_STATUS_PERIOD, requestDoorStatus);
 }
 
 /*
  * Description:
  * Function that after choosing the option +
  * and entered the password 3 times wrong
- 	 	 It display ERROR for 60 seconds
+ 	 	 It display ERROR for 60 seconds without blocking
  */
 void buzzerSequence(void)
 {
-	/* create configuration for timer to get interrupt every 1 second */
-	Timer1_init(&Timer1_Configuration);
-	Timer1_setCallBack(Timer_callBack);
+	/*Display ERROR cause u have entered the max no allowed of passwords wrong*/
+	LCD_bufferClear();
+	LCD_bufferMoveCursor(0,0);
+	LCD_bufferDisplayString("ERROR! 3 times");
+	LCD_bufferMoveCursor(1,0);
+	LCD_bufferDisplayString("wait 60 sec");
+
+	/* the main options come back when the error time is done */
+	g_sequenceState = HMI_ERROR;
+	LCD_flush();
+	g_sequenceTimer = SCHEDULER_startOneShot(ERROR_TIME, sequenceNextStep);
+}
 
+/*
+ * Description:
+ * Scheduler task that moves the door & buzzer sequences to their next step.
+ */
+void sequenceNextStep(void)
+{
+	switch(g_sequenceState)
+	{
+	case HMI_DOOR_UNLOCKING:
+		/*2. Display The Door is OPEN*/
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,0);
+		LCD_bufferDisplayString("Door is open");
+		LCD_flush();
+		g_sequenceState = HMI_DOOR_OPEN;
+		break;
+
+	case HMI_DOOR_OPEN:
+		/*3. Display The Door is Locking*/
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,0);
+		LCD_bufferDisplayString("Door is Locking");
+		LCD_flush();
+		g_sequenceState = HMI_DOOR_LOCKING;
+		break;
+
+	case HMI_DOOR_LOCKING:
+		/*4. Display The Door is Locked for some time to see this message*/
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,0);
+		LCD_bufferDisplayString("Door is Locked");
+		LCD_flush();
+		/* the door doesn't move anymore, stop asking about its state */
+		SCHEDULER_stop(g_sequenceTimer);
+		g_sequenceState = HMI_DOOR_LOCKED;
+		g_sequenceTimer = SCHEDULER_startOneShot(LCD_DISPLAY_DELAY, sequenceNextStep);
+		break;
+
+	default:
+		/* the sequence is done, show the main options again */
+		g_sequenceTimer = SCHEDULER_INVALID_TIMER;
+		g_sequenceState = HMI_IDLE;
+		break;
+	}
+}
 
-	/*Display ERROR cause u have entered the max no allowed of passwords wrong*/
-	LCD_clearScreen();
-	LCD_moveCursor(0,0);
-	LCD_displayString("ERROR! 3 times");
-	LCD_moveCursor(1,0);
-	LCD_displayString("wait 60 sec");
-	_delay_ms(LCD_DISPLAY_DELAY);
-	/* start the timer */
-	Timer1_init(&Timer1_Configuration);
-	/* waits until the error time be done then break the loop*/
+/*
+ * Description:
+ * Handle the keys & the frames received while a sequence is running.
+ */
+void sequenceEvents(void)
+{
+	KEYPAD_EventType event;
 
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the door open time be done then break the loop*/
-	while (g_tick != ERROR_TIME) {} ;
+	/* the keys pressed while a sequence is running are not type ahead for the options */
+	while(KEYPAD_poll(&event) == TRUE)
+	{
+		if((event.kind == KEYPAD_PRESSED) && (event.key == EMERGENCY_LOCK_KEY))
+		{
+			emergencyLock();
+		}
+	}
 
-	Timer1_deInit();		/* stop the timer */
+	if(PROTOCOL_poll(&g_responseFrame) == PROTOCOL_FRAME_READY)
+	{
+		if((g_responseFrame.command == DOOR_STATUS) && (g_sequenceState >= HMI_DOOR_UNLOCKING) &&
+				(g_sequenceState <= HMI_DOOR_LOCKING))
+		{
+			if(g_responseFrame.payload[0] != DOOR_LOCKED)
+			{
+				g_doorMoved = TRUE;
+			}
+
+			/* show the steps the door passed since the last answer */
+			switch(g_responseFrame.payload[0])
+			{
+			case DOOR_OPEN:
+				if(g_sequenceState == HMI_DOOR_UNLOCKING)
+				{
+					sequenceNextStep();
+				}
+				break;
+
+			case DOOR_LOCKING:
+				while(g_sequenceState < HMI_DOOR_LOCKING)
+				{
+					sequenceNextStep();
+				}
+				break;
+
+			case DOOR_LOCKED:
+				/* locked before any movement, MC2 hasn't started the sequence, unless an
+				 * emergency lock came first */
+				if(!g_doorMoved && (g_sequenceState != HMI_DOOR_LOCKING))
+				{
+					break;
+				}
+				while(g_sequenceState < HMI_DOOR_LOCKED)
+				{
+					sequenceNextStep();
+				}
+				break;
+
+			default:
+				/* the door is still unlocking */
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Description:
+ * Function that after pressing the emergency key while the door is unlocking or open
+ * asks MC2 to lock the door now and waits for its door state.
+ */
+void emergencyLock(void)
+{
+	if((g_sequenceState != HMI_DOOR_UNLOCKING) && (g_sequenceState != HMI_DOOR_OPEN))
+	{
+		/* the door is already locking */
+		return;
+	}
+
+	PROTOCOL_sendFrame(EMERGENCY_LOCK, NULL_PTR, 0);
+
+	LCD_bufferClear();
+	LCD_bufferMoveCursor(0,0);
+	LCD_bufferDisplayString("Door is Locking");
+	LCD_flush();
+
+	/* the door state is still asked until the door is locked */
+	g_sequenceState = HMI_DOOR_LOCKING;
+}
+
+/*
+ * Description:
+ * Scheduler task that asks MC2 for the door state, UNLOCK_THE_DOOR is sent again
+ * while MC2 doesn't report the door moving.
+ */
+void requestDoorStatus(void)
+{
+	if((g_sequenceState == HMI_DOOR_UNLOCKING) && !g_doorMoved &&
+			(((SCHEDULER_getTicks() - g_unlockSentTick) * SCHEDULER_TICK_MS) >= DOOR_START_TIMEOUT))
+	{
+		if(g_unlockTries == PROTOCOL_REQUEST_TRIES)
+		{
+			/* MC2 never reported the door moving, show the main options again */
+			LCD_bufferClear();
+			LCD_bufferMoveCursor(0,1);
+			LCD_bufferDisplayString("NO RESPONSE");
+			LCD_flush();
+			SCHEDULER_stop(g_sequenceTimer);
+			g_sequenceState = HMI_DOOR_LOCKED;
+			g_sequenceTimer = SCHEDULER_startOneShot(LCD_DISPLAY_DELAY, sequenceNextStep);
+			return;
+		}
+
+		/* UNLOCK_THE_DOOR or all the answers since were lost, MC2 ignores it if the door moves */
+		PROTOCOL_sendFrame(UNLOCK_THE_DOOR, NULL_PTR, 0);
+		g_unlockSentTick = SCHEDULER_getTicks();
+		g_unlockTries++;
+	}
+
+	PROTOCOL_sendFrame(DOOR_STATUS_REQUEST, NULL_PTR, 0);
 }
 
 
@@ -487,35 +680,32 @@ void mainOptions(void)
 	/* to get the pressed key */
 	uint8 option;
 
-	LCD_clearScreen();
+	LCD_bufferClear();
 	/*Display Options :		+ => Open Door		, - => set a new password*/
-	LCD_moveCursor(0,1);
-	LCD_displayString("+ : Open Door");
-	LCD_moveCursor(1,1);
-	LCD_displayString("- : Change Pass");
+	LCD_bufferMoveCursor(0,1);
+	LCD_bufferDisplayString("+ : Open Door");
+	LCD_bufferMoveCursor(1,1);
+	LCD_bufferDisplayString("- : Change Pass");
 	/* note that we should use do while here cause he must press + or -
 	 * if the person pressed any other button won't get out of this loop*/
 	/* make him must choose + or - any button else make him in the loop*/
-	_delay_ms(500);
+	LCD_flush();
 	do
 	{
 		/* get the pressed key value */
 		option = KEYPAD_getPressedKey();
-		_delay_ms(KEY_BUTTON_DELAY);
 		if((option == OPEN_DOOR_OPTION) || (option == CHANGE_PASSWORD_OPTION))
 			break;
 	}while(1);
 
-	LCD_clearScreen();
+	LCD_bufferClear();
 
 	/* make loop that decrease from 3 to 0 to check no. of wrong times have beed inserted*/
 	uint8 count = MAX_NO_OF_WRONG_TIMES;
 
 	while(count>0)
 	{
-		/*send to MC2 OPEN the door so we need to insert password */
-		UART_sendByte(SEND_PASSWORD_TO_BE_CHECKED);
-
+		/*insert password and send it to MC2 to be checked */
 		checkPasswordAfterCreation();
 
 		/* using the previous function[check pass] will effect the global flag status*/
@@ -524,17 +714,23 @@ void mainOptions(void)
 			/*there nothing wrong with the password [correct]*/
 			break;
 		}
+		if(g_flagPassword == NO_RESPONSE)
+		{
+			/* MC2 didn't answer, nothing is done */
+			break;
+		}
 		/* if we didn't break the loop this means that the password is wrong */
-		LCD_clearScreen();
-		LCD_moveCursor(0,1);
-		LCD_displayString("Wrong Pass");
+		LCD_bufferClear();
+		LCD_bufferMoveCursor(0,1);
+		LCD_bufferDisplayString("Wrong Pass");
+		LCD_flush();
 		_delay_ms(LCD_DISPLAY_DELAY);
 		count--;
 	}
 	if(g_flagPassword == PASSWORD_DOESNT_MATCH)
 	{
 		/* send command to the MC2 to turn the buzzer on */
-		UART_sendByte(BUZZER_ON_BYTE);
+		PROTOCOL_sendFrame(BUZZER_ON_BYTE, NULL_PTR, 0);
 		buzzerSequence();
 	}
 	else if(g_flagPassword == PASSWORD_MATCH)
@@ -543,12 +739,10 @@ void mainOptions(void)
 		{
 		case OPEN_DOOR_OPTION:
 			/*send to MC2 to open the door [rotate the DC-motor]*/
-			UART_sendByte(UNLOCK_THE_DOOR);
 			doorSequence();
 			break;
 		case CHANGE_PASSWORD_OPTION:
-			/*send to MC2 to change the password in the EEPROM */
-			UART_sendByte(CHANGE_PASSWORD);
+			/*create the new password, it is sent to MC2 in the SAVE_PASSWORD frame */
 			createAndCheckPassword();
 			break;
 
@@ -559,11 +753,10 @@ void mainOptions(void)
 
 
 /* Description:
- * 	used to set the required time in each task.
+ * 	used to count the scheduler ticks and scan the keypad.
  */
 void Timer_callBack(void)
 {
-	g_tick++;
-	/* clear the register*/
-	TCNT1_REG.TwoBytes = 0;
+	SCHEDULER_tick();
+	KEYPAD_tick();
 }
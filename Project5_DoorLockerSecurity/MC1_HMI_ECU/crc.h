@@ -0,0 +1,51 @@
+ /******************************************************************************
+ * Module: CRC
+ * File Name: crc.h
+ * Description: Header file for the CRC-8 & CRC-16 calculations used to protect data
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef CRC_H_
+#define CRC_H_
+
+#include	"std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* CRC-8 polynomial x^8 + x^2 + x + 1 and its initial value */
+#define CRC8_POLYNOMIAL				0x07
+#define CRC8_INITIAL_VALUE			0x00
+
+/* CRC-16/CCITT polynomial x^16 + x^12 + x^5 + 1 and its initial value */
+#define CRC16_POLYNOMIAL			0x1021
+#define CRC16_INITIAL_VALUE			0xFFFF
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Update the running CRC-8 value with one more byte and return the new value.
+ */
+uint8 CRC_crc8Update(uint8 crc, uint8 data);
+
+/*
+ * Description :
+ * Calculate the CRC-8 of size bytes starting from the CRC8_INITIAL_VALUE.
+ */
+uint8 CRC_crc8(const uint8 *data, uint8 size);
+
+/*
+ * Description :
+ * Update the running CRC-16 value with one more byte and return the new value.
+ */
+uint16 CRC_crc16Update(uint16 crc, uint8 data);
+
+/*
+ * Description :
+ * Calculate the CRC-16 of size bytes starting from the CRC16_INITIAL_VALUE.
+ */
+uint16 CRC_crc16(const uint8 *data, uint8 size);
+
+#endif /* CRC_H_ */
@@ -7,6 +7,7 @@
 #include "gpio.h"
 #include "common_macros.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
 /*
  * Description :
  * Setup the direction of the required pin input/output.
@@ -20,6 +21,10 @@ void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType
 	}
 	else
 	{
+		/* the read-modify-write must not be split by an ISR that writes the same register */
+		uint8 sreg = SREG;
+		cli();
+
 		/* Setup the pin direction as required */
 		switch(port_num)
 		{
@@ -48,6 +53,7 @@ void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType
 				CLEAR_BIT(DDRD, pin_num);
 			break;
 		}
+		SREG = sreg;
 	}
 }
 
@@ -65,6 +71,10 @@ void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value)
 	}
 	else
 	{
+		/* the read-modify-write must not be split by an ISR that writes the same register */
+		uint8 sreg = SREG;
+		cli();
+
 		switch(port_num)
 		{
 		case PORTA_ID:
@@ -92,6 +102,7 @@ void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value)
 				CLEAR_BIT(PORTD,pin_num);
 			break;
 		}
+		SREG = sreg;
 	}
 }
 
@@ -205,6 +216,45 @@ void GPIO_writePort(uint8 port_num, uint8 value)
 	}
 }
 
+/*
+ * Description :
+ * Write the value bits on the pins selected by the mask in one store, the other pins keep their values.
+ * The read-modify-write is done with the interrupts disabled so it is safe against ISRs using the same port.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writeMasked(uint8 port_num, uint8 mask, uint8 value)
+{
+	uint8 sreg;
+
+	if(port_num>=NUM_OF_PORTS)
+	{
+			/*Do Nothing*/
+	}
+	else
+	{
+		value &= mask;
+		sreg = SREG;
+		cli();
+
+		switch(port_num)
+		{
+		case PORTA_ID:
+			PORTA = (PORTA & ~mask) | value;
+			break;
+		case PORTB_ID:
+			PORTB = (PORTB & ~mask) | value;
+			break;
+		case PORTC_ID:
+			PORTC = (PORTC & ~mask) | value;
+			break;
+		case PORTD_ID:
+			PORTD = (PORTD & ~mask) | value;
+			break;
+		}
+		SREG = sreg;
+	}
+}
+
 /*
  * Description :
  * Read and return the value of the required port.
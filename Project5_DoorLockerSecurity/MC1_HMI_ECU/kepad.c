@@ -6,159 +6,287 @@
  *******************************************************************************/
 #include "keypad.h"
 #include "gpio.h"
-#include <util/delay.h>
+#include "hal.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
 /*******************************************************************************
- *                      Functions Prototypes(Private)                          *
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define KEYPAD_QUEUE_MASK                (KEYPAD_QUEUE_SIZE - 1)
+
+/* KEYPAD_tick calls between two scans */
+#define KEYPAD_SCAN_TICKS                (KEYPAD_SCAN_PERIOD_MS / KEYPAD_TICK_MS)
+
+/* Column bits after shifting the column port value by KEYPAD_FIRST_COL_PIN_ID */
+#define KEYPAD_COLS_MASK                 ((1 << KEYPAD_NUM_COLS) - 1)
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	KEYPAD_IDLE,				/* no key pressed */
+	KEYPAD_PRESS_DEBOUNCE,		/* a key is seen, waiting for it to be stable */
+	KEYPAD_HELD,				/* the key is pressed & its event is sent */
+	KEYPAD_RELEASE_DEBOUNCE		/* the key is not seen, waiting for it to be stable */
+}KEYPAD_StateType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
  *******************************************************************************/
 
-#ifndef STANDARD_KEYPAD
-#if (KEYPAD_NUM_COLS == 3)
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
+ * Key value of each switch, indexed by (row * KEYPAD_NUM_COLS) + col.
+ * It maps the switch number to its corresponding functional number in the proteus keypads.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
+static const uint8 g_keyMap[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] =
+{
+#ifdef STANDARD_KEYPAD
+	1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+#if (KEYPAD_NUM_COLS == 4)
+	13, 14, 15, 16
+#endif
+#elif (KEYPAD_NUM_COLS == 3)
+	1,   2, 3,
+	4,   5, 6,
+	7,   8, 9,
+	'*', 0, '#'				/* ASCII Codes of '*' & '#' */
 #elif (KEYPAD_NUM_COLS == 4)
+	7,  8, 9,   '%',		/* ASCII Code of '%' */
+	4,  5, 6,   '*',		/* ASCII Code of '*' */
+	1,  2, 3,   '-',		/* ASCII Code of '-' */
+	13, 0, '=', '+'			/* ASCII of Enter, ASCII Codes of '=' & '+' */
+#endif
+};
+
+/* index of the lowest set bit of a 4 bits value, the value 0 is not used */
+static const uint8 g_firstColumn[16] =
+{
+	0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+static volatile KEYPAD_EventType g_queue[KEYPAD_QUEUE_SIZE];
+static volatile uint8 g_queueHead = 0;		/* written by KEYPAD_tick */
+static volatile uint8 g_queueTail = 0;		/* written by KEYPAD_poll */
+
+/* debounce state machine, used only by KEYPAD_tick */
+static KEYPAD_StateType g_state = KEYPAD_IDLE;
+static uint8 g_key = KEYPAD_NO_KEY;			/* key being debounced or held */
+static uint8 g_stableScans = 0;
+static uint16 g_repeatTime = 0;				/* ms until the next repeat event */
+static uint8 g_scanTicks = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
+ * Description :
+ * Scan all the rows once and return the first pressed key or KEYPAD_NO_KEY.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
-#endif
+static uint8 KEYPAD_scan(void);
+
+/*
+ * Description :
+ * Add an event to the queue, the event is dropped if the queue is full.
+ */
+static void KEYPAD_pushEvent(uint8 key, KEYPAD_EventKindType kind);
 
-#endif /* STANDARD_KEYPAD */
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
 
-uint8 KEYPAD_getPressedKey(void)
+/*
+ * Description :
+ * Setup the keypad pins and empty the key events queue.
+ */
+void KEYPAD_init(void)
 {
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, PIN_INPUT);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, PIN_INPUT);
-#endif
-	while(1)
+	uint8 pin;
+	uint8 sreg = SREG;
+
+	/* all the keypad pins are inputs, the scan drives one row at a time */
+	for(pin = 0; pin < KEYPAD_NUM_ROWS; pin++)
+	{
+		GPIO_SETUP_PIN_DIRECTION(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+pin, PIN_INPUT);
+	}
+	for(pin = 0; pin < KEYPAD_NUM_COLS; pin++)
 	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+		GPIO_SETUP_PIN_DIRECTION(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+pin, PIN_INPUT);
+	}
+
+	cli();
+	g_queueHead = 0;
+	g_queueTail = 0;
+	g_state = KEYPAD_IDLE;
+	g_key = KEYPAD_NO_KEY;
+	g_scanTicks = 0;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Called every KEYPAD_TICK_MS from a timer ISR, scans the keypad every
+ * KEYPAD_SCAN_PERIOD_MS and adds the debounced events to the queue.
+ */
+void KEYPAD_tick(void)
+{
+	uint8 key;
+
+	g_scanTicks++;
+	if(g_scanTicks < KEYPAD_SCAN_TICKS)
+	{
+		return;
+	}
+	g_scanTicks = 0;
+
+	key = KEYPAD_scan();
+
+	switch(g_state)
+	{
+	case KEYPAD_IDLE:
+		if(key != KEYPAD_NO_KEY)
+		{
+			g_key = key;
+			g_stableScans = 1;
+			g_state = KEYPAD_PRESS_DEBOUNCE;
+		}
+		break;
+
+	case KEYPAD_PRESS_DEBOUNCE:
+		if(key != g_key)
+		{
+			/* bounce or another key, start again */
+			g_state = KEYPAD_IDLE;
+		}
+		else if(++g_stableScans >= KEYPAD_DEBOUNCE_SCANS)
+		{
+			KEYPAD_pushEvent(g_key, KEYPAD_PRESSED);
+			g_repeatTime = KEYPAD_REPEAT_DELAY_MS;
+			g_state = KEYPAD_HELD;
+		}
+		break;
+
+	case KEYPAD_HELD:
+		if(key != g_key)
+		{
+			g_stableScans = 1;
+			g_state = KEYPAD_RELEASE_DEBOUNCE;
+		}
+		else if(g_repeatTime > KEYPAD_SCAN_PERIOD_MS)
 		{
-			/*
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this row will be output pin
-			 */
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
-
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
-
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
-			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#elif (KEYPAD_NUM_COLS == 4)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#endif
-				}
-			}
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
-			_delay_ms(5); /* Add small delay to fix CPU load issue in proteus */
+			g_repeatTime -= KEYPAD_SCAN_PERIOD_MS;
 		}
+		else
+		{
+			KEYPAD_pushEvent(g_key, KEYPAD_REPEAT);
+			g_repeatTime = KEYPAD_REPEAT_RATE_MS;
+		}
+		break;
+
+	case KEYPAD_RELEASE_DEBOUNCE:
+		if(key == g_key)
+		{
+			/* it was a bounce, the key is still held */
+			g_state = KEYPAD_HELD;
+		}
+		else if(++g_stableScans >= KEYPAD_DEBOUNCE_SCANS)
+		{
+			KEYPAD_pushEvent(g_key, KEYPAD_RELEASED);
+			g_key = KEYPAD_NO_KEY;
+			g_state = KEYPAD_IDLE;
+		}
+		break;
 	}
 }
 
-#ifndef STANDARD_KEYPAD
-
-#if (KEYPAD_NUM_COLS == 3)
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
+ * Get the oldest key event without blocking.
+ * Return TRUE if an event is copied to event_ptr, FALSE if the queue is empty.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
+boolean KEYPAD_poll(KEYPAD_EventType *event_ptr)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 tail = g_queueTail;
+
+	if(tail == g_queueHead)
 	{
-		case 10: keypad_button = '*'; // ASCII Code of *
-				 break;
-		case 11: keypad_button = 0;
-				 break;
-		case 12: keypad_button = '#'; // ASCII Code of #
-				 break;
-		default: keypad_button = button_number;
-				break;
+		return FALSE;
 	}
-	return keypad_button;
-}
 
-#elif (KEYPAD_NUM_COLS == 4)
+	*event_ptr = g_queue[tail];
+	g_queueTail = (tail + 1) & KEYPAD_QUEUE_MASK;
+	return TRUE;
+}
 
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
+ * Wait for the next key press or repeat and return its key value.
+ * It needs KEYPAD_tick to be running.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
+uint8 KEYPAD_getPressedKey(void)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	KEYPAD_EventType event;
+
+	do
 	{
-		case 1: keypad_button = 7;
-				break;
-		case 2: keypad_button = 8;
-				break;
-		case 3: keypad_button = 9;
-				break;
-		case 4: keypad_button = '%'; // ASCII Code of %
-				break;
-		case 5: keypad_button = 4;
-				break;
-		case 6: keypad_button = 5;
-				break;
-		case 7: keypad_button = 6;
-				break;
-		case 8: keypad_button = '*'; /* ASCII Code of '*' */
-				break;
-		case 9: keypad_button = 1;
-				break;
-		case 10: keypad_button = 2;
-				break;
-		case 11: keypad_button = 3;
-				break;
-		case 12: keypad_button = '-'; /* ASCII Code of '-' */
-				break;
-		case 13: keypad_button = 13;  /* ASCII of Enter */
-				break;
-		case 14: keypad_button = 0;
-				break;
-		case 15: keypad_button = '='; /* ASCII Code of '=' */
-				break;
-		case 16: keypad_button = '+'; /* ASCII Code of '+' */
-				break;
-		default: keypad_button = button_number;
-				break;
-	}
-	return keypad_button;
+		while(KEYPAD_poll(&event) == FALSE){HAL_BUSY_WAIT();}
+	}while(event.kind == KEYPAD_RELEASED);
+
+	return event.key;
 }
 
+/*
+ * Description :
+ * Scan all the rows once and return the first pressed key or KEYPAD_NO_KEY.
+ */
+static uint8 KEYPAD_scan(void)
+{
+	uint8 row;
+	uint8 pressed_cols;
+
+	for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+	{
+		/*
+		 * Each time setup the direction for all keypad port as input pins,
+		 * except this row will be output pin
+		 */
+		GPIO_SETUP_PIN_DIRECTION(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
+		/* Set/Clear the row output pin */
+		GPIO_WRITE(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
+
+		/* read all the columns of this row at once, a set bit is a pressed switch */
+		pressed_cols = GPIO_READ_PORT(KEYPAD_COL_PORT_ID) >> KEYPAD_FIRST_COL_PIN_ID;
+#if(KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+		pressed_cols = ~pressed_cols;
 #endif
+		pressed_cols &= KEYPAD_COLS_MASK;
+
+		GPIO_SETUP_PIN_DIRECTION(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
 
-#endif /* STANDARD_KEYPAD */
+		if(pressed_cols != 0)
+		{
+			return g_keyMap[(row*KEYPAD_NUM_COLS) + g_firstColumn[pressed_cols]];
+		}
+	}
+	return KEYPAD_NO_KEY;
+}
+
+/*
+ * Description :
+ * Add an event to the queue, the event is dropped if the queue is full.
+ */
+static void KEYPAD_pushEvent(uint8 key, KEYPAD_EventKindType kind)
+{
+	uint8 head = g_queueHead;
+	uint8 next_head = (head + 1) & KEYPAD_QUEUE_MASK;
 
+	if(next_head != g_queueTail)
+	{
+		g_queue[head].key = key;
+		g_queue[head].kind = kind;
+		g_queueHead = next_head;
+	}
+}
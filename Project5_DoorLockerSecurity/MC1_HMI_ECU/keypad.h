@@ -29,13 +29,73 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
 #define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
 
+/* Time between two calls of KEYPAD_tick in ms */
+#define KEYPAD_TICK_MS                   1
+
+/* The whole keypad is scanned every KEYPAD_SCAN_PERIOD_MS */
+#define KEYPAD_SCAN_PERIOD_MS            5
+
+/* Number of equal scans needed to accept a press or a release */
+#define KEYPAD_DEBOUNCE_SCANS            4
+
+/* A held key repeats after KEYPAD_REPEAT_DELAY_MS then every KEYPAD_REPEAT_RATE_MS */
+#define KEYPAD_REPEAT_DELAY_MS           500
+#define KEYPAD_REPEAT_RATE_MS            200
+
+/* Max number of key events waiting for the application, should be power of 2 */
+#define KEYPAD_QUEUE_SIZE                8
+
+#if((KEYPAD_QUEUE_SIZE & (KEYPAD_QUEUE_SIZE - 1)) != 0)
+
+#error "Keypad queue size should be power of 2"
+
+#endif
+
+/* Returned by the scan when no key is pressed */
+#define KEYPAD_NO_KEY                    0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	KEYPAD_PRESSED, KEYPAD_RELEASED, KEYPAD_REPEAT
+}KEYPAD_EventKindType;
+
+typedef struct
+{
+	uint8 key;						/* key value after the keypad mapping */
+	KEYPAD_EventKindType kind;
+}KEYPAD_EventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Setup the keypad pins and empty the key events queue.
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Called every KEYPAD_TICK_MS from a timer ISR, scans the keypad every
+ * KEYPAD_SCAN_PERIOD_MS and adds the debounced events to the queue.
+ */
+void KEYPAD_tick(void);
+
+/*
+ * Description :
+ * Get the oldest key event without blocking.
+ * Return TRUE if an event is copied to event_ptr, FALSE if the queue is empty.
+ */
+boolean KEYPAD_poll(KEYPAD_EventType *event_ptr);
+
+/*
+ * Description :
+ * Wait for the next key press or repeat and return its key value.
+ * It needs KEYPAD_tick to be running.
  */
 uint8 KEYPAD_getPressedKey(void);
 
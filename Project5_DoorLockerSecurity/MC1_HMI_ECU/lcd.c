@@ -9,6 +9,103 @@
 #include "common_macros.h" /* For GET_BIT Macro */
 #include "lcd.h"
 #include "gpio.h"
+#include "hal.h"
+
+#ifdef LCD_ASYNC_MODE
+#include "timer2.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define LCD_QUEUE_MASK                 (LCD_QUEUE_SIZE - 1)
+
+/* Timer2 counts at F_CPU/8 = 1us at 8Mhz */
+#define LCD_TIMER_COMPARE_VALUE        ((uint8)(((F_CPU / 8) / 1000000UL) * LCD_TICK_US - 1))
+
+/* ticks skipped after clear & home, the next tick covers LCD_EXECUTION_TIME_US */
+#define LCD_LONG_WAIT_TICKS            ((LCD_CLEAR_EXECUTION_TIME_US + LCD_TICK_US - 1) / LCD_TICK_US - 1)
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 rs_value;		/* LOGIC_LOW for commands, LOGIC_HIGH for characters */
+	uint8 data;
+}LCD_OperationType;
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* TRUE after the data mode is set, the busy flag is not valid before that */
+static boolean g_busyFlagValid = FALSE;
+
+#ifdef LCD_ASYNC_MODE
+static volatile LCD_OperationType g_queue[LCD_QUEUE_SIZE];
+static volatile uint8 g_queueHead = 0;		/* written by the callers */
+static volatile uint8 g_queueTail = 0;		/* written by the ISR */
+
+/* TRUE after LCD_init, before that the operations are written directly */
+static boolean g_queueRunning = FALSE;
+
+/* TRUE while the Timer2 interrupt is enabled to drain the queue */
+static volatile boolean g_queueActive = FALSE;
+
+/* ticks to skip until the LCD finishes the last instruction */
+static volatile uint8 g_waitTicks = 0;
+
+/* Timer2 ticks every LCD_TICK_US, its interrupt is enabled only while the queue has operations */
+static const Timer2_ConfigType g_timer2Configuration = {0, LCD_TIMER_COMPARE_VALUE, TIMER2_F_CPU_8, TIMER2_CTC};
+#endif
+
+/*******************************************************************************
+ *                      Private Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Out the required nibble/byte on the data bus and latch it with an E pulse.
+ */
+static void LCD_latch(uint8 data);
+
+/*
+ * Description :
+ * Wait until the LCD finishes the last instruction:
+ * polls the busy flag in busy flag mode or waits the instruction execution time.
+ */
+static void LCD_waitReady(boolean long_instruction);
+
+/*
+ * Description :
+ * Send a command (RS=0) or a data byte (RS=1) to the LCD.
+ */
+static void LCD_sendByte(uint8 rs_value,uint8 data);
+
+#ifdef LCD_BUSY_FLAG_MODE
+/*
+ * Description :
+ * Read the busy flag once, returns LOGIC_HIGH while the LCD is busy.
+ */
+static uint8 LCD_readBusyFlag(void);
+#endif
+
+#ifdef LCD_ASYNC_MODE
+/*
+ * Description :
+ * Add an operation to the queue and start the Timer2 interrupt if it is stopped.
+ */
+static void LCD_enqueue(uint8 rs_value,uint8 data);
+
+/*
+ * Description :
+ * Called by Timer2 ISR every LCD_TICK_US to send the next queued operation.
+ */
+static void LCD_tick(void);
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
@@ -23,17 +120,31 @@
 void LCD_init(void)
 {
 	/* Configure the direction for RS and E pins as output pins */
-	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+
+#ifdef LCD_ASYNC_MODE
+	/* write the initialization commands directly */
+	g_queueRunning = FALSE;
+#endif
+
+#ifdef LCD_BUSY_FLAG_MODE
+	/* Configure the direction for RW pin as output pin, write mode by default */
+	GPIO_SETUP_PIN_DIRECTION(LCD_RW_PORT_ID,LCD_RW_PIN_ID,PIN_OUTPUT);
+	GPIO_WRITE(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW);
+#endif
+
+	/* the busy flag can't be read before the data mode is set */
+	g_busyFlagValid = FALSE;
 
 	_delay_ms(20);		/* LCD Power ON delay always > 15ms */
 
 #if(LCD_DATA_BITS_MODE == 4)
 	/* Configure 4 pins in the data port as output pins */
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
 
 	/* Send for 4 bit initialization of LCD  */
 	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INIT1);
@@ -44,15 +155,29 @@ void LCD_init(void)
 
 #elif(LCD_DATA_BITS_MODE == 8)
 	/* Configure the data port as output port */
-	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+	GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_OUTPUT);
 
 	/* use 2-lines LCD + 8-bits Data Mode + 5*7 dot display Mode */
 	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE);
 
 #endif
 
+	/* the data mode is set, from now on the busy flag is valid */
+	g_busyFlagValid = TRUE;
+
 	LCD_sendCommand(LCD_CURSOR_OFF); /* cursor off */
 	LCD_sendCommand(LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
+
+#ifdef LCD_ASYNC_MODE
+	/* from now on the operations are queued & sent by Timer2 ISR */
+	g_queueHead = 0;
+	g_queueTail = 0;
+	g_waitTicks = 0;
+	g_queueActive = FALSE;
+	Timer2_setCallBack(LCD_tick);
+	Timer2_init(&g_timer2Configuration);
+	g_queueRunning = TRUE;
+#endif
 }
 
 /*
@@ -61,38 +186,16 @@ void LCD_init(void)
  */
 void LCD_sendCommand(uint8 command)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,command); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+#ifdef LCD_ASYNC_MODE
+	if(g_queueRunning == TRUE)
+	{
+		LCD_enqueue(LOGIC_LOW,command);
+		return;
+	}
 #endif
+	LCD_sendByte(LOGIC_LOW,command); /* Instruction Mode RS=0 */
+	/* clear & home take about 1.52ms, the other instructions about 37us */
+	LCD_waitReady((command == LCD_CLEAR_COMMAND) || (command == LCD_GO_TO_HOME));
 }
 
 /*
@@ -101,38 +204,15 @@ void LCD_sendCommand(uint8 command)
  */
 void LCD_displayCharacter(uint8 data)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data Mode RS=1 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,data); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+#ifdef LCD_ASYNC_MODE
+	if(g_queueRunning == TRUE)
+	{
+		LCD_enqueue(LOGIC_HIGH,data);
+		return;
+	}
 #endif
+	LCD_sendByte(LOGIC_HIGH,data); /* Data Mode RS=1 */
+	LCD_waitReady(FALSE);
 }
 
 /*
@@ -162,26 +242,11 @@ void LCD_displayString(const char *Str)
  */
 void LCD_moveCursor(uint8 row,uint8 col)
 {
-	uint8 lcd_memory_address;
+	/* Address of the first column of each row in the LCD DDRAM */
+	static const uint8 row_address[4] = {LCD_ROW0_ADDRESS, LCD_ROW1_ADDRESS, LCD_ROW2_ADDRESS, LCD_ROW3_ADDRESS};
 
-	/* Calculate the required address in the LCD DDRAM */
-	switch(row)
-	{
-		case 0:
-			lcd_memory_address=col;
-				break;
-		case 1:
-			lcd_memory_address=col+0x40;
-				break;
-		case 2:
-			lcd_memory_address=col+0x10;
-				break;
-		case 3:
-			lcd_memory_address=col+0x50;
-				break;
-	}
-	/* Move the LCD cursor to this specific address */
-	LCD_sendCommand(lcd_memory_address | LCD_SET_CURSOR_LOCATION);
+	/* Move the LCD cursor to the required address in the LCD DDRAM */
+	LCD_sendCommand((row_address[row & 0x03] + col) | LCD_SET_CURSOR_LOCATION);
 }
 
 /*
@@ -213,3 +278,224 @@ void LCD_clearScreen(void)
 {
 	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Send clear display command */
 }
+
+/*
+ * Description :
+ * Return TRUE when all the queued operations are sent and executed by the LCD.
+ * Always TRUE if the async mode is disabled.
+ */
+boolean LCD_isIdle(void)
+{
+#ifdef LCD_ASYNC_MODE
+	return (g_queueActive == FALSE);
+#else
+	return TRUE;
+#endif
+}
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Out the required nibble/byte on the data bus and latch it with an E pulse.
+ * all the setup and hold times of the LCD are below 1us.
+ */
+static void LCD_latch(uint8 data)
+{
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	_delay_us(1); /* delay for processing Tpw - Tdws = 190ns */
+
+#if(LCD_DATA_BITS_MODE == 4)
+	/* the 4 data pins change together in one store */
+	GPIO_writeMasked(LCD_DATA_PORT_ID,LCD_DATA_PINS_MASK,
+			(GET_BIT(data,0) << LCD_DB4_PIN_ID) | (GET_BIT(data,1) << LCD_DB5_PIN_ID) |
+			(GET_BIT(data,2) << LCD_DB6_PIN_ID) | (GET_BIT(data,3) << LCD_DB7_PIN_ID));
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_WRITE_PORT(LCD_DATA_PORT_ID,data); /* out the required data to the data bus D0 --> D7 */
+#endif
+
+	_delay_us(1); /* delay for processing Tdsw = 100ns */
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
+	_delay_us(1); /* delay for processing Th = 13ns */
+}
+
+/*
+ * Description :
+ * Send a command (RS=0) or a data byte (RS=1) to the LCD.
+ */
+static void LCD_sendByte(uint8 rs_value,uint8 data)
+{
+	GPIO_WRITE(LCD_RS_PORT_ID,LCD_RS_PIN_ID,rs_value);
+	_delay_us(1); /* delay for processing Tas = 50ns */
+
+#if(LCD_DATA_BITS_MODE == 4)
+	LCD_latch(data >> 4); /* the high nibble first */
+	LCD_latch(data & 0x0F);
+#elif(LCD_DATA_BITS_MODE == 8)
+	LCD_latch(data);
+#endif
+}
+
+/*
+ * Description :
+ * Wait until the LCD finishes the last instruction:
+ * polls the busy flag in busy flag mode or waits the instruction execution time.
+ * Before the data mode is set the busy flag is not valid so the worst case time is used.
+ */
+static void LCD_waitReady(boolean long_instruction)
+{
+#ifdef LCD_BUSY_FLAG_MODE
+	uint16 trials = 0;
+
+	if(g_busyFlagValid == FALSE)
+	{
+		_delay_us(LCD_CLEAR_EXECUTION_TIME_US);
+		return;
+	}
+
+	/* poll the busy flag */
+	while((LCD_readBusyFlag() == LOGIC_HIGH) && (trials < LCD_BUSY_FLAG_TRIALS))
+	{
+		trials++;
+	}
+
+#elif defined(LCD_TIMED_MODE)
+	if((g_busyFlagValid == FALSE) || (long_instruction == TRUE))
+	{
+		_delay_us(LCD_CLEAR_EXECUTION_TIME_US);
+	}
+	else
+	{
+		_delay_us(LCD_EXECUTION_TIME_US);
+	}
+#endif
+}
+
+#ifdef LCD_BUSY_FLAG_MODE
+/*
+ * Description :
+ * Read the busy flag once, returns LOGIC_HIGH while the LCD is busy.
+ */
+static uint8 LCD_readBusyFlag(void)
+{
+	uint8 busy;
+
+	/* Configure the data pins as input pins to read back the LCD */
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_INPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_INPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_INPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_INPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_INPUT);
+#endif
+
+	GPIO_WRITE(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
+	GPIO_WRITE(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_HIGH); /* Read Mode RW=1 */
+	_delay_us(1); /* delay for processing Tas = 50ns */
+
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	_delay_us(1); /* delay for processing Tddr = 160ns */
+	busy = GPIO_READ(LCD_DATA_PORT_ID,LCD_BUSY_FLAG_PIN_ID);
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
+	_delay_us(1);
+
+#if(LCD_DATA_BITS_MODE == 4)
+	/* the low nibble holds the address counter, just clock it out */
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH);
+	_delay_us(1);
+	GPIO_WRITE(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW);
+	_delay_us(1);
+#endif
+
+	GPIO_WRITE(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW); /* Write Mode RW=0 */
+
+	/* Configure the data pins as output pins again */
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,PORT_OUTPUT);
+#endif
+
+	return busy;
+}
+#endif
+
+#ifdef LCD_ASYNC_MODE
+/*
+ * Description :
+ * Add an operation to the queue and start the Timer2 interrupt if it is stopped.
+ */
+static void LCD_enqueue(uint8 rs_value,uint8 data)
+{
+	uint8 sreg;
+	uint8 next_head = (g_queueHead + 1) & LCD_QUEUE_MASK;
+
+	/* the queue is full, wait for the ISR to send one operation */
+	while(next_head == g_queueTail){HAL_BUSY_WAIT();}
+
+	g_queue[g_queueHead].rs_value = rs_value;
+	g_queue[g_queueHead].data = data;
+	g_queueHead = next_head;
+
+	/* start draining only if stopped, enabling again would delay the next tick */
+	sreg = SREG;
+	cli();
+	if(g_queueActive == FALSE)
+	{
+		g_queueActive = TRUE;
+		Timer2_enableInterrupt();
+	}
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Called by Timer2 ISR every LCD_TICK_US to send the next queued operation.
+ */
+static void LCD_tick(void)
+{
+	uint8 tail;
+
+	if(g_waitTicks > 0)
+	{
+		/* the LCD is still executing a clear or home */
+		g_waitTicks--;
+		return;
+	}
+
+	tail = g_queueTail;
+	if(tail == g_queueHead)
+	{
+		/* nothing to send and the last instruction is done */
+		Timer2_disableInterrupt();
+		g_queueActive = FALSE;
+		return;
+	}
+
+#ifdef LCD_BUSY_FLAG_MODE
+	if(LCD_readBusyFlag() == LOGIC_HIGH)
+	{
+		/* try again next tick */
+		return;
+	}
+#endif
+
+	LCD_sendByte(g_queue[tail].rs_value,g_queue[tail].data);
+
+#ifdef LCD_TIMED_MODE
+	if((g_queue[tail].rs_value == LOGIC_LOW) &&
+			((g_queue[tail].data == LCD_CLEAR_COMMAND) || (g_queue[tail].data == LCD_GO_TO_HOME)))
+	{
+		g_waitTicks = LCD_LONG_WAIT_TICKS;
+	}
+#endif
+
+	g_queueTail = (tail + 1) & LCD_QUEUE_MASK;
+}
+#endif
@@ -22,6 +22,66 @@
 
 #endif
 
+/*
+ * LCD timing mode configuration:
+ * LCD_BUSY_FLAG_MODE : the RW pin is wired, the driver reads back the busy flag (DB7)
+ *                      and writes the next byte as soon as the LCD is ready.
+ * LCD_TIMED_MODE     : the RW pin is tied to ground, the driver waits the worst case
+ *                      execution time of each instruction in microseconds.
+ */
+#define LCD_TIMED_MODE
+#undef LCD_BUSY_FLAG_MODE
+
+#if(defined(LCD_TIMED_MODE) && defined(LCD_BUSY_FLAG_MODE))
+
+#error "Choose only one LCD timing mode"
+
+#endif
+
+/* Execution times of the LCD instructions in micro seconds */
+#define LCD_EXECUTION_TIME_US          40
+#define LCD_CLEAR_EXECUTION_TIME_US    1600
+
+/* Max number of busy flag reads before giving up on the LCD */
+#define LCD_BUSY_FLAG_TRIALS           2000
+
+/*
+ * LCD async mode: the LCD commands & characters are queued and a Timer2 compare
+ * ISR clocks them out one bus cycle every LCD_TICK_US, so the callers never wait
+ * for the LCD. Comment it to write the LCD directly from the caller context.
+ */
+#define LCD_ASYNC_MODE
+
+#ifdef LCD_ASYNC_MODE
+/* Max number of queued operations, should be power of 2 and up to 128 */
+#define LCD_QUEUE_SIZE                 64
+
+#if((LCD_QUEUE_SIZE & (LCD_QUEUE_SIZE - 1)) != 0) || (LCD_QUEUE_SIZE > 128)
+
+#error "LCD queue size should be power of 2 and up to 128"
+
+#endif
+
+/* Time between two ISR calls in micro seconds, should cover LCD_EXECUTION_TIME_US */
+#define LCD_TICK_US                    50
+#endif
+
+/* LCD size configuration, up to 4 rows x 20 columns */
+#define LCD_ROWS                       2
+#define LCD_COLUMNS                    16
+
+#if((LCD_ROWS > 4) || (LCD_COLUMNS > 20))
+
+#error "The LCD size should be up to 4 rows x 20 columns"
+
+#endif
+
+/* DDRAM address of the first column in each row, rows 2 & 3 continue rows 0 & 1 */
+#define LCD_ROW0_ADDRESS               0x00
+#define LCD_ROW1_ADDRESS               0x40
+#define LCD_ROW2_ADDRESS               (LCD_ROW0_ADDRESS + LCD_COLUMNS)
+#define LCD_ROW3_ADDRESS               (LCD_ROW1_ADDRESS + LCD_COLUMNS)
+
 /* LCD HW Ports and Pins Ids */
 #define LCD_RS_PORT_ID                 PORTA_ID
 #define LCD_RS_PIN_ID                  PIN1_ID
@@ -29,7 +89,13 @@
 #define LCD_E_PORT_ID                  PORTA_ID
 #define LCD_E_PIN_ID                   PIN2_ID
 
+#ifdef LCD_BUSY_FLAG_MODE
+#define LCD_RW_PORT_ID                 PORTA_ID
+#define LCD_RW_PIN_ID                  PIN0_ID
+#endif
+
 #define LCD_DATA_PORT_ID               PORTB_ID
+#define LCD_BUSY_FLAG_PIN_ID           PIN7_ID
 
 #if (LCD_DATA_BITS_MODE == 4)
 
@@ -38,6 +104,13 @@
 #define LCD_DB6_PIN_ID                 PIN5_ID
 #define LCD_DB7_PIN_ID                 PIN6_ID
 
+/* the 4 data pins in the data port */
+#define LCD_DATA_PINS_MASK             ((1 << LCD_DB4_PIN_ID) | (1 << LCD_DB5_PIN_ID) | \
+                                        (1 << LCD_DB6_PIN_ID) | (1 << LCD_DB7_PIN_ID))
+
+#undef  LCD_BUSY_FLAG_PIN_ID
+#define LCD_BUSY_FLAG_PIN_ID           LCD_DB7_PIN_ID
+
 #endif
 
 /* LCD Commands */
@@ -66,12 +139,16 @@ void LCD_init(void);
 /*
  * Description :
  * Send the required command to the screen
+ * In async mode the command is queued, it waits only if the queue is full so
+ * it shouldn't be called with the interrupts disabled.
  */
 void LCD_sendCommand(uint8 command);
 
 /*
  * Description :
  * Display the required character on the screen
+ * In async mode the character is queued, it waits only if the queue is full so
+ * it shouldn't be called with the interrupts disabled.
  */
 void LCD_displayCharacter(uint8 data);
 
@@ -105,4 +182,11 @@ void LCD_intgerToString(int data);
  */
 void LCD_clearScreen(void);
 
+/*
+ * Description :
+ * Return TRUE when all the queued operations are sent and executed by the LCD.
+ * Always TRUE if the async mode is disabled.
+ */
+boolean LCD_isIdle(void);
+
 #endif /* LCD_H_ */
@@ -0,0 +1,175 @@
+ /******************************************************************************
+ * Module: LCD Buffer
+ * File Name: lcd_buffer.c
+ * Description: Source file for the LCD shadow framebuffer on top of the LCD driver
+ * Author: Yousif Adel
+ *******************************************************************************/
+
+#include "lcd_buffer.h"
+#include "profiler.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define LCD_BUFFER_BLANK               ' '
+
+/* the LCD cursor position is not known, the next write needs a cursor move */
+#define LCD_BUFFER_UNKNOWN_COLUMN      0xFF
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* what the application wants to show */
+static uint8 g_shadow[LCD_ROWS][LCD_COLUMNS];
+
+/* what the LCD is showing now */
+static uint8 g_glass[LCD_ROWS][LCD_COLUMNS];
+
+/* one bit per row changed since the last flush */
+static uint8 g_dirtyRows = 0;
+
+/* framebuffer cursor */
+static uint8 g_row = 0;
+static uint8 g_col = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the LCD driver and the framebuffer, both start as a blank screen.
+ */
+void LCD_bufferInit(void)
+{
+	uint8 row;
+	uint8 col;
+
+	/* LCD_init clears the LCD at the end */
+	LCD_init();
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLUMNS; col++)
+		{
+			g_shadow[row][col] = LCD_BUFFER_BLANK;
+			g_glass[row][col] = LCD_BUFFER_BLANK;
+		}
+	}
+	g_dirtyRows = 0;
+	g_row = 0;
+	g_col = 0;
+}
+
+/*
+ * Description :
+ * Clear the framebuffer and move its cursor to the first row and column.
+ * The LCD itself is not touched until LCD_flush.
+ */
+void LCD_bufferClear(void)
+{
+	uint8 row;
+	uint8 col;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLUMNS; col++)
+		{
+			g_shadow[row][col] = LCD_BUFFER_BLANK;
+		}
+	}
+	g_dirtyRows = (1 << LCD_ROWS) - 1;
+	g_row = 0;
+	g_col = 0;
+}
+
+/*
+ * Description :
+ * Move the framebuffer cursor to a specified row and column index
+ */
+void LCD_bufferMoveCursor(uint8 row,uint8 col)
+{
+	g_row = row;
+	g_col = col;
+}
+
+/*
+ * Description :
+ * Write the required character in the framebuffer at the cursor position.
+ * Characters beyond the last column of the row are dropped.
+ */
+void LCD_bufferDisplayCharacter(uint8 data)
+{
+	if((g_row < LCD_ROWS) && (g_col < LCD_COLUMNS))
+	{
+		if(g_shadow[g_row][g_col] != data)
+		{
+			g_shadow[g_row][g_col] = data;
+			g_dirtyRows |= (1 << g_row);
+		}
+		g_col++;
+	}
+}
+
+/*
+ * Description :
+ * Write the required string in the framebuffer at the cursor position
+ */
+void LCD_bufferDisplayString(const char *Str)
+{
+	while((*Str) != '\0')
+	{
+		LCD_bufferDisplayCharacter(*Str);
+		Str++;
+	}
+}
+
+/*
+ * Description :
+ * Write the required string in the framebuffer in a specified row and column index
+ */
+void LCD_bufferDisplayStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	LCD_bufferMoveCursor(row,col); /* go to to the required position */
+	LCD_bufferDisplayString(Str); /* write the string */
+}
+
+/*
+ * Description :
+ * Send to the LCD only the characters that differ from what it is showing,
+ * with a cursor move only where the changed characters are not contiguous.
+ */
+void LCD_flush(void)
+{
+	uint8 row;
+	uint8 col;
+	uint8 lcd_col;		/* column of the LCD cursor in this row */
+
+	PROF_BEGIN(PROF_LCD_FLUSH);
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		if(!(g_dirtyRows & (1 << row)))
+		{
+			continue;
+		}
+
+		lcd_col = LCD_BUFFER_UNKNOWN_COLUMN;
+		for(col = 0; col < LCD_COLUMNS; col++)
+		{
+			if(g_shadow[row][col] != g_glass[row][col])
+			{
+				/* the LCD increments its cursor after each character */
+				if(lcd_col != col)
+				{
+					LCD_moveCursor(row,col);
+				}
+				LCD_displayCharacter(g_shadow[row][col]);
+				g_glass[row][col] = g_shadow[row][col];
+				lcd_col = col + 1;
+			}
+		}
+	}
+	g_dirtyRows = 0;
+	PROF_END(PROF_LCD_FLUSH);
+}
@@ -0,0 +1,62 @@
+ /******************************************************************************
+ * Module: LCD Buffer
+ * File Name: lcd_buffer.h
+ * Description: Header file for the LCD shadow framebuffer on top of the LCD driver
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef LCD_BUFFER_H_
+#define LCD_BUFFER_H_
+
+#include "std_types.h"
+#include "lcd.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the LCD driver and the framebuffer, both start as a blank screen.
+ */
+void LCD_bufferInit(void);
+
+/*
+ * Description :
+ * Clear the framebuffer and move its cursor to the first row and column.
+ * The LCD itself is not touched until LCD_flush.
+ */
+void LCD_bufferClear(void);
+
+/*
+ * Description :
+ * Move the framebuffer cursor to a specified row and column index
+ */
+void LCD_bufferMoveCursor(uint8 row,uint8 col);
+
+/*
+ * Description :
+ * Write the required character in the framebuffer at the cursor position.
+ * Characters beyond the last column of the row are dropped.
+ */
+void LCD_bufferDisplayCharacter(uint8 data);
+
+/*
+ * Description :
+ * Write the required string in the framebuffer at the cursor position
+ */
+void LCD_bufferDisplayString(const char *Str);
+
+/*
+ * Description :
+ * Write the required string in the framebuffer in a specified row and column index
+ */
+void LCD_bufferDisplayStringRowColumn(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Send to the LCD only the characters that differ from what it is showing,
+ * with a cursor move only where the changed characters are not contiguous.
+ */
+void LCD_flush(void);
+
+#endif /* LCD_BUFFER_H_ */
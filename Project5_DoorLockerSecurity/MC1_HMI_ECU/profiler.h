@@ -0,0 +1,84 @@
+ /******************************************************************************
+ * Module: Profiler
+ * File Name: profiler.h
+ * Description: Header file for the code sections profiler, the time is taken from
+ *              the scheduler tick count & the Timer1 counter in CPU cycles
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include	"std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* Remove to compile out the profiler, PROF_BEGIN & PROF_END become empty */
+#define PROFILER_ENABLE
+
+/* CPU cycles per Timer1 count, the Timer1 prescaler of the scheduler tick */
+#define PROFILER_TIMER1_PRESCALER		1
+
+/* Bytes of one section in the PROFILER_DATA frame */
+#define PROFILER_DATA_SIZE				19
+
+#ifdef PROFILER_ENABLE
+/*
+ * Measure the code between PROF_BEGIN(id) & PROF_END(id), they may be in different
+ * functions but a section can't be nested in itself. The interrupts must not be
+ * disabled for more than a tick inside the section.
+ */
+#define PROF_BEGIN(ID)					PROFILER_begin(ID)
+#define PROF_END(ID)					PROFILER_end(ID)
+#else
+#define PROF_BEGIN(ID)
+#define PROF_END(ID)
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* Measured sections of both ECUs */
+typedef enum
+{
+	PROF_RESPONSE_PROCESSES,	/* MC2: handling of one received frame */
+	PROF_EEPROM_WRITE,			/* MC2: password page write including the write cycle */
+	PROF_EEPROM_READ,			/* MC2: background read of the saved password */
+	PROF_LCD_FLUSH,				/* MC1: framebuffer flush to the LCD queue */
+	PROF_PIN_HASH,				/* MC2: digest of the entered password */
+	PROF_SECTIONS
+}PROFILER_SectionType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the sections statistics, it should be called after Timer1_init.
+ */
+void PROFILER_init(void);
+
+/*
+ * Description :
+ * CPU cycles since the scheduler started, modulo 2^32.
+ */
+uint32 PROFILER_now(void);
+
+/*
+ * Description :
+ * Start & end one run of the section, the end adds the run to the section min,
+ * max, sum & count.
+ */
+void PROFILER_begin(PROFILER_SectionType section);
+void PROFILER_end(PROFILER_SectionType section);
+
+/*
+ * Description :
+ * Send the statistics of each measured section in a PROFILER_DATA frame
+ * [id, count (2 bytes), min, max (4 bytes), sum (8 bytes), low byte first],
+ * the dump ends with an empty PROFILER_DATA frame.
+ */
+void PROFILER_dump(void);
+
+#endif /* PROFILER_H_ */
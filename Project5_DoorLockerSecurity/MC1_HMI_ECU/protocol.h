@@ -0,0 +1,104 @@
+ /******************************************************************************
+ * Module: Protocol
+ * File Name: protocol.h
+ * Description: Header file for the framed UART protocol between MC1 & MC2
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include	"std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * Frame Format:
+ * 	| START | COMMAND | LENGTH | PAYLOAD[LENGTH] | CRC-8 |
+ * The CRC-8 is calculated over the COMMAND, LENGTH and PAYLOAD bytes.
+ */
+#define PROTOCOL_START_BYTE				0x7E
+#define PROTOCOL_MAX_PAYLOAD			32
+
+/*
+ * A request is sent again when its answer doesn't come in PROTOCOL_REPLY_TIMEOUT_MS, a frame
+ * dropped for its CRC isn't sent again by the other ECU. A frame waiting for its next byte
+ * longer than PROTOCOL_BYTE_TIMEOUT_MS lost the rest of its bytes, it is dropped.
+ */
+#define PROTOCOL_REPLY_TIMEOUT_MS		500
+#define PROTOCOL_REQUEST_TRIES			3
+#define PROTOCOL_BYTE_TIMEOUT_MS		100
+
+/* UART Commands Between MC1 & MC2 */
+#define MC1_READY 						0x01	// MC1 is ready
+#define SAVE_PASSWORD 					0x04	// save the password [payload: password]
+#define PASSWORD_SAVED					0x05	// password has been saved
+#define PASSWORD_SAVE_FAILED			0x06	// password couldn't be saved, the previous one is still used
+#define PASSWORD_CHECK					0x07	// check if the password correct [payload: password]
+#define PASSWORD_DOESNT_MATCH			0x08	// password WRONG
+#define PASSWORD_MATCH					0x09	// password correct
+#define BUZZER_ON_BYTE					0x11	// turn the buzzer on	[buzzer sequence]
+#define UNLOCK_THE_DOOR					0x12	// open the door [door sequence]
+#define DOOR_STATUS_REQUEST				0x14	// ask MC2 about the door & buzzer state
+#define DOOR_STATUS						0x15	// door & buzzer state [payload: PROTOCOL_DoorStateType, buzzer on/off, unlock & lock travel ms (2 bytes each, low byte first)]
+#define EMERGENCY_LOCK					0x16	// stop the door sequence and lock the door now
+#define PROFILER_DUMP					0x18	// send the profiler statistics, answered by the protocol layer
+#define PROFILER_DATA					0x19	// statistics of one section [payload: see profiler.h], empty at the end
+#define CREDENTIAL_ADD					0x1A	// add a PIN holder [payload: PIN]
+#define CREDENTIAL_REMOVE				0x1B	// remove a PIN holder [payload: id]
+#define CREDENTIAL_LIST					0x1C	// ask for the ids of the PIN holders
+#define CREDENTIAL_RESULT				0x1D	// answer of add & remove [payload: CREDENTIAL_StatusType, id]
+#define CREDENTIAL_LIST_DATA			0x1E	// PIN holders [payload: count, bitmap of the used ids]
+#define CREDENTIAL_FILTER_INFO			0x1F	// ask for the state of the PIN holders Bloom filter
+#define CREDENTIAL_FILTER_DATA			0x20	// Bloom filter state [payload: bits, hashes, bits set, entries, false positive rate in 1/65536, rejected & false positive lookups (2 bytes each, low byte first, but hashes & entries)]
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 command;
+	uint8 length;
+	uint8 payload[PROTOCOL_MAX_PAYLOAD];
+}PROTOCOL_FrameType;
+
+/* Door states reported in the DOOR_STATUS frame */
+typedef enum
+{
+	DOOR_LOCKED, DOOR_UNLOCKING, DOOR_OPEN, DOOR_LOCKING
+}PROTOCOL_DoorStateType;
+
+typedef enum
+{
+	PROTOCOL_NO_FRAME, PROTOCOL_FRAME_READY, PROTOCOL_CRC_ERROR, PROTOCOL_TIMEOUT
+}PROTOCOL_StatusType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Send one frame with the required command and payload through UART.
+ */
+void PROTOCOL_sendFrame(uint8 command, const uint8 *payload, uint8 length);
+
+/*
+ * Description :
+ * Consume the received UART bytes without waiting.
+ * Return: PROTOCOL_FRAME_READY when a complete valid frame is stored in frame,
+ * PROTOCOL_CRC_ERROR when a corrupted frame is dropped, otherwise PROTOCOL_NO_FRAME.
+ */
+PROTOCOL_StatusType PROTOCOL_poll(PROTOCOL_FrameType *frame);
+
+/*
+ * Description :
+ * Send the request and wait for one of its two answers, the other frames are dropped.
+ * The request is sent again when no answer comes in PROTOCOL_REPLY_TIMEOUT_MS, it is
+ * sent PROTOCOL_REQUEST_TRIES times at most. The scheduler should be ticking.
+ * Return: PROTOCOL_FRAME_READY when the answer is stored in frame, otherwise PROTOCOL_TIMEOUT.
+ */
+PROTOCOL_StatusType PROTOCOL_request(uint8 command, const uint8 *payload, uint8 length,
+		uint8 reply, uint8 other_reply, PROTOCOL_FrameType *frame);
+
+#endif /* PROTOCOL_H_ */
@@ -8,6 +8,7 @@
 #define TIMER1_H_
 
 #include	"std_types.h"
+#include	"hal.h"
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -183,14 +184,14 @@ typedef union {
 /******************************************************************************/
 
 /*********************************** Timer1 Registers Definitions *************/
-#define TCNT1_REG     (*(volatile Timer1_TCNT1_Type*)0x4C)
-#define TCCR1A_REG    (*(volatile Timer1_TCCR1A_Type*)0x4F)
-#define TCCR1B_REG    (*(volatile Timer1_TCCR1B_Type*)0x4E)
-#define TIFR_REG      (*(volatile Timers_TIFR_Type*)0x58)
-#define TIMSK_REG     (*(volatile Timers_TIMSK_Type*)0x59)
-#define OCR1A_REG     (*(volatile Timer1_OCR1A_Type*)0x4A)
-#define OCR1B_REG     (*(volatile Timer1_OCR1B_Type*)0x48)
-#define ICR1_REG      (*(volatile Timer1_ICR1_Type*)0x46)
+#define TCNT1_REG     (*(volatile Timer1_TCNT1_Type*)HAL_IO_ADDRESS(0x4C))
+#define TCCR1A_REG    (*(volatile Timer1_TCCR1A_Type*)HAL_IO_ADDRESS(0x4F))
+#define TCCR1B_REG    (*(volatile Timer1_TCCR1B_Type*)HAL_IO_ADDRESS(0x4E))
+#define TIFR_REG      (*(volatile Timers_TIFR_Type*)HAL_IO_ADDRESS(0x58))
+#define TIMSK_REG     (*(volatile Timers_TIMSK_Type*)HAL_IO_ADDRESS(0x59))
+#define OCR1A_REG     (*(volatile Timer1_OCR1A_Type*)HAL_IO_ADDRESS(0x4A))
+#define OCR1B_REG     (*(volatile Timer1_OCR1B_Type*)HAL_IO_ADDRESS(0x48))
+#define ICR1_REG      (*(volatile Timer1_ICR1_Type*)HAL_IO_ADDRESS(0x46))
 
 /*******************************************************************************
  *                         Types Declaration                                   *
@@ -0,0 +1,129 @@
+ /******************************************************************************
+ * Module: TIMER 2
+ * File Name: timer2.c
+ * Description: Source file for the AVR TIMER 2 driver
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"timer2.h"
+#include	<avr/interrupt.h>
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Global variables to hold the address of the call back function in the application */
+static void (*volatile g_callBackPtr)(void) = NULL_PTR;
+
+/* mode of the timer, to know which interrupt to enable */
+static Timer2_Mode g_mode = TIMER2_NORMAL;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+ISR(TIMER2_COMP_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application on the compare match */
+		(*g_callBackPtr)();
+	}
+}
+
+ISR(TIMER2_OVF_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application on the overflow */
+		(*g_callBackPtr)();
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+/*
+● Description:
+  	  ⮚ Function to initialize the Timer driver, the interrupt stays disabled
+  	    until Timer2_enableInterrupt is called.
+● Inputs: pointer to the configuration structure with type Timer2_ConfigType.
+● Return: None
+ */
+void Timer2_init(const Timer2_ConfigType * Config_Ptr)
+{
+	g_mode = Config_Ptr->mode;
+
+	/* 1. Set timer2 initial count & compare value */
+	TCNT2_REG = Config_Ptr->initial_value;
+	OCR2_REG = Config_Ptr->compare_value;
+
+	/* 2. Non PWM mode FOC2=1, OC2 disconnected */
+	TCCR2_REG.Byte = 0;
+	TCCR2_REG.Bits.FOC2_Bit = 1;
+
+	/* 3. Set the mode using WGM20, WGM21 */
+	TCCR2_REG.Bits.WGM20_Bit = ((Config_Ptr->mode) & 0x01);
+	TCCR2_REG.Bits.WGM21_Bit = (((Config_Ptr->mode) & 0x02) >> 1);
+
+	/* 4. set the Pre-Scalar*/
+	TCCR2_REG.Bits.CS20_Bit = ((Config_Ptr->prescaler) & 0x01);
+	TCCR2_REG.Bits.CS21_Bit = (((Config_Ptr->prescaler) & 0x02) >> 1);
+	TCCR2_REG.Bits.CS22_Bit = (((Config_Ptr->prescaler) & 0x04) >> 2);
+
+	Timer2_disableInterrupt();
+}
+
+/*
+● Description:
+	⮚ Function to disable the Timer2.
+● Inputs: None
+● Return: None
+ */
+void Timer2_deInit(void)
+{
+	Timer2_disableInterrupt();
+	/* Clear Timer2 Registers */
+	TCCR2_REG.Byte = 0;
+}
+
+/*
+● Description:
+	⮚ Function to enable the interrupt of the configured mode (overflow or compare).
+● Inputs: None
+● Return: None
+ */
+void Timer2_enableInterrupt(void)
+{
+	if(g_mode == TIMER2_CTC)
+	{
+		/* clear an old compare match so the first interrupt is a full period later */
+		TIFR_REG.Byte = (1 << 7);
+		TIMSK_REG.Bits.OCIE2_Bit = 1;
+	}
+	else
+	{
+		TIFR_REG.Byte = (1 << 6);
+		TIMSK_REG.Bits.TOIE2_Bit = 1;
+	}
+}
+
+/*
+● Description:
+	⮚ Function to disable the Timer2 interrupts, the timer keeps counting.
+● Inputs: None
+● Return: None
+ */
+void Timer2_disableInterrupt(void)
+{
+	TIMSK_REG.Bits.OCIE2_Bit = 0;
+	TIMSK_REG.Bits.TOIE2_Bit = 0;
+}
+
+/*
+● Description:
+	⮚ Function to set the Call Back function address.
+● Inputs: pointer to Call Back function.
+● Return: None
+ */
+void Timer2_setCallBack(void(*a_ptr)(void))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
@@ -0,0 +1,102 @@
+ /******************************************************************************
+ * Module: TIMER 2
+ * File Name: timer2.h
+ * Description: Header file for the AVR TIMER 2 driver
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef TIMER2_H_
+#define TIMER2_H_
+
+#include	"std_types.h"
+#include	"hal.h"
+#include	"timer1.h"		/* TIMSK & TIFR registers are shared between the timers */
+
+/************************* Timer2 Registers type structure declarations ************************/
+typedef union {
+	uint8 Byte;
+	struct{
+		uint8 CS20_Bit:1;
+		uint8 CS21_Bit:1;
+		uint8 CS22_Bit:1;
+		uint8 WGM21_Bit:1;
+		uint8 COM20_Bit:1;
+		uint8 COM21_Bit:1;
+		uint8 WGM20_Bit:1;
+		uint8 FOC2_Bit:1;
+	}Bits;
+}Timer2_TCCR2_Type;
+
+/*********************************** Timer2 Registers Definitions *************/
+#define TCCR2_REG     (*(volatile Timer2_TCCR2_Type*)HAL_IO_ADDRESS(0x45))
+#define TCNT2_REG     (*(volatile uint8*)HAL_IO_ADDRESS(0x44))
+#define OCR2_REG      (*(volatile uint8*)HAL_IO_ADDRESS(0x43))
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum
+{
+	TIMER2_NORMAL, TIMER2_CTC = 2
+}Timer2_Mode;
+
+typedef enum
+{
+	TIMER2_NO_CLOCK,
+	TIMER2_F_CPU_CLOCK, TIMER2_F_CPU_8, TIMER2_F_CPU_32, TIMER2_F_CPU_64,
+	TIMER2_F_CPU_128, TIMER2_F_CPU_256, TIMER2_F_CPU_1024
+}Timer2_Prescaler;
+
+typedef struct {
+	uint8 initial_value;
+	uint8 compare_value; // it will be used in compare mode only.
+	Timer2_Prescaler prescaler;
+	Timer2_Mode mode;
+} Timer2_ConfigType;
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+/*
+● Description:
+  	  ⮚ Function to initialize the Timer driver, the interrupt stays disabled
+  	    until Timer2_enableInterrupt is called.
+● Inputs: pointer to the configuration structure with type Timer2_ConfigType.
+● Return: None
+ */
+void Timer2_init(const Timer2_ConfigType * Config_Ptr);
+
+/*
+● Description:
+	⮚ Function to disable the Timer2.
+● Inputs: None
+● Return: None
+*/
+void Timer2_deInit(void);
+
+/*
+● Description:
+	⮚ Function to enable the interrupt of the configured mode (overflow or compare).
+● Inputs: None
+● Return: None
+*/
+void Timer2_enableInterrupt(void);
+
+/*
+● Description:
+	⮚ Function to disable the Timer2 interrupts, the timer keeps counting.
+● Inputs: None
+● Return: None
+*/
+void Timer2_disableInterrupt(void);
+
+/*
+● Description:
+	⮚ Function to set the Call Back function address.
+● Inputs: pointer to Call Back function.
+● Return: None
+*/
+void Timer2_setCallBack(void(*a_ptr)(void));
+
+#endif /* TIMER2_H_ */
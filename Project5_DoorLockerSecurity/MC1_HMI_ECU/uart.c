@@ -8,6 +8,69 @@
 #include	"uart.h"
 #include 	"common_macros.h" /* To use the macros like SET_BIT */
 #include	<avr/io.h>
+#include	<avr/interrupt.h>
+
+#ifdef UART_INTERRUPT_MODE
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* RX ring buffer: filled by the USART_RXC ISR and emptied by the application */
+static volatile uint8 g_rxBuffer[UART_RX_BUFFER_SIZE];
+static volatile uint8 g_rxHead = 0;
+static volatile uint8 g_rxTail = 0;
+
+/* TX ring buffer: filled by the application and emptied by the USART_UDRE ISR */
+static volatile uint8 g_txBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint8 g_txHead = 0;
+static volatile uint8 g_txTail = 0;
+
+/* Overflow counters */
+static volatile uint16 g_rxOverflowCount = 0;
+static volatile uint16 g_txOverflowCount = 0;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+ISR(USART_RXC_vect)
+{
+	/* The status flags must be read before UDR, reading UDR clears them */
+	uint8 overrun = UART_UCSRA_REG.Bits.DOR_Bit;
+	uint8 data = (uint8)UART_UDR_REG.TwoBytes;
+	uint8 next = (g_rxHead + 1) & UART_RX_BUFFER_MASK;
+
+	if(overrun)
+	{
+		/* At least one byte has been lost in the hardware buffer */
+		g_rxOverflowCount++;
+	}
+
+	if(next == g_rxTail)
+	{
+		/* RX ring buffer is full, drop the byte */
+		g_rxOverflowCount++;
+	}
+	else
+	{
+		g_rxBuffer[g_rxHead] = data;
+		g_rxHead = next;
+	}
+}
+
+ISR(USART_UDRE_vect)
+{
+	if(g_txTail != g_txHead)
+	{
+		/* Send the next byte in the TX ring buffer */
+		UART_UDR_REG.TwoBytes = g_txBuffer[g_txTail];
+		g_txTail = (g_txTail + 1) & UART_TX_BUFFER_MASK;
+	}
+	else
+	{
+		/* Nothing else to send, disable the UDRE interrupt until new data is queued */
+		UART_UCSRB_REG.Bits.UDRIE_Bit = 0;
+	}
+}
+#endif /* UART_INTERRUPT_MODE */
 
 /*******************************************************************************
  *                      Functions Definitions                                   *
@@ -37,6 +100,14 @@ void UART_init(const UART_ConfigType * Config_Ptr)
 	/* Set the third bits of the character size into the register UCSRC [UCSZ2] */
 	UART_UCSRB_REG.Bits.UCSZ2_Bit = (((Config_Ptr->bit_data) & 0x04) >> 2);
 
+#ifdef UART_INTERRUPT_MODE
+	/* Empty the ring buffers and enable the RX Complete interrupt,
+	 * the UDRE interrupt is enabled only when there is data to send */
+	g_rxHead = g_rxTail = 0;
+	g_txHead = g_txTail = 0;
+	UART_UCSRB_REG.Bits.RXCIE_Bit = 1;
+#endif
+
 
 	/************************** UCSRC Description ***************************/
 	/* The URSEL must be one when writing the UCSRC */
@@ -82,6 +153,18 @@ void UART_init(const UART_ConfigType * Config_Ptr)
  */
 void UART_sendByte(const uint8 data)
 {
+#ifdef UART_INTERRUPT_MODE
+	uint8 next = (g_txHead + 1) & UART_TX_BUFFER_MASK;
+
+	/* Wait only if the TX ring buffer is full, the UDRE ISR will free a place */
+	while(next == g_txTail){HAL_BUSY_WAIT();}
+
+	g_txBuffer[g_txHead] = data;
+	g_txHead = next;
+
+	/* Make sure the UDRE ISR is running to send the queued byte */
+	UART_UCSRB_REG.Bits.UDRIE_Bit = 1;
+#else
 	/*
 	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
 	 * transmitting a new byte so wait until this flag is set to one
@@ -99,6 +182,7 @@ void UART_sendByte(const uint8 data)
 	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
 	SET_BIT(UCSRA,TXC); // Clear the TXC flag
 	*******************************************************************/
+#endif
 }
 
 
@@ -108,6 +192,17 @@ void UART_sendByte(const uint8 data)
  */
 uint8 UART_recieveByte(void)
 {
+#ifdef UART_INTERRUPT_MODE
+	uint8 data;
+
+	/* Wait until the USART_RXC ISR put at least one byte in the RX ring buffer */
+	while(g_rxHead == g_rxTail){HAL_BUSY_WAIT();}
+
+	data = g_rxBuffer[g_rxTail];
+	g_rxTail = (g_rxTail + 1) & UART_RX_BUFFER_MASK;
+
+	return data;
+#else
 	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
 	while(BIT_IS_CLEAR(UART_UCSRA_REG.Byte,UART_UCSRA_REG.Bits.RXC_Bit)){}
 
@@ -116,6 +211,126 @@ uint8 UART_recieveByte(void)
 	 * The RXC flag will be cleared after read the data
 	 */
     return (uint8)UART_UDR_REG.TwoBytes;
+#endif
+}
+
+/*
+ * Description :
+ * Queue up to size bytes to be sent without waiting.
+ * Return: the number of bytes accepted, the rest is counted as TX overflow.
+ */
+uint8 UART_write(const uint8 *data, uint8 size)
+{
+	uint8 count = 0;
+
+#ifdef UART_INTERRUPT_MODE
+	uint8 next;
+
+	while(count < size)
+	{
+		next = (g_txHead + 1) & UART_TX_BUFFER_MASK;
+		if(next == g_txTail)
+		{
+			/* TX ring buffer is full */
+			break;
+		}
+		g_txBuffer[g_txHead] = data[count];
+		g_txHead = next;
+		count++;
+	}
+
+	if(count != 0)
+	{
+		/* Make sure the UDRE ISR is running to send the queued bytes */
+		UART_UCSRB_REG.Bits.UDRIE_Bit = 1;
+	}
+	g_txOverflowCount += (size - count);
+#else
+	/* Without buffers only the byte that fits in the empty UDR can be accepted */
+	if((size != 0) && UART_UCSRA_REG.Bits.UDRE_Bit)
+	{
+		UART_UDR_REG.TwoBytes = data[0];
+		count = 1;
+	}
+#endif
+
+	return count;
+}
+
+/*
+ * Description :
+ * Copy up to size received bytes into data without waiting.
+ * Return: the number of bytes copied.
+ */
+uint8 UART_read(uint8 *data, uint8 size)
+{
+	uint8 count = 0;
+
+#ifdef UART_INTERRUPT_MODE
+	while((count < size) && (g_rxTail != g_rxHead))
+	{
+		data[count] = g_rxBuffer[g_rxTail];
+		g_rxTail = (g_rxTail + 1) & UART_RX_BUFFER_MASK;
+		count++;
+	}
+#else
+	if((size != 0) && UART_UCSRA_REG.Bits.RXC_Bit)
+	{
+		data[0] = (uint8)UART_UDR_REG.TwoBytes;
+		count = 1;
+	}
+#endif
+
+	return count;
+}
+
+/*
+ * Description :
+ * Return the number of received bytes ready to be read.
+ */
+uint8 UART_available(void)
+{
+#ifdef UART_INTERRUPT_MODE
+	return (g_rxHead - g_rxTail) & UART_RX_BUFFER_MASK;
+#else
+	return UART_UCSRA_REG.Bits.RXC_Bit;
+#endif
+}
+
+/*
+ * Description :
+ * Return the number of received bytes lost because the RX ring buffer was full
+ * or the UART hardware buffer was overrun.
+ */
+uint16 UART_getRxOverflowCount(void)
+{
+#ifdef UART_INTERRUPT_MODE
+	uint16 count;
+	uint8 sreg = S_REG.Byte;
+
+	/* The 16-bit counter is updated by the ISR, read it with interrupts disabled */
+	S_REG.Bits.I_Bit = 0;
+	count = g_rxOverflowCount;
+	S_REG.Byte = sreg;
+
+	return count;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Description :
+ * Return the number of bytes rejected by UART_write because the TX ring buffer was full.
+ */
+uint16 UART_getTxOverflowCount(void)
+{
+#ifdef UART_INTERRUPT_MODE
+	/* Updated only by the application, no need to disable interrupts */
+	return g_txOverflowCount;
+#else
+	return 0;
+#endif
 }
 
 /*
@@ -6,10 +6,18 @@
 C_SRCS += \
 ../MC2_application.c \
 ../buzzer.c \
+../crc.c \
+../credential.c \
 ../dc_motor.c \
 ../external_eeprom.c \
 ../gpio.c \
+../journal.c \
+../limit_switch.c \
+../pin_hash.c \
+../profiler.c \
+../protocol.c \
 ../pwm.c \
+../scheduler.c \
 ../timer1.c \
 ../twi.c \
 ../uart.c 
@@ -17,10 +25,18 @@ C_SRCS += \
 OBJS += \
 ./MC2_application.o \
 ./buzzer.o \
+./crc.o \
+./credential.o \
 ./dc_motor.o \
 ./external_eeprom.o \
 ./gpio.o \
+./journal.o \
+./limit_switch.o \
+./pin_hash.o \
+./profiler.o \
+./protocol.o \
 ./pwm.o \
+./scheduler.o \
 ./timer1.o \
 ./twi.o \
 ./uart.o 
@@ -28,10 +44,18 @@ OBJS += \
 C_DEPS += \
 ./MC2_application.d \
 ./buzzer.d \
+./crc.d \
+./credential.d \
 ./dc_motor.d \
 ./external_eeprom.d \
 ./gpio.d \
+./journal.d \
+./limit_switch.d \
+./pin_hash.d \
+./profiler.d \
+./protocol.d \
 ./pwm.d \
+./scheduler.d \
 ./timer1.d \
 ./twi.d \
 ./uart.d 
@@ -5,11 +5,19 @@
  * Date: 11/6/2023
  *******************************************************************************/
 #include 	"buzzer.h"
-#include 	"external_EEPROM.h"
+#include 	"external_eeprom.h"
 #include	"dc_motor.h"
+#include	"limit_switch.h"
+#include	"credential.h"
+#include	"journal.h"
+#include	"pin_hash.h"
 #include 	"uart.h"
+#include 	"protocol.h"
 #include 	"timer1.h"
+#include 	"scheduler.h"
+#include 	"profiler.h"
 #include	<util/delay.h>
+#include	<avr/interrupt.h>
 #include 	"twi.h"
 /*******************************************************************************
  *                                Definitions                                  *
@@ -17,29 +25,29 @@
 #define ZERO							0
 
 #ifdef TIMER1_COMPARE
-#define COMPARE_VALUE					7812	// Compare Value for timer 1 if Compare mode defined
+#define COMPARE_VALUE					7999	// Compare Value for timer 1 if Compare mode defined
 #endif
 
-/* UART Values Between MC1 & MC2 */
-#define MC1_READY 						0x01	// MC1 is ready
-#define MC2_READY 						0x02	// MC2 is ready
-
-#define CHANGE_PASSWORD					0x13	// change the password
-#define SAVE_PASSWORD 					0x04	// save the password
-#define PASSWORD_SAVED					0x05	// password has been saved
-#define UNLOCK_THE_DOOR					0x12	// open the door [door sequence]
-#define BUZZER_ON_BYTE					0x11	// turn the buzzer on	[buzzer sequence]
-#define SEND_PASSWORD_TO_BE_CHECKED 	0x06	// send the password to be checked
-#define PASSWORD_CHECK					0x12	// check if the password correct
-#define PASSWORD_DOESNT_MATCH			0x08	// password WRONG
-#define PASSWORD_MATCH					0x09	// password correct
-#define BEGGINING_OF_EEPROM_ADDRESS		0x70	// the first address of the password at EEPROM
+/* UART Commands Between MC1 & MC2 are defined in protocol.h */
+/* The password digest is the JOURNAL_KEY_PASSWORD record of the journal, the PIN holders are in credential.h */
 
 /* Password Configurations */
 #define PASSWORD_SIZE					5		// Size of the password
 #define WRONG_PASSWORD					0		// Indicates that is a wrong password
 #define RIGHT_PASSWORD					1		// Indicates that is a correct password
 
+#if (PASSWORD_SIZE != PIN_HASH_PIN_SIZE)
+#error "the PIN holders use the same password size"
+#endif
+
+#if (PIN_HASH_DIGEST_SIZE > JOURNAL_DATA_SIZE) || (PIN_HASH_SALT_SIZE > JOURNAL_DATA_SIZE)
+#error "the password digest & the salt should fit in one journal record"
+#endif
+
+#if (JOURNAL_REGION_ADDRESS + (JOURNAL_SLOTS * JOURNAL_RECORD_SIZE) > CREDENTIAL_TABLE_ADDRESS)
+#error "the journal and the PIN holders table overlap"
+#endif
+
 #define MAX_NO_OF_WRONG_TIMES			3		// Maximum no of wrong times before buzzer turned ON
 
 /* Main Options Configurations*/
@@ -50,19 +58,61 @@
 #define SUBMIT_PASSWORD					'='		// Indicates that the user want to submit the password
 #define PASSWORD_MARK					'*'		// Password mark that appears on LCD
 
-/* Motor Movement Time & Speed Configurations */
-#define MOTOR_CW_TIME					15
-#define MOTOR_STOP_TIME					3
-#define MOTOR_ACW_TIME					15
-#define ERROR_TIME						60
+/*
+ * Motor Movement Time (ms) & Speed Configurations
+ * The limit switches stop the movements at the end positions, the CW & ACW times are the
+ * longest movements, the motor stops there even without a switch.
+ */
+#define MOTOR_CW_TIME					15000
+#define MOTOR_STOP_TIME					3000
+#define MOTOR_ACW_TIME					15000
+#define ERROR_TIME						60000
 #define DC_MOTOR_SPEED					100
+#define MOTOR_RAMP_TIME					1000	// soft start & soft stop time inside each movement
+#define MOTOR_REVERSE_MARGIN			100		// distance in ms at full speed added to an emergency reversal, so it ends on the locked switch
 
 /*******************************************************************************
  *                           Global Variables                                  *
  *******************************************************************************/
-static uint8 volatile g_tick = 0;		/* to count ticks */
-
-uint8 g_responseByte; // to store the response
+/* state of the door sequence and the timer of its current step, the state is read by the limit switch interrupt */
+static volatile PROTOCOL_DoorStateType g_doorState = DOOR_LOCKED;
+static SCHEDULER_TimerId g_doorTimer = SCHEDULER_INVALID_TIMER;
+static uint32 g_moveStartTick;			/* tick when the current movement started */
+
+/* end position reached by the bolt & its tick, LIMIT_SWITCH_NONE when it is handled */
+static volatile LIMIT_SWITCH_Type g_limitSwitch = LIMIT_SWITCH_NONE;
+static volatile uint32 g_limitSwitchTick;
+
+/* last measured travel times in ms, 0 until a full movement ends on its limit switch */
+static uint16 g_unlockTravelTime = 0;
+static uint16 g_lockTravelTime = 0;
+static boolean g_fullMovement = FALSE;	/* FALSE while an emergency lock moves the bolt back */
+
+/* the bolt movements, the ramps are inside the movement time so the door timing is unchanged */
+static const DcMotor_ProfileType g_unlockProfile =
+	{DC_MOTOR_S_CURVE, DC_MOTOR_SPEED, MOTOR_RAMP_TIME, MOTOR_CW_TIME - (2 * MOTOR_RAMP_TIME), MOTOR_RAMP_TIME};
+static const DcMotor_ProfileType g_lockProfile =
+	{DC_MOTOR_S_CURVE, DC_MOTOR_SPEED, MOTOR_RAMP_TIME, MOTOR_ACW_TIME - (2 * MOTOR_RAMP_TIME), MOTOR_RAMP_TIME};
+
+/* the lock profile fitted to the distance of an unlocking that an emergency lock reverses */
+static DcMotor_ProfileType g_reverseProfile;
+
+/* the timer that turns the buzzer off, SCHEDULER_INVALID_TIMER when the buzzer is off */
+static SCHEDULER_TimerId g_buzzerTimer = SCHEDULER_INVALID_TIMER;
+
+PROTOCOL_FrameType g_responseFrame; // to store the received frame
+
+/* the digests of the entered & saved passwords used by the interrupt driven password check */
+static uint8 g_enteredDigest[PIN_HASH_DIGEST_SIZE];
+static uint8 g_savedDigest[PIN_HASH_DIGEST_SIZE];
+static EEPROM_RequestType g_passwordRequest;
+static boolean g_passwordCheckInProgress = FALSE;
+static boolean g_passwordCheckHolders = FALSE;	/* TRUE while the PIN holders table is searched */
+
+/* the salt of the PIN digests is made once from the times of the first frames then kept in the journal */
+static uint32 g_readyTime;
+static boolean g_mc1Ready = FALSE;	/* set by the first frame of MC1, MC1_READY may be lost */
+static boolean g_pinSaltSaved = FALSE;
 
 /*******************************************************************************
  *                           Structure Configurations                          *
@@ -71,45 +121,104 @@ uint8 g_responseByte; // to store the response
 UART_ConfigType UART_Configurations = {EIGHT_BITS, DISABLED, ONE_BIT, BD_9600, ASYNCHRONOUS, ASYNCHRONOUS_DOUBLE_SPEED};
 
 /*
- * create configuration for timer to get interrupt every 1 second
- * To calculate 1second -> F = 1Hz
+ * create configuration for timer to get interrupt every 1 ms [scheduler tick]
+ * To calculate 1ms -> F = 1KHz
     	F = F(CPU)/N(1+x) = 8Mhz/ N(1+x) try different pre-scalar
-    	N = 64  , x = 124999
-    	N = 256 , x = 31249
-    	N = 1024 , x = 7812
-    so the better is N = 1024
+    	N = 1  , x = 7999
+    	N = 8  , x = 999
+    	N = 64 , x = 124
+    so the better is N = 1, the timer counts the CPU cycles inside each tick
  * Set The Timer 1 Configurations
  */
-Timer1_ConfigType Timer1_Configuration = {ZERO, COMPARE_VALUE, F_CPU_1024, CTC_OCR1A};
+Timer1_ConfigType Timer1_Configuration = {ZERO, COMPARE_VALUE, F_CPU_CLOCK, CTC_OCR1A};
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /* Description:
- * 	used to set the required time in each task.
+ * 	used to count the scheduler ticks.
  */
 void Timer_callBack(void);
 
 /* Description:
- * 	function to save the password in the EEPROM memory.
+ * 	called from the interrupt when the bolt reaches an end position.
+ */
+void limitSwitch_callBack(LIMIT_SWITCH_Type limit_switch);
+
+/* Description:
+ * 	function to end the current movement of the motor sequence at its limit switch.
+ */
+void limitSwitchReached(void);
+
+/* Description:
+ * 	function to load the salt of the PIN digests from the journal, if it was made before.
+ */
+void pinSaltLoad(void);
+
+/* Description:
+ * 	function to make & save the salt of the PIN digests before the first digest is stored,
+ * 	no digest can be stored when it returns an error.
+ */
+JOURNAL_StatusType pinSaltCreate(void);
+
+/* Description:
+ * 	function to save the password digest as a new record of the journal in the EEPROM memory.
  */
 void receive_password(void);
 
 /* Description:
- * 	function to read the password from the EEPROM memory and check whether correct or wrong.
+ * 	function to start reading the password from the EEPROM memory to check whether correct or wrong.
  */
 void checkThePasswordAfterBeingStored(void);
 
 /* Description:
- * 	function to activate the motor and do its sequence [unlocking , open , locking, locked].
+ * 	function to compare the entered password with the saved one and send the verdict to MC1.
+ */
+void sendPasswordVerdict(void);
+
+/* Description:
+ * 	function to continue the interrupt driven password check from the main loop.
+ */
+void passwordCheckProgress(void);
+
+/* Description:
+ * 	functions to add, remove & list the PIN holders of the credential table and report its filter.
+ */
+void credentialAdd(void);
+void credentialRemove(void);
+void credentialList(void);
+void credentialFilterInfo(void);
+
+/* Description:
+ * 	function to activate the motor and start its sequence [unlocking , open , locking, locked].
  */
 void motorSequence(void);
 
 /* Description:
- * 	function to activate the buzzer and do its sequence.
+ * 	scheduler task that moves the motor sequence to its next step.
+ */
+void motorSequenceNextStep(void);
+
+/* Description:
+ * 	function to stop the motor sequence and lock the door now.
+ */
+void emergencyLock(void);
+
+/* Description:
+ * 	function to send the door & buzzer state to MC1.
+ */
+void sendDoorStatus(void);
+
+/* Description:
+ * 	function to activate the buzzer and start its sequence.
  */
 void buzzer_IS_OPENED(void);
 
+/* Description:
+ * 	scheduler task that turns the buzzer off after the error time.
+ */
+void buzzerSequenceEnd(void);
+
 /*Description:
  * check the state of response and do each task depends on the response
  * */
@@ -133,32 +242,62 @@ int main(void)
 	/*initiate I2C driver*/
 	TWI_init(&TWI_Configurations);
 
+	/*find the newest password in the journal and keep its page in the EEPROM cache, each check reads it*/
+	JOURNAL_init();
+	pinSaltLoad();
+	if(JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD) != JOURNAL_NO_ADDRESS)
+	{
+		EEPROM_cacheLoad(JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD), PIN_HASH_DIGEST_SIZE);
+	}
+
+	/* initialize the scheduler before its timer starts ticking */
+	SCHEDULER_init();
+
 	/* initialize timer 1 driver*/
 	Timer1_init(&Timer1_Configuration);
 	/* set the call back to pointer in the Timer 1 */
 	Timer1_setCallBack(Timer_callBack);
 
+	/* the profiler counts the Timer 1 cycles of the scheduler tick */
+	PROFILER_init();
+
 	/*initiate Buzzer driver*/
 	Buzzer_init();
 
 	/*initiate DC_motor driver*/
 	DcMotor_init();
 
-	/* wait until MC2 receive that MC1 is ready*/
-	while(UART_recieveByte()!=MC1_READY);
+	/*initiate the limit switches, they stop the motor at the end positions*/
+	LIMIT_SWITCH_setCallBack(limitSwitch_callBack);
+	LIMIT_SWITCH_init();
 
-	/* receive the password to be inserted in the EEPROM*/
-	receive_password();
+	/*read the PIN holders table and build its index*/
+	CREDENTIAL_init();
 
 	while(1)
 	{
+		/* store the received frame without waiting, so the EEPROM traffic keeps going in the background
+		 * the first frame is MC1_READY, then the password to be inserted in the EEPROM */
+		if(PROTOCOL_poll(&g_responseFrame) == PROTOCOL_FRAME_READY)
+		{
+			/* check the state of response and do each task depends on the response */
+			responseProcesses();
+		}
 
-		/* store the state of the received byte */
-		g_responseByte = UART_recieveByte();
+		/* the password check goes on with the EEPROM reads done in the background */
+		if(g_passwordCheckInProgress)
+		{
+			passwordCheckProgress();
+		}
 
-		/* check the state of response and do each task depends on the response */
-		responseProcesses();
+		/* the bolt reached the end of its movement */
+		if(g_limitSwitch != LIMIT_SWITCH_NONE)
+		{
+			limitSwitchReached();
+		}
 
+		/* run the steps of the motor & buzzer sequences that are due */
+		SCHEDULER_dispatch();
 	}
 }
 
@@ -167,10 +306,17 @@ int main(void)
  * */
 void responseProcesses(void)
 {
-	switch(g_responseByte)
+	PROF_BEGIN(PROF_RESPONSE_PROCESSES);
+	if(!g_mc1Ready)
+	{
+		g_readyTime = PROFILER_now();
+		g_mc1Ready = TRUE;
+	}
+
+	switch(g_responseFrame.command)
 	{
 	/* this means that the password has been sent*/
-	case SEND_PASSWORD_TO_BE_CHECKED:
+	case PASSWORD_CHECK:
 		/* check whether its correct or not*/
 		checkThePasswordAfterBeingStored();
 		break;
@@ -186,175 +332,536 @@ void responseProcesses(void)
 		/* Open the Buzzer for specific time */
 		buzzer_IS_OPENED();
 		break;
-	case CHANGE_PASSWORD:
-		/*Change the password sequence*/
+	case SAVE_PASSWORD:
+		/*Create or change the password sequence*/
 		receive_password();
 		break;
+
+	/* MC1 asks about the state while a sequence may be running */
+	case DOOR_STATUS_REQUEST:
+		sendDoorStatus();
+		break;
+
+	case EMERGENCY_LOCK:
+		emergencyLock();
+		break;
+
+	/* PIN holders table commands */
+	case CREDENTIAL_ADD:
+		credentialAdd();
+		break;
+
+	case CREDENTIAL_REMOVE:
+		credentialRemove();
+		break;
+
+	case CREDENTIAL_LIST:
+		credentialList();
+		break;
+
+	case CREDENTIAL_FILTER_INFO:
+		credentialFilterInfo();
+		break;
 	}
+	PROF_END(PROF_RESPONSE_PROCESSES);
 }
 
 
 /* Description:
- * 	used to set the required time in each task.
+ * 	used to count the scheduler ticks, run the motor profile and the TWI deadline.
  */
 void Timer_callBack(void)
 {
-	g_tick++;
-	/* clear the register*/
-	TCNT1_REG.TwoBytes = 0;
+	SCHEDULER_tick();
+	DcMotor_tick();
+	TWI_tick();
 }
 
 /* Description:
- * 	function to save the password in the EEPROM memory.
+ * 	called from the interrupt when the bolt reaches an end position.
  */
-void receive_password(void)
+void limitSwitch_callBack(LIMIT_SWITCH_Type limit_switch)
 {
+	if(((g_doorState == DOOR_UNLOCKING) && (limit_switch == LIMIT_SWITCH_UNLOCKED)) ||
+			((g_doorState == DOOR_LOCKING) && (limit_switch == LIMIT_SWITCH_LOCKED)))
+	{
+		/* stop at once, the sequence moves on in the main loop */
+		DcMotor_Rotate(OFF, ZERO);
+		if(g_limitSwitch == LIMIT_SWITCH_NONE)
+		{
+			g_limitSwitchTick = SCHEDULER_getTicks();
+			g_limitSwitch = limit_switch;
+		}
+	}
+}
 
-	/* variable to receive each byte of the password*/
-	uint8 pass;
+/* Description:
+ * 	function to end the current movement of the motor sequence at its limit switch.
+ */
+void limitSwitchReached(void)
+{
+	LIMIT_SWITCH_Type limit_switch;
+	uint16 travel_time;
+	uint8 sreg = SREG;
+
+	cli();
+	limit_switch = g_limitSwitch;
+	travel_time = (uint16)((g_limitSwitchTick - g_moveStartTick) * SCHEDULER_TICK_MS);
+	g_limitSwitch = LIMIT_SWITCH_NONE;
+	SREG = sreg;
+
+	/* a switch of a movement that an emergency lock has already reversed is dropped */
+	if((g_doorState == DOOR_UNLOCKING) && (limit_switch == LIMIT_SWITCH_UNLOCKED))
+	{
+		g_unlockTravelTime = travel_time;
+	}
+	else if((g_doorState == DOOR_LOCKING) && (limit_switch == LIMIT_SWITCH_LOCKED))
+	{
+		if(g_fullMovement)
+		{
+			g_lockTravelTime = travel_time;
+		}
+	}
+	else
+	{
+		return;
+	}
 
-	/* variable to count from 0 to password size*/
-	uint8 passCounter;
+	/* the movement is done before its longest time */
+	SCHEDULER_stop(g_doorTimer);
+	motorSequenceNextStep();
+}
 
-	/* waits until the MC1 send the password to be stored at EEPROM*/
-	while(UART_recieveByte() != SAVE_PASSWORD);
+/* Description:
+ * 	function to load the salt of the PIN digests from the journal, if it was made before.
+ */
+void pinSaltLoad(void)
+{
+	uint8 salt[JOURNAL_DATA_SIZE];
+	uint8 length;
 
-	/* loop to receive the password byte by byte*/
-	for(passCounter = 0; passCounter<PASSWORD_SIZE;passCounter++)
+	if((JOURNAL_read(JOURNAL_KEY_PIN_SALT, salt, &length) == JOURNAL_OK) && (length == PIN_HASH_SALT_SIZE))
 	{
-		/*send byte to till the MC1 that MC2 is ready to receive the password*/
-		UART_sendByte(MC2_READY);
+		PIN_HASH_setSalt(salt);
+		g_pinSaltSaved = TRUE;
+	}
+}
 
-		/* receive each byte using this loop in pass variable*/
-		pass = UART_recieveByte();
+/* Description:
+ * 	function to make & save the salt of the PIN digests before the first digest is stored.
+ */
+JOURNAL_StatusType pinSaltCreate(void)
+{
+	uint8 salt[PIN_HASH_SALT_SIZE];
+	uint32 now = PROFILER_now();
+	JOURNAL_StatusType status;
+	uint8 i;
 
-		/*after receive the byte in pass write it in the EEPROM*/
-		EEPROM_writeByte((BEGGINING_OF_EEPROM_ADDRESS+passCounter) , pass);
-		_delay_ms(10);
+	if(g_pinSaltSaved)
+	{
+		return JOURNAL_OK;
 	}
 
-	/* after the loop this means that the password has been stored in the EEPROM*/
-	/* send byte to MC1 to tell him that the password has been saved*/
-	UART_sendByte(PASSWORD_SAVED);
+	/* the CPU cycles until MC1 was ready & until the first PIN was entered differ from one
+	 * device to another, the salt only has to be different */
+	for(i = 0; i < 4; i++)
+	{
+		salt[i] = (uint8)(g_readyTime >> (i * 8));
+		salt[4 + i] = (uint8)(now >> (i * 8));
+	}
+
+	/* the digests use the salt only once it is saved, they would be lost with it otherwise */
+	status = JOURNAL_write(JOURNAL_KEY_PIN_SALT, salt, PIN_HASH_SALT_SIZE);
+	if(status == JOURNAL_OK)
+	{
+		PIN_HASH_setSalt(salt);
+		g_pinSaltSaved = TRUE;
+	}
+	return status;
 }
 
 /* Description:
- * 	function to read the password from the EEPROM memory and check whether correct or wrong.
+ * 	function to save the password digest in the EEPROM memory.
  */
-void checkThePasswordAfterBeingStored(void)
+void receive_password(void)
 {
-	/* variable to count from 0 to password size*/
-	uint8 passCounter;
+	/* address of the previous password, its page is kept in the EEPROM cache */
+	uint16 previous_address = JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD);
+	uint8 digest[PIN_HASH_DIGEST_SIZE];
+	JOURNAL_StatusType status;
 
-	uint8 wrong_times = 0;	/* variable to store the wrong times that password have been submitted*/
+	/* the whole password is the payload of the SAVE_PASSWORD frame */
+	if(g_responseFrame.length != PASSWORD_SIZE)
+	{
+		PROTOCOL_sendFrame(PASSWORD_SAVE_FAILED, NULL_PTR, 0);
+		return;
+	}
 
-	/* array to store the entered password*/
-	uint8 entered_pass[PASSWORD_SIZE];
+	/* only the salted digest of the password is stored, a digest without the salt
+	 * wouldn't match any more once the salt is saved */
+	if(pinSaltCreate() != JOURNAL_OK)
+	{
+		PROTOCOL_sendFrame(PASSWORD_SAVE_FAILED, NULL_PTR, 0);
+		return;
+	}
+	PIN_HASH_compute(g_responseFrame.payload, digest);
 
-	/* array of the saved password [correct password]*/
-	uint8 saved_pass[PASSWORD_SIZE];
+	/* write the digest in a new journal record of one page, the previous one stays
+	 * valid until the write cycle finishes */
+	PROF_BEGIN(PROF_EEPROM_WRITE);
+	status = JOURNAL_write(JOURNAL_KEY_PASSWORD, digest, PIN_HASH_DIGEST_SIZE);
+	PROF_END(PROF_EEPROM_WRITE);
 
-	/* waits until MC1 send the password and MC2 received to be checked*/
-	while(UART_recieveByte() != PASSWORD_CHECK);
+	if(status != JOURNAL_OK)
+	{
+		/* the previous password, if any, is still the valid one */
+		PROTOCOL_sendFrame(PASSWORD_SAVE_FAILED, NULL_PTR, 0);
+		return;
+	}
 
-	passCounter = 0;
-	/* check if the two arrays of password are identical or not*/
-	while(passCounter < PASSWORD_SIZE)
+	/* move the cached page to the new record */
+	if(previous_address != JOURNAL_NO_ADDRESS)
 	{
-		/*send byte to till the MC1 that MC2*/
-		UART_sendByte(MC2_READY);
+		EEPROM_cacheRelease(previous_address, PIN_HASH_DIGEST_SIZE);
+	}
+	EEPROM_cacheLoad(JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD), PIN_HASH_DIGEST_SIZE);
 
-		/* receive each byte using this loop in pass variable*/
-		entered_pass[passCounter] = UART_recieveByte();
+	/* this means that the password has been stored in the EEPROM*/
+	/* send frame to MC1 to tell him that the password has been saved*/
+	PROTOCOL_sendFrame(PASSWORD_SAVED, NULL_PTR, 0);
+}
 
-		/*after receive the byte in pass write it in the EEPROM*/
-		EEPROM_readByte((BEGGINING_OF_EEPROM_ADDRESS + passCounter) , &saved_pass[passCounter]);
-		_delay_ms(10);
+/* Description:
+ * 	function to start looking for the password in the PIN holders table then reading the password
+ * 	from the EEPROM memory to check whether correct or wrong, the verdict is sent by
+ * 	sendPasswordVerdict() when the interrupt driven reads finish.
+ */
+void checkThePasswordAfterBeingStored(void)
+{
+	if(g_passwordCheckInProgress)
+	{
+		/* MC1 waits for the verdict of the current check */
+		return;
+	}
 
-		/* if any character is different then both are not identical then it is not matched
-		 * increase wrong times */
-		if(entered_pass[passCounter] != saved_pass[passCounter])
+	if(g_responseFrame.length != PASSWORD_SIZE)
+	{
+		/* a password with wrong size can't be correct */
+		PROTOCOL_sendFrame(PASSWORD_DOESNT_MATCH, NULL_PTR, 0);
+		return;
+	}
+
+	/* keep the digest of the entered password, it is compared with the stored digests */
+	PROF_BEGIN(PROF_PIN_HASH);
+	PIN_HASH_compute(g_responseFrame.payload, g_enteredDigest);
+	PROF_END(PROF_PIN_HASH);
+
+	/*look for a PIN holder first, only the records with the same index tag are read*/
+	PROF_BEGIN(PROF_EEPROM_READ);
+	CREDENTIAL_lookupStart(g_enteredDigest);
+	g_passwordCheckHolders = TRUE;
+	g_passwordCheckInProgress = TRUE;
+}
+
+/* Description:
+ * 	function to continue the interrupt driven password check from the main loop.
+ */
+void passwordCheckProgress(void)
+{
+	CREDENTIAL_StatusType status;
+
+	if(g_passwordCheckHolders)
+	{
+		status = CREDENTIAL_lookupPoll();
+		if(status == CREDENTIAL_PENDING)
+		{
+			return;
+		}
+		g_passwordCheckHolders = FALSE;
+
+		if(status == CREDENTIAL_OK)
+		{
+			g_passwordCheckInProgress = FALSE;
+			PROF_END(PROF_EEPROM_READ);
+			PROTOCOL_sendFrame(PASSWORD_MATCH, NULL_PTR, 0);
+			return;
+		}
+
+		/*not a PIN holder, read the whole saved password from the EEPROM in the background*/
+		if((JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD) == JOURNAL_NO_ADDRESS) ||
+				(EEPROM_readBlockAsync(&g_passwordRequest, JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD),
+				g_savedDigest, PIN_HASH_DIGEST_SIZE, NULL_PTR) != SUCCESS))
 		{
-			wrong_times ++;
+			g_passwordCheckInProgress = FALSE;
+			PROF_END(PROF_EEPROM_READ);
+			PROTOCOL_sendFrame(PASSWORD_DOESNT_MATCH, NULL_PTR, 0);
 		}
+		return;
+	}
+
+	/* the saved password has been read, send the verdict */
+	if(g_passwordRequest.transaction.status != TWI_PENDING)
+	{
+		sendPasswordVerdict();
+	}
+}
 
-		if(wrong_times == 0)
+/* Description:
+ * 	function to add the PIN of the CREDENTIAL_ADD frame to the PIN holders table.
+ */
+void credentialAdd(void)
+{
+	uint8 result[2] = {CREDENTIAL_INVALID_PIN, CREDENTIAL_INVALID_ID};
+	uint8 digest[PIN_HASH_DIGEST_SIZE];
+
+	if(g_responseFrame.length == PIN_HASH_PIN_SIZE)
+	{
+		/* only the salted digest of the PIN is stored */
+		if(pinSaltCreate() != JOURNAL_OK)
 		{
-			/* This means the person entered the password Correct*/
-			UART_sendByte(PASSWORD_MATCH);
+			result[0] = CREDENTIAL_EEPROM_ERROR;
 		}
-		/* This means the person entered the password wrong*/
 		else
 		{
-			UART_sendByte(PASSWORD_DOESNT_MATCH);
+			PIN_HASH_compute(g_responseFrame.payload, digest);
+			result[0] = CREDENTIAL_add(digest, &result[1]);
 		}
-		passCounter++;
 	}
+	PROTOCOL_sendFrame(CREDENTIAL_RESULT, result, sizeof(result));
+}
 
+/* Description:
+ * 	function to remove the PIN holder of the CREDENTIAL_REMOVE frame.
+ */
+void credentialRemove(void)
+{
+	uint8 result[2] = {CREDENTIAL_NOT_FOUND, CREDENTIAL_INVALID_ID};
+
+	if(g_responseFrame.length == 1)
+	{
+		result[1] = g_responseFrame.payload[0];
+		result[0] = CREDENTIAL_remove(result[1]);
+	}
+	PROTOCOL_sendFrame(CREDENTIAL_RESULT, result, sizeof(result));
 }
 
 /* Description:
- * 	function to activate the motor and do its sequence [unlocking , open , locking, locked].
+ * 	function to send the number & the ids of the PIN holders.
+ */
+void credentialList(void)
+{
+	uint8 list[1 + CREDENTIAL_BITMAP_SIZE];
+
+	list[0] = CREDENTIAL_count();
+	CREDENTIAL_list(&list[1]);
+	PROTOCOL_sendFrame(CREDENTIAL_LIST_DATA, list, sizeof(list));
+}
+
+/* Description:
+ * 	function to send the size, fill & false positive rate of the PIN holders Bloom filter.
+ */
+void credentialFilterInfo(void)
+{
+	CREDENTIAL_FilterInfoType info;
+	uint8 data[12];
+
+	CREDENTIAL_filterInfo(&info);
+	data[0] = (uint8)info.bits;
+	data[1] = (uint8)(info.bits >> 8);
+	data[2] = info.hashes;
+	data[3] = (uint8)info.bitsSet;
+	data[4] = (uint8)(info.bitsSet >> 8);
+	data[5] = info.entries;
+	data[6] = (uint8)info.falsePositiveRate;
+	data[7] = (uint8)(info.falsePositiveRate >> 8);
+	data[8] = (uint8)info.rejected;
+	data[9] = (uint8)(info.rejected >> 8);
+	data[10] = (uint8)info.falsePositives;
+	data[11] = (uint8)(info.falsePositives >> 8);
+	PROTOCOL_sendFrame(CREDENTIAL_FILTER_DATA, data, sizeof(data));
+}
+
+/* Description:
+ * 	function to compare the entered password with the saved one read from the EEPROM
+ * 	and send the verdict to MC1.
+ */
+void sendPasswordVerdict(void)
+{
+	uint8 wrong_times = 0;	/* variable to store the wrong times that password have been submitted*/
+
+	g_passwordCheckInProgress = FALSE;
+	PROF_END(PROF_EEPROM_READ);
+
+	if(g_passwordRequest.transaction.status != TWI_DONE)
+	{
+		/* the saved password couldn't be read */
+		wrong_times++;
+	}
+
+	/* check if the two digests are identical or not, all the bytes are compared so the
+	 * time doesn't tell how many bytes matched */
+	if(!PIN_HASH_equal(g_enteredDigest, g_savedDigest, PIN_HASH_DIGEST_SIZE))
+	{
+		wrong_times++;
+	}
+
+	if(wrong_times == 0)
+	{
+		/* This means the person entered the password Correct*/
+		PROTOCOL_sendFrame(PASSWORD_MATCH, NULL_PTR, 0);
+	}
+	/* This means the person entered the password wrong*/
+	else
+	{
+		PROTOCOL_sendFrame(PASSWORD_DOESNT_MATCH, NULL_PTR, 0);
+	}
+}
+
+/* Description:
+ * 	function to activate the motor and start its sequence [unlocking , open , locking, locked].
  */
 void motorSequence(void)
 {
-	/* initialize timer 1 driver*/
-	Timer1_init(&Timer1_Configuration);
-	Timer1_setCallBack(Timer_callBack);
+	if(g_doorState != DOOR_LOCKED)
+	{
+		/* the door sequence is already running */
+		return;
+	}
 
-	/* 1. Unlock the Door for specific time , so the motor will operate in CW*/
-	DcMotor_Rotate(CW, DC_MOTOR_SPEED);
-	/* initiate the time for this specific time*/
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the motor movement CW time be done then break the loop*/
-	while (g_tick != MOTOR_CW_TIME) {} ;
-
-	/* 2. Open the Door for specific time , so the motor will operate in CW*/
-	DcMotor_Rotate(OFF, ZERO);
-	/* initiate the time for this specific time*/
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the motor stop time be done then break the loop*/
-	while (g_tick != MOTOR_STOP_TIME) {} ;
-
-	/* 3. Lock the Door for specific time , so the motor will operate in CW*/
-	DcMotor_Rotate(ACW, DC_MOTOR_SPEED);
-
-	/* initiate the time for this specific time*/
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
-	/* waits until the motor movement ACW be done then break the loop*/
-	while (g_tick != MOTOR_ACW_TIME) {} ;
-
-
-	/* 4. stop the motor and stop the timer*/
-	DcMotor_Rotate(OFF,DC_MOTOR_SPEED);
-	/* stop the timer */
-	Timer1_deInit();
+	/* 1. Unlock the Door until the unlocked switch, so the motor will operate in CW*/
+	g_doorState = DOOR_UNLOCKING;
+	g_moveStartTick = SCHEDULER_getTicks();
+	g_fullMovement = TRUE;
+	DcMotor_moveProfile(CW, &g_unlockProfile);
+
+	/* the next step runs when the motor movement CW time is done */
+	g_doorTimer = SCHEDULER_startOneShot(MOTOR_CW_TIME, motorSequenceNextStep);
 }
 
 /* Description:
- * 	function to activate the buzzer and do its sequence.
+ * 	scheduler task that moves the motor sequence to its next step.
  */
-void buzzer_IS_OPENED(void)
+void motorSequenceNextStep(void)
 {
-	/* initialize timer 1 driver*/
-	Timer1_init(&Timer1_Configuration);
-	Timer1_setCallBack(Timer_callBack);
+	switch(g_doorState)
+	{
+	case DOOR_UNLOCKING:
+		/* 2. Open the Door for specific time , so the motor will stop*/
+		DcMotor_Rotate(OFF, ZERO);
+		g_doorState = DOOR_OPEN;
+		g_doorTimer = SCHEDULER_startOneShot(MOTOR_STOP_TIME, motorSequenceNextStep);
+		break;
+
+	case DOOR_OPEN:
+		/* 3. Lock the Door until the locked switch, so the motor will operate in ACW*/
+		g_doorState = DOOR_LOCKING;
+		g_moveStartTick = SCHEDULER_getTicks();
+		DcMotor_moveProfile(ACW, &g_lockProfile);
+		g_doorTimer = SCHEDULER_startOneShot(MOTOR_ACW_TIME, motorSequenceNextStep);
+		break;
+
+	case DOOR_LOCKING:
+		/* 4. stop the motor, the door is locked*/
+		DcMotor_Rotate(OFF, ZERO);
+		g_doorState = DOOR_LOCKED;
+		g_doorTimer = SCHEDULER_INVALID_TIMER;
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Description:
+ * 	function to stop the motor sequence and lock the door now.
+ */
+void emergencyLock(void)
+{
+	uint32 distance;
+	uint16 ramps_distance = (uint16)(((uint32)DC_MOTOR_SPEED * MOTOR_RAMP_TIME) / 100);
+
+	switch(g_doorState)
+	{
+	case DOOR_UNLOCKING:
+		/* the bolt moved only along a part of the unlock profile, it is moved back the same distance */
+		SCHEDULER_stop(g_doorTimer);
+		distance = DcMotor_profileDistance(&g_unlockProfile,
+				(SCHEDULER_getTicks() - g_moveStartTick) * SCHEDULER_TICK_MS) + MOTOR_REVERSE_MARGIN;
+
+		/*
+		 * the lock profile with the cruise shortened to the distance, the two ramps cover
+		 * the distance of one ramp time at full speed, a shorter distance lowers the speed
+		 */
+		g_reverseProfile = g_lockProfile;
+		if(distance >= ramps_distance)
+		{
+			g_reverseProfile.cruise_time_ms = (uint16)(((distance - ramps_distance) * 100) / DC_MOTOR_SPEED);
+		}
+		else
+		{
+			g_reverseProfile.cruise_time_ms = 0;
+			g_reverseProfile.speed = (uint8)((distance * 100) / MOTOR_RAMP_TIME);
+		}
+
+		/* the state changes first, so the unlocked switch can't stop the reversed motor, the
+		 * motor ramps from zero in the other direction so it is never reversed at speed */
+		g_doorState = DOOR_LOCKING;
+		g_fullMovement = FALSE;
+		DcMotor_moveProfile(ACW, &g_reverseProfile);
+		g_doorTimer = SCHEDULER_startOneShot(g_reverseProfile.accel_time_ms + g_reverseProfile.cruise_time_ms +
+				g_reverseProfile.decel_time_ms, motorSequenceNextStep);
+		break;
 
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
+	case DOOR_OPEN:
+		/* skip the rest of the open time and start locking now */
+		SCHEDULER_stop(g_doorTimer);
+		motorSequenceNextStep();
+		break;
+
+	default:
+		/* the door is already locked or locking */
+		break;
+	}
+}
+
+/* Description:
+ * 	function to send the door & buzzer state to MC1.
+ */
+void sendDoorStatus(void)
+{
+	uint8 status[6];
+
+	status[0] = g_doorState;
+	status[1] = (g_buzzerTimer != SCHEDULER_INVALID_TIMER);
+	status[2] = (uint8)g_unlockTravelTime;
+	status[3] = (uint8)(g_unlockTravelTime >> 8);
+	status[4] = (uint8)g_lockTravelTime;
+	status[5] = (uint8)(g_lockTravelTime >> 8);
+	PROTOCOL_sendFrame(DOOR_STATUS, status, sizeof(status));
+}
+
+/* Description:
+ * 	function to activate the buzzer and start its sequence.
+ */
+void buzzer_IS_OPENED(void)
+{
+	if(g_buzzerTimer != SCHEDULER_INVALID_TIMER)
+	{
+		/* the buzzer is already on */
+		return;
+	}
 
 	Buzzer_on();
-	/* waits until the door open time be done then break the loop*/
-	while (g_tick != ERROR_TIME) {} ;
+	/* turn it off when the error time is done */
+	g_buzzerTimer = SCHEDULER_startOneShot(ERROR_TIME, buzzerSequenceEnd);
+}
 
+/* Description:
+ * 	scheduler task that turns the buzzer off after the error time.
+ */
+void buzzerSequenceEnd(void)
+{
 	/*after the error time finish , turn the buzzer OFF*/
 	Buzzer_off();
-
-	/* stop the timer */
-	Timer1_deInit();
-	/*set g_tick = 0 to clear it*/
-	g_tick = 0;
+	g_buzzerTimer = SCHEDULER_INVALID_TIMER;
 }
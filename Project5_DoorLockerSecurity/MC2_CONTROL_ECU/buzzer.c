@@ -20,10 +20,10 @@
 void Buzzer_init(void)
 {
 	/*Setup the direction for the buzzer pin as output pin*/
-	GPIO_setupPinDirection(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
+	GPIO_SETUP_PIN_DIRECTION(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
 
 	/* Turn off the buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_OFF);
+	GPIO_WRITE(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_OFF);
 }
 
 
@@ -36,7 +36,7 @@ void Buzzer_init(void)
 void Buzzer_on(void)
 {
 	/* Turn ON the buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_ON);
+	GPIO_WRITE(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_ON);
 }
 
 
@@ -49,5 +49,5 @@ void Buzzer_on(void)
 void Buzzer_off(void)
 {
 	/* Turn OFF the buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_OFF);
+	GPIO_WRITE(BUZZER_PORT_ID, BUZZER_PIN_ID, BUZZER_OFF);
 }
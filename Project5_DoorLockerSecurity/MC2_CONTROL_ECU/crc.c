@@ -0,0 +1,89 @@
+ /******************************************************************************
+ * Module: CRC
+ * File Name: crc.c
+ * Description: Source file for the CRC-8 calculation used to protect data
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"crc.h"
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Update the running CRC-8 value with one more byte and return the new value.
+ */
+uint8 CRC_crc8Update(uint8 crc, uint8 data)
+{
+	uint8 bit;
+
+	crc ^= data;
+	for(bit = 0; bit < 8; bit++)
+	{
+		if(crc & 0x80)
+		{
+			crc = (uint8)((crc << 1) ^ CRC8_POLYNOMIAL);
+		}
+		else
+		{
+			crc = (uint8)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+/*
+ * Description :
+ * Calculate the CRC-8 of size bytes starting from the CRC8_INITIAL_VALUE.
+ */
+uint8 CRC_crc8(const uint8 *data, uint8 size)
+{
+	uint8 crc = CRC8_INITIAL_VALUE;
+	uint8 i;
+
+	for(i = 0; i < size; i++)
+	{
+		crc = CRC_crc8Update(crc, data[i]);
+	}
+	return crc;
+}
+
+/*
+ * Description :
+ * Update the running CRC-16 value with one more byte and return the new value.
+ */
+uint16 CRC_crc16Update(uint16 crc, uint8 data)
+{
+	uint8 bit;
+
+	crc ^= (uint16)data << 8;
+	for(bit = 0; bit < 8; bit++)
+	{
+		if(crc & 0x8000)
+		{
+			crc = (uint16)((crc << 1) ^ CRC16_POLYNOMIAL);
+		}
+		else
+		{
+			crc = (uint16)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+/*
+ * Description :
+ * Calculate the CRC-16 of size bytes starting from the CRC16_INITIAL_VALUE.
+ */
+uint16 CRC_crc16(const uint8 *data, uint8 size)
+{
+	uint16 crc = CRC16_INITIAL_VALUE;
+	uint8 i;
+
+	for(i = 0; i < size; i++)
+	{
+		crc = CRC_crc16Update(crc, data[i]);
+	}
+	return crc;
+}
@@ -0,0 +1,465 @@
+ /******************************************************************************
+ * Module: Credential
+ * File Name: credential.c
+ * Description: Source file for the PIN holders table in the external EEPROM
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"credential.h"
+#include	"external_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * RAM index entry of each slot: empty, deleted or the tag of the stored digest (1 .. 254).
+ * A lookup walks the index from the hash slot and reads only the records with its tag,
+ * with 254 tags a wrong record is read for about one of 254 used slots in the walk.
+ */
+#define CREDENTIAL_INDEX_EMPTY			0x00
+#define CREDENTIAL_INDEX_DELETED		0xFF
+#define CREDENTIAL_TAGS					254
+
+/* Records read at once while the index is built */
+#define CREDENTIAL_RECORDS_PER_READ		(EEPROM_PAGE_SIZE / CREDENTIAL_RECORD_SIZE)
+
+#define CREDENTIAL_FILTER_MASK			(CREDENTIAL_FILTER_BITS - 1)
+
+#define CREDENTIAL_RECORD_ADDRESS(ID)	(CREDENTIAL_TABLE_ADDRESS + ((uint16)(ID) * CREDENTIAL_RECORD_SIZE))
+
+#if ((EEPROM_PAGE_SIZE % CREDENTIAL_RECORD_SIZE) != 0) || ((CREDENTIAL_TABLE_ADDRESS % CREDENTIAL_RECORD_SIZE) != 0)
+#error "a credential record should not cross an EEPROM page"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* Hash slot & tag of a PIN */
+typedef struct
+{
+	uint8 home;
+	uint8 tag;
+}CREDENTIAL_KeyType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8 g_index[CREDENTIAL_SLOTS];
+static uint8 g_count = 0;
+
+/* Bloom filter of the stored digests */
+static uint8 g_filter[CREDENTIAL_FILTER_BITS / 8];
+static uint16 g_filterRejected = 0;
+static uint16 g_filterFalsePositives = 0;
+
+/* State of the interrupt driven lookup */
+static const uint8 *g_lookupDigest;
+static CREDENTIAL_KeyType g_lookupKey;
+static uint8 g_lookupProbe;				/* slots walked from the hash slot */
+static boolean g_lookupFiltered = FALSE;	/* passed by the Bloom filter */
+static boolean g_lookupReading = FALSE;
+static EEPROM_RequestType g_lookupRequest;
+static uint8 g_lookupRecord[CREDENTIAL_RECORD_SIZE];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * The first two bytes of the digest select the slot and the third one the tag,
+ * the keyed digest spreads the PINs evenly.
+ */
+static CREDENTIAL_KeyType CREDENTIAL_key(const uint8 *digest);
+
+/*
+ * Description :
+ * Set the filter bits of the digest, or only check them when add is FALSE.
+ * Return: TRUE if all the bits were already set, the PIN may be in the table.
+ */
+static boolean CREDENTIAL_filter(const uint8 *digest, boolean add);
+
+/*
+ * Description :
+ * Build the filter again from the records of the holders in the index, the bits of the
+ * removed holders are cleared. If a record can't be read all the bits are set, no PIN
+ * is rejected by the filter until it is built again.
+ */
+static void CREDENTIAL_filterBuild(void);
+
+/*
+ * Description :
+ * End of a lookup that found no holder, counted as a false positive of the filter.
+ */
+static CREDENTIAL_StatusType CREDENTIAL_lookupMiss(void);
+
+/*
+ * Description :
+ * Return TRUE if the record read from the EEPROM holds the digest, the digests
+ * are compared in a constant time.
+ */
+static boolean CREDENTIAL_recordHolds(const uint8 *record, const uint8 *digest);
+
+/*
+ * Description :
+ * Walk the index & read the candidate records while waiting.
+ * Return: the id of the PIN or CREDENTIAL_INVALID_ID, free_id is the first slot
+ * where the PIN can be added or CREDENTIAL_INVALID_ID if the table is full.
+ */
+static uint8 CREDENTIAL_find(const uint8 *digest, uint8 *free_id);
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+static CREDENTIAL_KeyType CREDENTIAL_key(const uint8 *digest)
+{
+	CREDENTIAL_KeyType key;
+
+	key.home = (uint8)((((uint16)digest[1] << 8) | digest[0]) % CREDENTIAL_SLOTS);
+	key.tag = (uint8)((digest[2] % CREDENTIAL_TAGS) + 1);
+	return key;
+}
+
+static boolean CREDENTIAL_filter(const uint8 *digest, boolean add)
+{
+	/* two 16-bit hashes from the bytes the index doesn't use, h2 odd to reach all the bits */
+	uint16 bit = ((uint16)digest[4] << 8) | digest[3];
+	uint16 step = (((uint16)digest[6] << 8) | digest[5]) | 1;
+	boolean found = TRUE;
+	uint8 mask;
+	uint8 i;
+
+	for(i = 0; i < CREDENTIAL_FILTER_HASHES; i++)
+	{
+		mask = (uint8)(1 << (bit & 7));
+		if((g_filter[(bit & CREDENTIAL_FILTER_MASK) >> 3] & mask) == 0)
+		{
+			if(!add)
+			{
+				return FALSE;
+			}
+			found = FALSE;
+			g_filter[(bit & CREDENTIAL_FILTER_MASK) >> 3] |= mask;
+		}
+		bit += step;
+	}
+	return found;
+}
+
+static void CREDENTIAL_filterBuild(void)
+{
+	uint8 record[CREDENTIAL_RECORD_SIZE];
+	uint8 fill = 0x00;
+	uint16 byte;
+	uint8 id;
+
+	for(byte = 0; byte < sizeof(g_filter); byte++)
+	{
+		g_filter[byte] = 0x00;
+	}
+	for(id = 0; id < CREDENTIAL_SLOTS; id++)
+	{
+		if((g_index[id] == CREDENTIAL_INDEX_EMPTY) || (g_index[id] == CREDENTIAL_INDEX_DELETED))
+		{
+			continue;
+		}
+		if((EEPROM_readBlock(CREDENTIAL_RECORD_ADDRESS(id), record, CREDENTIAL_RECORD_SIZE) != SUCCESS) ||
+				(record[0] != CREDENTIAL_STATE_USED))
+		{
+			fill = 0xFF;
+			break;
+		}
+		(void)CREDENTIAL_filter(&record[1], TRUE);
+	}
+
+	if(fill != 0x00)
+	{
+		for(byte = 0; byte < sizeof(g_filter); byte++)
+		{
+			g_filter[byte] = fill;
+		}
+	}
+}
+
+static CREDENTIAL_StatusType CREDENTIAL_lookupMiss(void)
+{
+	if(g_lookupFiltered)
+	{
+		g_lookupFiltered = FALSE;
+		g_filterFalsePositives++;
+	}
+	return CREDENTIAL_NOT_FOUND;
+}
+
+static boolean CREDENTIAL_recordHolds(const uint8 *record, const uint8 *digest)
+{
+	return (record[0] == CREDENTIAL_STATE_USED) && PIN_HASH_equal(&record[1], digest, CREDENTIAL_DIGEST_SIZE);
+}
+
+static uint8 CREDENTIAL_find(const uint8 *digest, uint8 *free_id)
+{
+	CREDENTIAL_KeyType key = CREDENTIAL_key(digest);
+	uint8 record[CREDENTIAL_RECORD_SIZE];
+	boolean maybe = CREDENTIAL_filter(digest, FALSE);
+	uint8 probe;
+	uint8 id = key.home;
+
+	*free_id = CREDENTIAL_INVALID_ID;
+	for(probe = 0; probe < CREDENTIAL_SLOTS; probe++)
+	{
+		if((g_index[id] == CREDENTIAL_INDEX_EMPTY) || (g_index[id] == CREDENTIAL_INDEX_DELETED))
+		{
+			if(*free_id == CREDENTIAL_INVALID_ID)
+			{
+				*free_id = id;
+			}
+			if(g_index[id] == CREDENTIAL_INDEX_EMPTY)
+			{
+				/* the PIN would have been added here, it isn't in the table */
+				break;
+			}
+		}
+		else if(maybe && (g_index[id] == key.tag) &&
+				(EEPROM_readBlock(CREDENTIAL_RECORD_ADDRESS(id), record, CREDENTIAL_RECORD_SIZE) == SUCCESS) &&
+				CREDENTIAL_recordHolds(record, digest))
+		{
+			return id;
+		}
+
+		id = (id + 1 == CREDENTIAL_SLOTS) ? 0 : (id + 1);
+	}
+	return CREDENTIAL_INVALID_ID;
+}
+
+void CREDENTIAL_init(void)
+{
+	uint8 records[CREDENTIAL_RECORDS_PER_READ * CREDENTIAL_RECORD_SIZE];
+	uint8 *record;
+	uint16 byte;
+	uint8 id;
+	uint8 i;
+
+	g_count = 0;
+	g_lookupReading = FALSE;
+	for(byte = 0; byte < sizeof(g_filter); byte++)
+	{
+		g_filter[byte] = 0;
+	}
+	for(id = 0; id < CREDENTIAL_SLOTS; id += CREDENTIAL_RECORDS_PER_READ)
+	{
+		if(EEPROM_readBlock(CREDENTIAL_RECORD_ADDRESS(id), records, sizeof(records)) != SUCCESS)
+		{
+			/* keep the probing going past the unknown records */
+			for(i = 0; (i < CREDENTIAL_RECORDS_PER_READ) && (id + i < CREDENTIAL_SLOTS); i++)
+			{
+				g_index[id + i] = CREDENTIAL_INDEX_DELETED;
+			}
+			continue;
+		}
+
+		for(i = 0; (i < CREDENTIAL_RECORDS_PER_READ) && (id + i < CREDENTIAL_SLOTS); i++)
+		{
+			record = &records[i * CREDENTIAL_RECORD_SIZE];
+			if(record[0] == CREDENTIAL_STATE_USED)
+			{
+				g_index[id + i] = CREDENTIAL_key(&record[1]).tag;
+				(void)CREDENTIAL_filter(&record[1], TRUE);
+				g_count++;
+			}
+			else if(record[0] == CREDENTIAL_STATE_EMPTY)
+			{
+				g_index[id + i] = CREDENTIAL_INDEX_EMPTY;
+			}
+			else
+			{
+				g_index[id + i] = CREDENTIAL_INDEX_DELETED;
+			}
+		}
+	}
+}
+
+CREDENTIAL_StatusType CREDENTIAL_add(const uint8 *digest, uint8 *id)
+{
+	uint8 record[CREDENTIAL_RECORD_SIZE];
+	uint8 free_id;
+	uint8 i;
+
+	*id = CREDENTIAL_find(digest, &free_id);
+	if(*id != CREDENTIAL_INVALID_ID)
+	{
+		return CREDENTIAL_EXISTS;
+	}
+	if(free_id == CREDENTIAL_INVALID_ID)
+	{
+		return CREDENTIAL_FULL;
+	}
+
+	record[0] = CREDENTIAL_STATE_USED;
+	for(i = 0; i < CREDENTIAL_DIGEST_SIZE; i++)
+	{
+		record[1 + i] = digest[i];
+	}
+
+	/* the whole record is in one page, it is written in one write cycle */
+	if((EEPROM_writePage(CREDENTIAL_RECORD_ADDRESS(free_id), record, CREDENTIAL_RECORD_SIZE) != SUCCESS) ||
+			(EEPROM_flush() != SUCCESS))
+	{
+		/* a record left dirty in the cache would reach the eeprom later and be loaded at boot */
+		EEPROM_cacheDiscard(CREDENTIAL_RECORD_ADDRESS(free_id), CREDENTIAL_RECORD_SIZE);
+		return CREDENTIAL_EEPROM_ERROR;
+	}
+
+	g_index[free_id] = CREDENTIAL_key(digest).tag;
+	(void)CREDENTIAL_filter(digest, TRUE);
+	g_count++;
+	*id = free_id;
+	return CREDENTIAL_OK;
+}
+
+CREDENTIAL_StatusType CREDENTIAL_remove(uint8 id)
+{
+	if((id >= CREDENTIAL_SLOTS) || (g_index[id] == CREDENTIAL_INDEX_EMPTY) || (g_index[id] == CREDENTIAL_INDEX_DELETED))
+	{
+		return CREDENTIAL_NOT_FOUND;
+	}
+
+	/* the slot stays deleted, not empty, so the walks of the next PINs go on past it */
+	if((EEPROM_writeByte(CREDENTIAL_RECORD_ADDRESS(id), CREDENTIAL_STATE_DELETED) != SUCCESS) ||
+			(EEPROM_flush() != SUCCESS))
+	{
+		EEPROM_cacheDiscard(CREDENTIAL_RECORD_ADDRESS(id), CREDENTIAL_RECORD_SIZE);
+		return CREDENTIAL_EEPROM_ERROR;
+	}
+
+	g_index[id] = CREDENTIAL_INDEX_DELETED;
+	g_count--;
+
+	/* the bits of a Bloom filter can't be cleared one PIN at a time, they may be shared */
+	CREDENTIAL_filterBuild();
+	return CREDENTIAL_OK;
+}
+
+uint8 CREDENTIAL_count(void)
+{
+	return g_count;
+}
+
+void CREDENTIAL_list(uint8 *bitmap)
+{
+	uint8 id;
+
+	for(id = 0; id < CREDENTIAL_BITMAP_SIZE; id++)
+	{
+		bitmap[id] = 0;
+	}
+	for(id = 0; id < CREDENTIAL_SLOTS; id++)
+	{
+		if((g_index[id] != CREDENTIAL_INDEX_EMPTY) && (g_index[id] != CREDENTIAL_INDEX_DELETED))
+		{
+			bitmap[id / 8] |= (uint8)(1 << (id % 8));
+		}
+	}
+}
+
+void CREDENTIAL_filterInfo(CREDENTIAL_FilterInfoType *info)
+{
+	uint32 rate;
+	uint32 fill;
+	uint16 i;
+	uint8 byte;
+
+	info->bits = CREDENTIAL_FILTER_BITS;
+	info->hashes = CREDENTIAL_FILTER_HASHES;
+	info->bitsSet = 0;
+	for(i = 0; i < sizeof(g_filter); i++)
+	{
+		for(byte = g_filter[i]; byte != 0; byte &= (uint8)(byte - 1))
+		{
+			info->bitsSet++;
+		}
+	}
+	info->entries = g_count;
+	info->rejected = g_filterRejected;
+	info->falsePositives = g_filterFalsePositives;
+
+	/* a false positive finds all its k bits set, the fill is kept below 1 to stay in 16 bits */
+	fill = ((uint32)info->bitsSet << CREDENTIAL_FILTER_RATE_SHIFT) / CREDENTIAL_FILTER_BITS;
+	if(fill > 0xFFFF)
+	{
+		fill = 0xFFFF;
+	}
+	rate = fill;
+	for(i = 1; i < CREDENTIAL_FILTER_HASHES; i++)
+	{
+		rate = (rate * fill) >> CREDENTIAL_FILTER_RATE_SHIFT;
+	}
+	info->falsePositiveRate = (uint16)rate;
+}
+
+void CREDENTIAL_lookupStart(const uint8 *digest)
+{
+	g_lookupDigest = digest;
+	g_lookupKey = CREDENTIAL_key(digest);
+	g_lookupProbe = 0;
+	g_lookupReading = FALSE;
+	g_lookupFiltered = CREDENTIAL_filter(digest, FALSE);
+	if(!g_lookupFiltered)
+	{
+		/* not a holder for sure, the poll ends without a walk or a TWI transfer */
+		g_lookupProbe = CREDENTIAL_SLOTS;
+		g_filterRejected++;
+	}
+}
+
+CREDENTIAL_StatusType CREDENTIAL_lookupPoll(void)
+{
+	uint8 id = 0;
+
+	for(;;)
+	{
+		if(g_lookupReading)
+		{
+			if(g_lookupRequest.transaction.status == TWI_PENDING)
+			{
+				return CREDENTIAL_PENDING;
+			}
+			g_lookupReading = FALSE;
+			if(g_lookupRequest.transaction.status != TWI_DONE)
+			{
+				return CREDENTIAL_EEPROM_ERROR;
+			}
+			if(CREDENTIAL_recordHolds(g_lookupRecord, g_lookupDigest))
+			{
+				g_lookupFiltered = FALSE;
+				return CREDENTIAL_OK;
+			}
+			/* another PIN with the same tag, go on with the next slot */
+			g_lookupProbe++;
+		}
+
+		for(; g_lookupProbe < CREDENTIAL_SLOTS; g_lookupProbe++)
+		{
+			id = (uint8)(((uint16)g_lookupKey.home + g_lookupProbe) % CREDENTIAL_SLOTS);
+			if(g_index[id] == CREDENTIAL_INDEX_EMPTY)
+			{
+				return CREDENTIAL_lookupMiss();
+			}
+			if(g_index[id] == g_lookupKey.tag)
+			{
+				break;
+			}
+		}
+		if(g_lookupProbe == CREDENTIAL_SLOTS)
+		{
+			return CREDENTIAL_lookupMiss();
+		}
+
+		/* a record in the EEPROM cache is read at once, it is checked in the next pass */
+		if(EEPROM_readBlockAsync(&g_lookupRequest, CREDENTIAL_RECORD_ADDRESS(id), g_lookupRecord,
+				CREDENTIAL_RECORD_SIZE, NULL_PTR) != SUCCESS)
+		{
+			return CREDENTIAL_EEPROM_ERROR;
+		}
+		g_lookupReading = TRUE;
+	}
+}
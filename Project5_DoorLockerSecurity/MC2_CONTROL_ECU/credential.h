@@ -0,0 +1,146 @@
+ /******************************************************************************
+ * Module: Credential
+ * File Name: credential.h
+ * Description: Header file for the PIN holders table in the external EEPROM,
+ *              found through an open addressing index kept in RAM
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef CREDENTIAL_H_
+#define CREDENTIAL_H_
+
+#include	"std_types.h"
+#include	"pin_hash.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * EEPROM Layout:
+ * 	CREDENTIAL_SLOTS records of CREDENTIAL_RECORD_SIZE bytes from CREDENTIAL_TABLE_ADDRESS,
+ * 	| STATE | DIGEST[CREDENTIAL_DIGEST_SIZE] |
+ * DIGEST is the start of the PIN_HASH digest of the PIN, the PIN itself isn't stored.
+ * The records are aligned so a record never crosses an EEPROM page.
+ * A PIN is kept in the slot selected by its digest or in the next free slots (linear probing).
+ */
+#define CREDENTIAL_TABLE_ADDRESS		0x100
+#define CREDENTIAL_RECORD_SIZE			8
+#define CREDENTIAL_SLOTS				200
+#define CREDENTIAL_DIGEST_SIZE			(CREDENTIAL_RECORD_SIZE - 1)
+
+/* Record states, an erased EEPROM reads 0xFF */
+#define CREDENTIAL_STATE_EMPTY			0xFF
+#define CREDENTIAL_STATE_DELETED		0x00
+#define CREDENTIAL_STATE_USED			0x01
+
+/* Returned instead of an id when no record is found */
+#define CREDENTIAL_INVALID_ID			0xFF
+
+/* Bytes of the bitmap of the used ids in the CREDENTIAL_LIST_DATA frame */
+#define CREDENTIAL_BITMAP_SIZE			((CREDENTIAL_SLOTS + 7) / 8)
+
+/*
+ * Bloom filter of the stored digests kept in RAM, a PIN that isn't in the filter is rejected
+ * without walking the index or reading the EEPROM. Its bits are taken from the digest bytes
+ * after the index ones (h1 + i * h2), it is built again from the table when a holder is removed.
+ * With n holders the false positive rate is about (1 - e^(-k * n / m))^k, about 3 in 100000
+ * for 20 holders & 1 in 90 for 100 holders.
+ */
+#define CREDENTIAL_FILTER_BITS			1024	/* m, a power of two */
+#define CREDENTIAL_FILTER_HASHES		4		/* k */
+
+/* Unit of the false positive rate in the filter information, 1 / 65536 */
+#define CREDENTIAL_FILTER_RATE_SHIFT	16
+
+#if (CREDENTIAL_SLOTS >= CREDENTIAL_INVALID_ID)
+#error "the credential ids should fit in one byte"
+#endif
+
+#if (CREDENTIAL_DIGEST_SIZE > PIN_HASH_DIGEST_SIZE)
+#error "the record holds a part of the PIN digest"
+#endif
+
+#if ((CREDENTIAL_FILTER_BITS & (CREDENTIAL_FILTER_BITS - 1)) != 0) || (CREDENTIAL_FILTER_BITS > 0x8000)
+#error "the filter size should be a power of two up to 32768 bits"
+#endif
+
+#if (CREDENTIAL_DIGEST_SIZE < 7)
+#error "the filter bits are taken from the digest bytes 3 .. 6 kept in the record"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	CREDENTIAL_OK, CREDENTIAL_PENDING, CREDENTIAL_NOT_FOUND, CREDENTIAL_EXISTS, CREDENTIAL_FULL,
+	CREDENTIAL_EEPROM_ERROR, CREDENTIAL_INVALID_PIN
+}CREDENTIAL_StatusType;
+
+/* State of the Bloom filter, sent in the CREDENTIAL_FILTER_DATA frame */
+typedef struct
+{
+	uint16 bits;				/* size m */
+	uint8 hashes;				/* bits set by each PIN k */
+	uint16 bitsSet;
+	uint8 entries;				/* PINs in the filter, the holders */
+	uint16 falsePositiveRate;	/* (bitsSet / m)^k in 1 / 65536 */
+	uint16 rejected;			/* lookups ended by the filter */
+	uint16 falsePositives;		/* lookups passed by the filter that found no holder */
+}CREDENTIAL_FilterInfoType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the whole table once and build the RAM index, it should be called after TWI_init.
+ */
+void CREDENTIAL_init(void);
+
+/*
+ * Description :
+ * Save a new PIN holder in a free slot, digest is the PIN_HASH digest of the PIN.
+ * Return: CREDENTIAL_OK with its id, CREDENTIAL_EXISTS with the id of the same PIN,
+ * CREDENTIAL_FULL or CREDENTIAL_EEPROM_ERROR.
+ */
+CREDENTIAL_StatusType CREDENTIAL_add(const uint8 *digest, uint8 *id);
+
+/*
+ * Description :
+ * Delete the PIN holder, its slot becomes free for the next add and the Bloom filter is
+ * built again from the records of the other holders.
+ * Return: CREDENTIAL_OK, CREDENTIAL_NOT_FOUND or CREDENTIAL_EEPROM_ERROR.
+ */
+CREDENTIAL_StatusType CREDENTIAL_remove(uint8 id);
+
+/*
+ * Description :
+ * Number of PIN holders and the bitmap of their ids (bit id % 8 of byte id / 8).
+ */
+uint8 CREDENTIAL_count(void);
+void CREDENTIAL_list(uint8 *bitmap);
+
+/*
+ * Description :
+ * Size, fill & estimated false positive rate of the Bloom filter and the counts of the
+ * lookups it ended or passed in vain.
+ */
+void CREDENTIAL_filterInfo(CREDENTIAL_FilterInfoType *info);
+
+/*
+ * Description :
+ * Start looking for the PIN digest without waiting, a PIN that isn't in the Bloom filter
+ * ends at once, otherwise only the records with the same index tag are read from the
+ * EEPROM on the interrupt driven TWI. The digest must stay valid until the lookup ends.
+ */
+void CREDENTIAL_lookupStart(const uint8 *digest);
+
+/*
+ * Description :
+ * Continue the lookup, it should be called from the main loop until it ends.
+ * Return: CREDENTIAL_PENDING, CREDENTIAL_OK, CREDENTIAL_NOT_FOUND or CREDENTIAL_EEPROM_ERROR.
+ */
+CREDENTIAL_StatusType CREDENTIAL_lookupPoll(void);
+
+#endif /* CREDENTIAL_H_ */
@@ -7,52 +7,230 @@
 #include "gpio.h"
 #include "dc_motor.h"
 #include "pwm.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
 
 /*******************************************************************************
- *                              Functions Definitions                         *
+ *                                Definitions                                  *
  *******************************************************************************/
-/*
- * Description:
- * The Function responsible for setup the direction for the two motor pins through the GPIO driver.
-   Stop at the DC-Motor at the beginning through the GPIO driver.*/
-void DcMotor_init(void)
-{
-	GPIO_setupPinDirection(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,PIN_OUTPUT);	/* PC0 Output Pin */
-	GPIO_setupPinDirection(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,PIN_OUTPUT);	/* PC1 Output Pin */
+/* Progress along a ramp goes from 0 to DC_MOTOR_RAMP_END */
+#define DC_MOTOR_RAMP_SHIFT			8
+#define DC_MOTOR_RAMP_END			(1 << DC_MOTOR_RAMP_SHIFT)
 
-	/* Turn off the motor */
-	GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,LOGIC_LOW);
-	GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,LOGIC_LOW);
-}
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* The running motion profile, NULL_PTR when no profile runs */
+static const DcMotor_ProfileType *volatile g_profile = NULL_PTR;
 
+/* Time since the start of the running profile in ms */
+static volatile uint32 g_profileTime = 0;
 
-/*
- * The function responsible for rotate the DC Motor CW/ or A-CW or stop the motor based on the state input state value.
- * Send the required duty cycle to the PWM driver based on the required speed value.*/
+/* Ticks since the last duty cycle update */
+static volatile uint8 g_profileTicks = 0;
 
-void DcMotor_Rotate(DcMotor_State state,uint8 speed)
+/*******************************************************************************
+ *                              Functions Definitions                         *
+ *******************************************************************************/
+/*
+ * Description:
+ * Drive the H-bridge inputs for the state, both direction pins change in one store,
+ * so the H-bridge never sees both inputs high.*/
+static void DcMotor_setDirection(DcMotor_State state)
 {
-	PWM_Timer0_Start(speed);
 	switch(state)
 	{
 	case OFF:
 		/* Stop the motor */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,LOGIC_LOW);
+		GPIO_writeMasked(DC_MOTOR_PORT_ID,DC_MOTOR_PINS_MASK,LOGIC_LOW);
 		break;
 	case CW:
 		/* Rotates the motor CW */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,LOGIC_HIGH);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,LOGIC_LOW);
+		GPIO_writeMasked(DC_MOTOR_PORT_ID,DC_MOTOR_PINS_MASK,(1 << DC_MOTOR_First_PIN_ID));
 		break;
 
 	case ACW:
 		/* Rotates the motor ACW */
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,LOGIC_HIGH);
+		GPIO_writeMasked(DC_MOTOR_PORT_ID,DC_MOTOR_PINS_MASK,(1 << DC_MOTOR_Second_PIN_ID));
 		break;
 	default:
 		/*Do Nothing*/
 	break;
 	}
 }
+
+/*
+ * Description:
+ * Duty cycle after ramp_time_ms of a ramp of length ramp_length_ms towards speed,
+ * the progress is kept in 1/256 steps so only one division is needed.
+ * The S-curve uses the smoothstep p^2 * (3 - 2p) of the linear progress p.*/
+static uint8 DcMotor_rampDuty(DcMotor_RampType ramp, uint8 speed, uint32 ramp_time_ms, uint16 ramp_length_ms)
+{
+	uint32 progress = (ramp_time_ms << DC_MOTOR_RAMP_SHIFT) / ramp_length_ms;
+
+	if(ramp == DC_MOTOR_S_CURVE)
+	{
+		progress = (progress * progress * ((3 * DC_MOTOR_RAMP_END) - (2 * progress))) >> (2 * DC_MOTOR_RAMP_SHIFT);
+	}
+	return (uint8)(((uint16)speed * progress) >> DC_MOTOR_RAMP_SHIFT);
+}
+
+/*
+ * Description:
+ * Part of the ramp distance covered after ramp_time_ms, scaled by 2^16 of the ramp length at full speed:
+ * u^2 / 2 for the linear ramp & u^3 - u^4 / 2 (the integral of the smoothstep) for the S-curve,
+ * both reach one half at the end of the ramp.*/
+static uint32 DcMotor_rampDistance(DcMotor_RampType ramp, uint32 ramp_time_ms, uint16 ramp_length_ms)
+{
+	uint32 progress = (ramp_time_ms << DC_MOTOR_RAMP_SHIFT) / ramp_length_ms;
+	uint32 cube;
+	if(ramp == DC_MOTOR_S_CURVE)
+	{
+		cube = progress * progress * progress;
+		return (cube - (((cube >> 1) * progress) >> DC_MOTOR_RAMP_SHIFT)) >> DC_MOTOR_RAMP_SHIFT;
+	}
+	return (progress * progress) >> 1;
+}
+/*
+ * Description:
+ * Update the duty cycle of the running profile for its current time, stop the motor
+ * at the end of the profile. Called with the interrupts disabled or from the tick.*/
+static void DcMotor_profileUpdate(void)
+{
+	const DcMotor_ProfileType *profile = g_profile;
+	uint32 time = g_profileTime;
+
+	if(time < profile->accel_time_ms)
+	{
+		PWM_Timer0_setDuty(DcMotor_rampDuty(profile->ramp, profile->speed, time, profile->accel_time_ms));
+		return;
+	}
+	time -= profile->accel_time_ms;
+
+	if(time < profile->cruise_time_ms)
+	{
+		PWM_Timer0_setDuty(profile->speed);
+		return;
+	}
+	time -= profile->cruise_time_ms;
+
+	if(time < profile->decel_time_ms)
+	{
+		/* the deceleration is the acceleration ramp played backwards */
+		PWM_Timer0_setDuty(DcMotor_rampDuty(profile->ramp, profile->speed,
+				profile->decel_time_ms - time, profile->decel_time_ms));
+		return;
+	}
+
+	/* End of the profile */
+	DcMotor_setDirection(OFF);
+	PWM_Timer0_setDuty(0);
+	g_profile = NULL_PTR;
+}
+
+/*
+ * Description:
+ * The Function responsible for setup the direction for the two motor pins through the GPIO driver.
+   Stop at the DC-Motor at the beginning through the GPIO driver.*/
+void DcMotor_init(void)
+{
+	GPIO_SETUP_PIN_DIRECTION(DC_MOTOR_PORT_ID,DC_MOTOR_First_PIN_ID,PIN_OUTPUT);	/* PC0 Output Pin */
+	GPIO_SETUP_PIN_DIRECTION(DC_MOTOR_PORT_ID,DC_MOTOR_Second_PIN_ID,PIN_OUTPUT);	/* PC1 Output Pin */
+
+	/* Turn off the motor */
+	GPIO_writeMasked(DC_MOTOR_PORT_ID,DC_MOTOR_PINS_MASK,LOGIC_LOW);
+
+	/* Timer0 runs from now on, the speed changes only update its duty cycle */
+	PWM_Timer0_Start(0);
+}
+
+
+/*
+ * The function responsible for rotate the DC Motor CW/ or A-CW or stop the motor based on the state input state value.
+ * Send the required duty cycle to the PWM driver based on the required speed value.*/
+
+void DcMotor_Rotate(DcMotor_State state,uint8 speed)
+{
+	uint8 sreg = SREG;
+
+	/* a direct command ends the running profile */
+	cli();
+	g_profile = NULL_PTR;
+	SREG = sreg;
+
+	PWM_Timer0_setDuty(speed);
+	DcMotor_setDirection(state);
+}
+
+/*
+ * The function responsible for moving the DC Motor along the profile in the direction.
+ * The first duty cycle is applied at once, then DcMotor_tick ramps it.*/
+void DcMotor_moveProfile(DcMotor_State direction,const DcMotor_ProfileType *profile)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	g_profile = profile;
+	g_profileTime = 0;
+	g_profileTicks = 0;
+	DcMotor_profileUpdate();
+	if(g_profile != NULL_PTR)
+	{
+		DcMotor_setDirection(direction);
+	}
+	SREG = sreg;
+}
+
+/*
+ * The function responsible for running the motion profile, the duty cycle is
+ * updated every DC_MOTOR_PROFILE_STEP_MS to keep the tick short.*/
+void DcMotor_tick(void)
+{
+	if(g_profile == NULL_PTR)
+	{
+		return;
+	}
+
+	g_profileTime += DC_MOTOR_TICK_MS;
+	g_profileTicks++;
+	if(g_profileTicks >= (DC_MOTOR_PROFILE_STEP_MS / DC_MOTOR_TICK_MS))
+	{
+		g_profileTicks = 0;
+		DcMotor_profileUpdate();
+	}
+}
+
+boolean DcMotor_isMoving(void)
+{
+	return (g_profile != NULL_PTR) ? TRUE : FALSE;
+}
+/*
+ * The function returns the distance covered along the profile, each phase adds its part
+ * at the profile speed and the result is scaled to 100% duty cycle at the end.*/
+uint32 DcMotor_profileDistance(const DcMotor_ProfileType *profile, uint32 time_ms)
+{
+	uint32 distance = 0;	/* in ms at the profile speed */
+	if(time_ms < profile->accel_time_ms)
+	{
+		distance = (DcMotor_rampDistance(profile->ramp, time_ms, profile->accel_time_ms) *
+				profile->accel_time_ms) >> (2 * DC_MOTOR_RAMP_SHIFT);
+		return (distance * profile->speed) / 100;
+	}
+	distance = profile->accel_time_ms / 2;
+	time_ms -= profile->accel_time_ms;
+	if(time_ms < profile->cruise_time_ms)
+	{
+		return ((distance + time_ms) * profile->speed) / 100;
+	}
+	distance += profile->cruise_time_ms;
+	time_ms -= profile->cruise_time_ms;
+	if(time_ms < profile->decel_time_ms)
+	{
+		/* the deceleration is the acceleration ramp played backwards, the part still to go is left out */
+		distance += (profile->decel_time_ms / 2) - ((DcMotor_rampDistance(profile->ramp,
+				profile->decel_time_ms - time_ms, profile->decel_time_ms) * profile->decel_time_ms) >> (2 * DC_MOTOR_RAMP_SHIFT));
+		return (distance * profile->speed) / 100;
+	}
+	distance += profile->decel_time_ms / 2;
+	return (distance * profile->speed) / 100;
+}
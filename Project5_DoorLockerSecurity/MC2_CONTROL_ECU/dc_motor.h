@@ -7,25 +7,51 @@
 #ifndef DC_MOTOR_H_
 #define DC_MOTOR_H_
 
+#include "std_types.h"
+
 /*******************************************************************************
  *                         Types Declaration                                   *
  *******************************************************************************/
 #define DC_MOTOR_PORT_ID						PORTB_ID
 #define DC_MOTOR_First_PIN_ID					PIN0_ID
 #define DC_MOTOR_Second_PIN_ID					PIN1_ID
+#define DC_MOTOR_PINS_MASK						((1 << DC_MOTOR_First_PIN_ID) | (1 << DC_MOTOR_Second_PIN_ID))
+
+/* Time between two calls of DcMotor_tick in ms */
+#define DC_MOTOR_TICK_MS						1
+
+/* The duty cycle of a running profile is updated every DC_MOTOR_PROFILE_STEP_MS */
+#define DC_MOTOR_PROFILE_STEP_MS				10
 
 typedef enum
 {
 	OFF, CW, ACW
 }DcMotor_State;
 
+typedef enum
+{
+	DC_MOTOR_TRAPEZOIDAL,	/* the duty cycle changes linearly along the ramps */
+	DC_MOTOR_S_CURVE		/* the duty cycle starts & ends each ramp slowly (smoothstep) */
+}DcMotor_RampType;
+
+/* Motion profile: ramp up to speed, cruise, ramp down to zero then stop */
+typedef struct
+{
+	DcMotor_RampType ramp;
+	uint8 speed;				/* duty cycle in percent while cruising */
+	uint16 accel_time_ms;
+	uint16 cruise_time_ms;
+	uint16 decel_time_ms;
+}DcMotor_ProfileType;
+
 /*******************************************************************************
  *                              Functions Prototypes                           *
  *******************************************************************************/
 /*
  * decription:
  * The Function responsible for setup the direction for the two motor pins through the GPIO driver.
-   Stop at the DC-Motor at the beginning through the GPIO driver.*/
+   Stop at the DC-Motor at the beginning through the GPIO driver.
+   Start the Timer0 PWM with zero duty cycle, DcMotor_Rotate only changes its duty.*/
 void DcMotor_init(void);
 
 /*
@@ -34,5 +60,25 @@ void DcMotor_init(void);
 
 void DcMotor_Rotate(DcMotor_State state,uint8 speed);
 
+/*
+ * The function responsible for moving the DC Motor along the profile in the direction, the duty cycle
+ * is ramped by DcMotor_tick and the motor stops at the end of the profile. The profile must stay valid
+ * until the end of the move, a call of DcMotor_Rotate or DcMotor_moveProfile ends the move.*/
+void DcMotor_moveProfile(DcMotor_State direction,const DcMotor_ProfileType *profile);
+
+/*
+ * The function responsible for running the motion profile, it should be called every DC_MOTOR_TICK_MS
+ * from the timer interrupt (the Timer 1 call back).*/
+void DcMotor_tick(void);
+
+/*
+ * The function returns TRUE while a motion profile is running.*/
+boolean DcMotor_isMoving(void);
+
+/*
+ * The function returns the distance covered after time_ms along the profile, in ms at 100% duty cycle
+ * (the integral of the duty cycle), the whole profile covers speed * (accel/2 + cruise + decel/2) / 100.*/
+uint32 DcMotor_profileDistance(const DcMotor_ProfileType *profile, uint32 time_ms);
+
 #endif	/* DC_MOTOR_H_*/
 
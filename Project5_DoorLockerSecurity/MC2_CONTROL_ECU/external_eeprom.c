@@ -6,67 +6,621 @@
  *******************************************************************************/
 #include "external_eeprom.h"
 #include "twi.h"
+#include <util/delay.h>
+
+#ifdef EEPROM_CACHE_ENABLE
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* Cache line flags */
+#define EEPROM_CACHE_VALID			(1 << 0)	/* the line holds its block */
+#define EEPROM_CACHE_DIRTY			(1 << 1)	/* the line was written, the eeprom is older */
+#define EEPROM_CACHE_PINNED			(1 << 2)	/* loaded by EEPROM_cacheLoad, never replaced */
+
+#define EEPROM_CACHE_NO_LINE		0xFF
+
+/* Number of the eeprom page (cache block) of a memory location */
+#define EEPROM_CACHE_BLOCK(ADDR)	((uint8)((ADDR) / EEPROM_CACHE_LINE_SIZE))
+
+#if (EEPROM_CACHE_LINE_SIZE != EEPROM_PAGE_SIZE)
+#error "a cache line should be written back in one eeprom page write"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 data[EEPROM_CACHE_LINE_SIZE];
+	uint8 block;
+	uint8 flags;
+	uint16 used;			/* cache clock of the last access, the smallest is replaced first */
+}EEPROM_CacheLineType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static EEPROM_CacheLineType g_cache[EEPROM_CACHE_LINES];
+static uint16 g_cacheClock = 0;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Send the Start Bit, the device address with R/W=0 (write) and the memory location address.
+ * On an error the Stop Bit is sent, a bus left held would make the next start a repeated one.
+ */
+static uint8 EEPROM_startWriteAt(uint16 u16addr);
+
+/*
+ * Description :
+ * Transfers with the eeprom itself, the public functions put the cache in front of them.
+ */
+static uint8 EEPROM_deviceWritePage(uint16 u16addr,const uint8 *u8data,uint16 size);
+static uint8 EEPROM_deviceReadBlock(uint16 u16addr,uint8 *u8data,uint16 size);
+static uint8 EEPROM_deviceReadAsync(EEPROM_RequestType *request,uint16 u16addr,uint8 *u8data,uint8 size,
+		void (*callBack)(TWI_TransactionType *transaction));
+
+#ifdef EEPROM_CACHE_ENABLE
+/*
+ * Description :
+ * Return the line that holds the block, or EEPROM_CACHE_NO_LINE.
+ */
+static uint8 EEPROM_cacheFind(uint8 block);
+
+/*
+ * Description :
+ * Return the least recently used line that isn't pinned, or EEPROM_CACHE_NO_LINE.
+ */
+static uint8 EEPROM_cacheVictim(void);
+
+/*
+ * Description :
+ * Mark the line as the most recently used one.
+ */
+static void EEPROM_cacheTouch(uint8 line);
+
+/*
+ * Description :
+ * Write back the line if it is dirty, the line stays valid.
+ */
+static uint8 EEPROM_cacheClean(uint8 line);
+
+/*
+ * Description :
+ * Write back the line if it is dirty then read the whole block in it while waiting.
+ */
+static uint8 EEPROM_cacheFill(uint8 line,uint8 block);
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                   *
  *******************************************************************************/
 
-uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data)
+static uint8 EEPROM_startWriteAt(uint16 u16addr)
 {
 	/* 1. Send the Start Bit */
 	TWI_start();
-	if(TWI_getStatus() != TWI_START)	return ERROR;
+	if(TWI_getStatus() != TWI_START)
+	{
+		TWI_stop();
+		return ERROR;
+	}
 
     /* 2. Send the device address, we need to get A8 A9 A10 address bits from the
      * memory location address and R/W=0 (write) */
-	TWI_writeByte((uint8) ((0xA0) | ((u16addr&0x7000)>>7)));
-	if(TWI_getStatus() !=  TWI_MT_SLA_W_ACK)	return ERROR;
+	TWI_writeByte(EEPROM_DEVICE_ADDRESS(u16addr));
+	if(TWI_getStatus() !=  TWI_MT_SLA_W_ACK)
+	{
+		TWI_stop();
+		return ERROR;
+	}
 
     /* 3. Send the required memory location address */
 	TWI_writeByte((uint8) u16addr);
-	if(TWI_getStatus() !=  TWI_MT_DATA_ACK)	return ERROR;
+	if(TWI_getStatus() !=  TWI_MT_DATA_ACK)
+	{
+		TWI_stop();
+		return ERROR;
+	}
+
+	return SUCCESS;
+}
 
-    /* 4. write byte to eeprom */
-	TWI_writeByte(u8data);
-	if(TWI_getStatus() !=  TWI_MT_DATA_ACK)	return ERROR;
+static uint8 EEPROM_deviceWritePage(uint16 u16addr,const uint8 *u8data,uint16 size)
+{
+	uint8 chunk;
 
-    /* 5. Send the Stop Bit */
-	TWI_stop();
+	while(size != 0)
+	{
+		/* Write up to the end of the current page, the 24Cxx wraps around inside
+		 * the page if we write past its boundary */
+		chunk = EEPROM_PAGE_SIZE - (u16addr & (EEPROM_PAGE_SIZE - 1));
+		if(chunk > size)
+		{
+			chunk = size;
+		}
+
+		/* 1. Send the Start Bit, the device address and the memory location address */
+		if(EEPROM_startWriteAt(u16addr) != SUCCESS)	return ERROR;
+
+		/* 2. write the bytes of this page, the eeprom increments the address itself */
+		size -= chunk;
+		u16addr += chunk;
+		while(chunk != 0)
+		{
+			TWI_writeByte(*u8data);
+			if(TWI_getStatus() !=  TWI_MT_DATA_ACK)
+			{
+				TWI_stop();
+				return ERROR;
+			}
+			u8data++;
+			chunk--;
+		}
+
+		/* 3. Send the Stop Bit to start the internal write cycle */
+		TWI_stop();
+
+		/* 4. Wait only for the real internal write cycle of the whole page */
+		if(EEPROM_waitReady() != SUCCESS)	return EEPROM_TIMEOUT;
+	}
 
 	return SUCCESS;
 }
 
-uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data)
+static uint8 EEPROM_deviceReadBlock(uint16 u16addr,uint8 *u8data,uint16 size)
 {
-	/* 1. Send the Start Bit */
-	TWI_start();
-	if(TWI_getStatus() != TWI_START)	return ERROR;
-
-    /* 2. Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-	TWI_writeByte((uint8) ((0xA0) | ((u16addr&0x7000)>>7)));
-	if(TWI_getStatus() !=  TWI_MT_SLA_W_ACK)	return ERROR;
+	if(size == 0)	return SUCCESS;
 
-    /* 3. Send the required memory location address */
-	TWI_writeByte((uint8) u16addr);
-	if(TWI_getStatus() !=  TWI_MT_DATA_ACK)	return ERROR;
+	/* 1. Send the Start Bit, the device address and the memory location address */
+	if(EEPROM_startWriteAt(u16addr) != SUCCESS)	return ERROR;
 
-	/* 4. Send the Repeated Start Bit */
+	/* 2. Send the Repeated Start Bit */
 	TWI_start();
-	if(TWI_getStatus() != TWI_REP_START)	return ERROR;
+	if(TWI_getStatus() != TWI_REP_START)
+	{
+		TWI_stop();
+		return ERROR;
+	}
 
-
-    /* 5. Send the device address, we need to get A8 A9 A10 address bits from the
+    /* 3. Send the device address, we need to get A8 A9 A10 address bits from the
      * memory location address and R/W=1 (read) */
-	TWI_writeByte((uint8) ((0xA0) | (((u16addr&0x7000)>>7) | 1)));
-	if(TWI_getStatus() !=  TWI_MT_SLA_R_ACK)	return ERROR;
+	TWI_writeByte(EEPROM_DEVICE_ADDRESS(u16addr) | 1);
+	if(TWI_getStatus() !=  TWI_MT_SLA_R_ACK)
+	{
+		TWI_stop();
+		return ERROR;
+	}
+
+	/* 4. Sequential read: send ACK after each byte to get the next one */
+	while(size > 1)
+	{
+		*u8data = TWI_readByteWithACK();
+		if(TWI_getStatus() !=  TWI_MR_DATA_ACK)
+		{
+			TWI_stop();
+			return ERROR;
+		}
+		u8data++;
+		size--;
+	}
 
-    /* 6. Read Byte from Memory without send ACK */
+    /* 5. Read the last Byte from Memory without send ACK */
 	*u8data = TWI_readByteWithNACK();
-	if(TWI_getStatus() !=  TWI_MR_DATA_NACK)	return ERROR;
+	if(TWI_getStatus() !=  TWI_MR_DATA_NACK)
+	{
+		TWI_stop();
+		return ERROR;
+	}
 
-    /* 7. Send the Stop Bit */
+    /* 6. Send the Stop Bit */
 	TWI_stop();
 
 	return SUCCESS;
 }
+
+uint8 EEPROM_waitReady(void)
+{
+	uint16 trials;
+
+	for(trials = 0; trials < EEPROM_ACK_POLLING_TRIALS; trials++)
+	{
+		/* The eeprom doesn't answer its address during the internal write cycle */
+		TWI_start();
+		if(TWI_getStatus() == TWI_START)
+		{
+			TWI_writeByte(EEPROM_DEVICE_ADDRESS(0));
+			if(TWI_getStatus() == TWI_MT_SLA_W_ACK)
+			{
+				/* ACK received, the write cycle is done */
+				TWI_stop();
+				return SUCCESS;
+			}
+		}
+		TWI_stop();
+		_delay_us(EEPROM_ACK_POLLING_PERIOD);
+	}
+
+	return EEPROM_TIMEOUT;
+}
+
+static uint8 EEPROM_deviceReadAsync(EEPROM_RequestType *request,uint16 u16addr,uint8 *u8data,uint8 size,
+		void (*callBack)(TWI_TransactionType *transaction))
+{
+	/* Write the memory location address then read the data after a repeated start */
+	request->memory_address = (uint8) u16addr;
+
+	request->transaction.slave_address = EEPROM_DEVICE_ADDRESS(u16addr);
+	request->transaction.write_buffer = &request->memory_address;
+	request->transaction.write_length = 1;
+	request->transaction.read_buffer = u8data;
+	request->transaction.read_length = size;
+	request->transaction.callBack = callBack;
+
+	if(TWI_submit(&request->transaction) == FALSE)	return ERROR;
+
+	return SUCCESS;
+}
+
+#ifdef EEPROM_CACHE_ENABLE
+static uint8 EEPROM_cacheFind(uint8 block)
+{
+	uint8 line;
+
+	for(line = 0; line < EEPROM_CACHE_LINES; line++)
+	{
+		if((g_cache[line].flags & EEPROM_CACHE_VALID) && (g_cache[line].block == block))
+		{
+			return line;
+		}
+	}
+	return EEPROM_CACHE_NO_LINE;
+}
+
+static uint8 EEPROM_cacheVictim(void)
+{
+	uint8 victim = EEPROM_CACHE_NO_LINE;
+	uint8 line;
+
+	for(line = 0; line < EEPROM_CACHE_LINES; line++)
+	{
+		if(g_cache[line].flags & EEPROM_CACHE_PINNED)
+		{
+			continue;
+		}
+		if(!(g_cache[line].flags & EEPROM_CACHE_VALID))
+		{
+			/* a free line */
+			return line;
+		}
+		if((victim == EEPROM_CACHE_NO_LINE) || (g_cache[line].used < g_cache[victim].used))
+		{
+			victim = line;
+		}
+	}
+	return victim;
+}
+
+static void EEPROM_cacheTouch(uint8 line)
+{
+	uint8 i;
+
+	g_cacheClock++;
+	if(g_cacheClock == 0)
+	{
+		/* the clock wrapped around, start all the lines again from the same age */
+		for(i = 0; i < EEPROM_CACHE_LINES; i++)
+		{
+			g_cache[i].used = 0;
+		}
+		g_cacheClock = 1;
+	}
+	g_cache[line].used = g_cacheClock;
+}
+
+static uint8 EEPROM_cacheClean(uint8 line)
+{
+	uint8 status;
+
+	if(g_cache[line].flags & EEPROM_CACHE_DIRTY)
+	{
+		status = EEPROM_deviceWritePage((uint16)g_cache[line].block * EEPROM_CACHE_LINE_SIZE, g_cache[line].data,
+				EEPROM_CACHE_LINE_SIZE);
+		if(status != SUCCESS)	return status;
+		g_cache[line].flags &= ~EEPROM_CACHE_DIRTY;
+	}
+	return SUCCESS;
+}
+
+static uint8 EEPROM_cacheFill(uint8 line,uint8 block)
+{
+	uint8 status;
+
+	status = EEPROM_cacheClean(line);
+	if(status != SUCCESS)	return status;
+
+	g_cache[line].flags = 0;
+	if(EEPROM_deviceReadBlock((uint16)block * EEPROM_CACHE_LINE_SIZE, g_cache[line].data,
+			EEPROM_CACHE_LINE_SIZE) != SUCCESS)	return ERROR;
+
+	g_cache[line].block = block;
+	g_cache[line].flags = EEPROM_CACHE_VALID;
+	EEPROM_cacheTouch(line);
+	return SUCCESS;
+}
+#endif
+
+uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data)
+{
+	/* a page write of one byte is the byte write of the eeprom */
+	return EEPROM_writePage(u16addr, &u8data, 1);
+}
+
+uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data)
+{
+	return EEPROM_readBlock(u16addr, u8data, 1);
+}
+
+uint8 EEPROM_writePage(uint16 u16addr,const uint8 *u8data,uint16 size)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 status;
+	uint8 offset;
+	uint8 chunk;
+	uint8 line;
+	uint8 i;
+
+	while(size != 0)
+	{
+		/* one page at a time, a page is a whole cache line */
+		offset = (uint8)(u16addr & (EEPROM_CACHE_LINE_SIZE - 1));
+		chunk = EEPROM_CACHE_LINE_SIZE - offset;
+		if(chunk > size)
+		{
+			chunk = size;
+		}
+
+		line = EEPROM_cacheFind(EEPROM_CACHE_BLOCK(u16addr));
+		if(line != EEPROM_CACHE_NO_LINE)
+		{
+			for(i = 0; i < chunk; i++)
+			{
+				g_cache[line].data[offset + i] = u8data[i];
+			}
+			EEPROM_cacheTouch(line);
+#ifdef EEPROM_CACHE_WRITE_BACK
+			g_cache[line].flags |= EEPROM_CACHE_DIRTY;
+#else
+			status = EEPROM_deviceWritePage(u16addr, u8data, chunk);
+			if(status != SUCCESS)
+			{
+				/* the eeprom may be older than the line now */
+				g_cache[line].flags &= ~EEPROM_CACHE_VALID;
+				return status;
+			}
+#endif
+		}
+		else
+		{
+			/* the written pages aren't loaded in the cache */
+			status = EEPROM_deviceWritePage(u16addr, u8data, chunk);
+			if(status != SUCCESS)	return status;
+		}
+
+		u16addr += chunk;
+		u8data += chunk;
+		size -= chunk;
+	}
+	return SUCCESS;
+#else
+	return EEPROM_deviceWritePage(u16addr, u8data, size);
+#endif
+}
+
+uint8 EEPROM_readBlock(uint16 u16addr,uint8 *u8data,uint16 size)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 block;
+	uint8 offset;
+	uint8 chunk;
+	uint8 line;
+	uint8 i;
+
+	while(size != 0)
+	{
+		block = EEPROM_CACHE_BLOCK(u16addr);
+		offset = (uint8)(u16addr & (EEPROM_CACHE_LINE_SIZE - 1));
+		chunk = EEPROM_CACHE_LINE_SIZE - offset;
+		if(chunk > size)
+		{
+			chunk = size;
+		}
+
+		line = EEPROM_cacheFind(block);
+		if(line == EEPROM_CACHE_NO_LINE)
+		{
+			/* load the whole page in the least recently used line */
+			line = EEPROM_cacheVictim();
+			if((line != EEPROM_CACHE_NO_LINE) && (EEPROM_cacheFill(line, block) != SUCCESS))
+			{
+				return ERROR;
+			}
+		}
+
+		if(line != EEPROM_CACHE_NO_LINE)
+		{
+			for(i = 0; i < chunk; i++)
+			{
+				u8data[i] = g_cache[line].data[offset + i];
+			}
+			EEPROM_cacheTouch(line);
+		}
+		else if(EEPROM_deviceReadBlock(u16addr, u8data, chunk) != SUCCESS)
+		{
+			/* all the lines are pinned */
+			return ERROR;
+		}
+
+		u16addr += chunk;
+		u8data += chunk;
+		size -= chunk;
+	}
+	return SUCCESS;
+#else
+	return EEPROM_deviceReadBlock(u16addr, u8data, size);
+#endif
+}
+
+uint8 EEPROM_readBlockAsync(EEPROM_RequestType *request,uint16 u16addr,uint8 *u8data,uint8 size,
+		void (*callBack)(TWI_TransactionType *transaction))
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 first = EEPROM_CACHE_BLOCK(u16addr);
+	uint8 last = EEPROM_CACHE_BLOCK(u16addr + size - 1);
+	boolean hit = (size != 0);
+	uint8 offset;
+	uint8 chunk;
+	uint8 block;
+	uint8 line;
+	uint8 i;
+
+	for(block = first; hit && (block <= last); block++)
+	{
+		hit = (EEPROM_cacheFind(block) != EEPROM_CACHE_NO_LINE);
+	}
+
+	if(hit)
+	{
+		/* all the pages are cached, no TWI transaction at all */
+		for(block = first; block <= last; block++)
+		{
+			offset = (uint8)(u16addr & (EEPROM_CACHE_LINE_SIZE - 1));
+			chunk = EEPROM_CACHE_LINE_SIZE - offset;
+			if(chunk > size)
+			{
+				chunk = size;
+			}
+			line = EEPROM_cacheFind(block);
+			for(i = 0; i < chunk; i++)
+			{
+				u8data[i] = g_cache[line].data[offset + i];
+			}
+			EEPROM_cacheTouch(line);
+			u16addr += chunk;
+			u8data += chunk;
+			size -= chunk;
+		}
+		request->transaction.status = TWI_DONE;
+		if(callBack != NULL_PTR)
+		{
+			callBack(&request->transaction);
+		}
+		return SUCCESS;
+	}
+
+	/* the misses don't wait to load a line, the whole page would take longer than the required
+	 * bytes, but the dirty lines of the other pages are written first so the read isn't stale */
+	for(block = first; (size != 0) && (block <= last); block++)
+	{
+		line = EEPROM_cacheFind(block);
+		if((line != EEPROM_CACHE_NO_LINE) && (EEPROM_cacheClean(line) != SUCCESS))
+		{
+			return ERROR;
+		}
+	}
+#endif
+	return EEPROM_deviceReadAsync(request, u16addr, u8data, size, callBack);
+}
+
+uint8 EEPROM_cacheLoad(uint16 u16addr,uint16 size)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 block;
+	uint8 line;
+
+	if(size == 0)	return SUCCESS;
+
+	for(block = EEPROM_CACHE_BLOCK(u16addr); block <= EEPROM_CACHE_BLOCK(u16addr + size - 1); block++)
+	{
+		line = EEPROM_cacheFind(block);
+		if(line == EEPROM_CACHE_NO_LINE)
+		{
+			line = EEPROM_cacheVictim();
+			if((line == EEPROM_CACHE_NO_LINE) || (EEPROM_cacheFill(line, block) != SUCCESS))
+			{
+				return ERROR;
+			}
+		}
+		g_cache[line].flags |= EEPROM_CACHE_PINNED;
+	}
+	return SUCCESS;
+#else
+	(void)u16addr;
+	(void)size;
+	return SUCCESS;
+#endif
+}
+
+void EEPROM_cacheRelease(uint16 u16addr,uint16 size)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 block;
+	uint8 line;
+
+	if(size == 0)	return;
+
+	for(block = EEPROM_CACHE_BLOCK(u16addr); block <= EEPROM_CACHE_BLOCK(u16addr + size - 1); block++)
+	{
+		line = EEPROM_cacheFind(block);
+		if(line != EEPROM_CACHE_NO_LINE)
+		{
+			g_cache[line].flags &= ~EEPROM_CACHE_PINNED;
+		}
+	}
+#else
+	(void)u16addr;
+	(void)size;
+#endif
+}
+
+void EEPROM_cacheDiscard(uint16 u16addr,uint16 size)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 block;
+	uint8 line;
+
+	if(size == 0)	return;
+
+	for(block = EEPROM_CACHE_BLOCK(u16addr); block <= EEPROM_CACHE_BLOCK(u16addr + size - 1); block++)
+	{
+		line = EEPROM_cacheFind(block);
+		if(line != EEPROM_CACHE_NO_LINE)
+		{
+			/* a pinned line is freed too, its block isn't cached anymore */
+			g_cache[line].flags = 0;
+		}
+	}
+#else
+	(void)u16addr;
+	(void)size;
+#endif
+}
+
+uint8 EEPROM_flush(void)
+{
+#ifdef EEPROM_CACHE_ENABLE
+	uint8 status;
+	uint8 line;
+
+	for(line = 0; line < EEPROM_CACHE_LINES; line++)
+	{
+		status = EEPROM_cacheClean(line);
+		if(status != SUCCESS)	return status;
+	}
+#endif
+	return SUCCESS;
+}
@@ -9,18 +9,126 @@
 #define EXTERNAL_EEPROM_H_
 
 #include	"std_types.h"
+#include	"twi.h"
 
 /*******************************************************************************
  *                      Preprocessor Macros                                    *
  *******************************************************************************/
 #define ERROR 0
 #define SUCCESS 1
+#define EEPROM_TIMEOUT 2	/* the eeprom didn't finish its write cycle in time */
+
+/* Page size of the 24Cxx, one page write can't cross the page boundary */
+#define EEPROM_PAGE_SIZE			16
+
+/* Maximum time of the 24Cxx internal write cycle in ms */
+#define EEPROM_WRITE_CYCLE_TIME		10
+
+/* Time between two ACK polling trials in us, the number of trials is bounded
+ * to cover the maximum write cycle time */
+#define EEPROM_ACK_POLLING_PERIOD	100
+#define EEPROM_ACK_POLLING_TRIALS	((EEPROM_WRITE_CYCLE_TIME * 1000UL) / EEPROM_ACK_POLLING_PERIOD)
+
+/* Device address with A8 A9 A10 memory address bits and R/W=0 (write) */
+#define EEPROM_DEVICE_ADDRESS(ADDR)	((uint8)(0xA0 | (((ADDR) & 0x0700) >> 7)))
+
+/*
+ * RAM cache of EEPROM pages in front of the reads & writes, remove EEPROM_CACHE_ENABLE to
+ * reach the eeprom directly. A read miss loads the whole page in the least recently used line,
+ * the interrupt driven reads only use the pages already cached.
+ * With EEPROM_CACHE_WRITE_BACK the writes to a cached page only change the line and mark it
+ * dirty, they reach the eeprom in EEPROM_flush, otherwise they are written through at once.
+ * The writes to the pages that are not cached go to the eeprom.
+ */
+#define EEPROM_CACHE_ENABLE
+#define EEPROM_CACHE_WRITE_BACK
+#define EEPROM_CACHE_LINES			8
+#define EEPROM_CACHE_LINE_SIZE		EEPROM_PAGE_SIZE
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/* Interrupt driven request, it must stay valid until its transaction is not TWI_PENDING */
+typedef struct
+{
+	TWI_TransactionType transaction;
+	uint8 memory_address;	/* low byte of the memory location sent before reading */
+}EEPROM_RequestType;
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
+/*
+ * Description :
+ * Write one byte and wait until the eeprom finishes its internal write cycle,
+ * a byte of a cached page waits for EEPROM_flush in the write back mode.
+ */
 uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data);
 uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data);
 
+/*
+ * Description :
+ * Write size bytes starting from u16addr using page writes, the data is split
+ * at the page boundaries and each page waits for its internal write cycle.
+ * The pages that are cached wait for EEPROM_flush in the write back mode.
+ */
+uint8 EEPROM_writePage(uint16 u16addr,const uint8 *u8data,uint16 size);
+
+/*
+ * Description :
+ * Wait until the eeprom finishes its internal write cycle by polling it with
+ * SLA+W until it sends ACK.
+ * Return: SUCCESS when the eeprom is ready or EEPROM_TIMEOUT.
+ */
+uint8 EEPROM_waitReady(void);
+
+/*
+ * Description :
+ * Queue a sequential read of size bytes starting from u16addr on the interrupt
+ * driven TWI without waiting, callBack is called from the TWI ISR when it finishes.
+ * A read of cached pages is done at once, its callBack is called before the return,
+ * otherwise the dirty cached pages it covers are written back first while waiting.
+ * Return: ERROR if the TWI queue is full or a write back fails.
+ */
+uint8 EEPROM_readBlockAsync(EEPROM_RequestType *request,uint16 u16addr,uint8 *u8data,uint8 size,
+		void (*callBack)(TWI_TransactionType *transaction));
+
+/*
+ * Description :
+ * Read size bytes starting from u16addr in one sequential read transaction.
+ */
+uint8 EEPROM_readBlock(uint16 u16addr,uint8 *u8data,uint16 size);
+
+/*
+ * Description :
+ * Load the pages of size bytes starting from u16addr in the cache and keep them there,
+ * it is used at boot for the data read on each request.
+ * Return: ERROR if the pages don't fit in the cache or can't be read.
+ */
+uint8 EEPROM_cacheLoad(uint16 u16addr,uint16 size);
+
+/*
+ * Description :
+ * Let the pages of size bytes starting from u16addr be replaced again, they stay
+ * cached until the least recently used line is needed.
+ */
+void EEPROM_cacheRelease(uint16 u16addr,uint16 size);
+
+/*
+ * Description :
+ * Drop the cached pages of size bytes starting from u16addr without writing them back,
+ * used when a write failed and must not reach the eeprom later. The next access reads
+ * the pages from the eeprom again.
+ */
+void EEPROM_cacheDiscard(uint16 u16addr,uint16 size);
+
+/*
+ * Description :
+ * Write the dirty cache lines to the eeprom, each page waits for its write cycle.
+ * Return: SUCCESS when no line is dirty anymore.
+ */
+uint8 EEPROM_flush(void);
+
 #endif	/* EXTERNAL_EEPROM_H_ */
@@ -7,6 +7,8 @@
 #ifndef GPIO_H_
 #define GPIO_H_
 #include "std_types.h"
+#include "common_macros.h"
+#include <avr/io.h>
 /*******************************************************************************
  *                                Definitions                                  *
  *******************************************************************************/
@@ -27,6 +29,35 @@
 #define PIN6_ID					6
 #define PIN7_ID					7
 
+/*
+ * Compile time GPIO access:
+ * The port id is mapped to its registers by the preprocessor & the compiler, so with
+ * constant port & pin ids and optimization on, each macro is a single sbi/cbi/sbis/sbic
+ * instruction. There is no range check, the ids should be valid.
+ * With a variable pin or without optimization it becomes a read-modify-write that an ISR
+ * can split, use the GPIO functions for pins that an ISR writes in the same register.
+ */
+#define GPIO_PORT_REG(PORT_ID)		(*(((PORT_ID) == PORTA_ID) ? &PORTA : ((PORT_ID) == PORTB_ID) ? &PORTB : \
+									   ((PORT_ID) == PORTC_ID) ? &PORTC : &PORTD))
+#define GPIO_DDR_REG(PORT_ID)		(*(((PORT_ID) == PORTA_ID) ? &DDRA : ((PORT_ID) == PORTB_ID) ? &DDRB : \
+									   ((PORT_ID) == PORTC_ID) ? &DDRC : &DDRD))
+#define GPIO_PIN_REG(PORT_ID)		(*(((PORT_ID) == PORTA_ID) ? &PINA : ((PORT_ID) == PORTB_ID) ? &PINB : \
+									   ((PORT_ID) == PORTC_ID) ? &PINC : &PIND))
+
+#define GPIO_SETUP_PIN_DIRECTION(PORT_ID,PIN_ID,DIRECTION) \
+	do { if((DIRECTION) == PIN_OUTPUT) { SET_BIT(GPIO_DDR_REG(PORT_ID),(PIN_ID)); } \
+		 else { CLEAR_BIT(GPIO_DDR_REG(PORT_ID),(PIN_ID)); } } while(0)
+
+#define GPIO_WRITE(PORT_ID,PIN_ID,VALUE) \
+	do { if((VALUE) == LOGIC_HIGH) { SET_BIT(GPIO_PORT_REG(PORT_ID),(PIN_ID)); } \
+		 else { CLEAR_BIT(GPIO_PORT_REG(PORT_ID),(PIN_ID)); } } while(0)
+
+#define GPIO_READ(PORT_ID,PIN_ID)					(BIT_IS_SET(GPIO_PIN_REG(PORT_ID),(PIN_ID)) ? LOGIC_HIGH : LOGIC_LOW)
+
+#define GPIO_SETUP_PORT_DIRECTION(PORT_ID,DIRECTION)	(GPIO_DDR_REG(PORT_ID) = (uint8)(DIRECTION))
+#define GPIO_WRITE_PORT(PORT_ID,VALUE)					(GPIO_PORT_REG(PORT_ID) = (VALUE))
+#define GPIO_READ_PORT(PORT_ID)						(GPIO_PIN_REG(PORT_ID))
+
 /*******************************************************************************
  *                               Types Declaration                             *
  *******************************************************************************/
@@ -83,6 +114,14 @@ void GPIO_setupPortDirection(uint8 port_num, GPIO_PortDirectionType direction);
  */
 void GPIO_writePort(uint8 port_num, uint8 value);
 
+/*
+ * Description :
+ * Write the value bits on the pins selected by the mask in one store, the other pins keep their values.
+ * The read-modify-write is done with the interrupts disabled so it is safe against ISRs using the same port.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writeMasked(uint8 port_num, uint8 mask, uint8 value);
+
 /*
  * Description :
  * Read and return the value of the required port.
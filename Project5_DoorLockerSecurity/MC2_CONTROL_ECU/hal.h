@@ -0,0 +1,30 @@
+ /******************************************************************************
+ * Module: HAL
+ * File Name: hal.h
+ * Description: Seam between the drivers and the hardware, the AVR build maps
+ *              straight to the memory mapped registers, the host build (HOST_BUILD)
+ *              routes every register access through the simulated hardware
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef HAL_H_
+#define HAL_H_
+
+#ifdef HOST_BUILD
+
+/* HAL_IO_ADDRESS & HAL_BUSY_WAIT are provided by the simulator (host/hal_host.h) */
+#include	"hal_host.h"
+
+#else
+
+/* Address of a memory mapped I/O register */
+#define HAL_IO_ADDRESS(ADDRESS)			(ADDRESS)
+
+/*
+ * Body of the busy loops that only poll RAM variables changed by the interrupts,
+ * the host build uses it to let the simulated time run.
+ */
+#define HAL_BUSY_WAIT()
+
+#endif
+
+#endif /* HAL_H_ */
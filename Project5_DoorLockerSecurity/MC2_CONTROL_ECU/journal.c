@@ -0,0 +1,221 @@
+ /******************************************************************************
+ * Module: Journal
+ * File Name: journal.c
+ * Description: Source file for the log structured store of the settings in the
+ *              external EEPROM
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"journal.h"
+#include	"crc.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* An erased slot reads 0xFF, its sequence number is never written */
+#define JOURNAL_ERASED_SEQUENCE			0xFFFFFFFFUL
+
+#define JOURNAL_NO_SLOT					0xFF
+
+#define JOURNAL_SLOT_ADDRESS(SLOT)		(JOURNAL_REGION_ADDRESS + ((uint16)(SLOT) * JOURNAL_RECORD_SIZE))
+
+#if ((JOURNAL_REGION_ADDRESS % EEPROM_PAGE_SIZE) != 0)
+#error "a journal record should not cross an EEPROM page"
+#endif
+
+#if (JOURNAL_KEYS >= JOURNAL_SLOTS)
+#error "the journal needs a free slot besides the newest record of each key"
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Slot & sequence number of the newest record of each key */
+static uint8 g_latestSlot[JOURNAL_KEYS];
+static uint32 g_latestSequence[JOURNAL_KEYS];
+
+/* Slot & sequence number of the next write */
+static uint8 g_head = 0;
+static uint32 g_nextSequence = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Sequence number of the record read from the EEPROM.
+ */
+static uint32 JOURNAL_sequence(const uint8 *record);
+
+/*
+ * Description :
+ * Return TRUE if the record read from the EEPROM is complete.
+ */
+static boolean JOURNAL_isValid(const uint8 *record);
+
+/*
+ * Description :
+ * Return TRUE if the slot holds the newest record of a key, it can't be overwritten.
+ */
+static boolean JOURNAL_isLatest(uint8 slot);
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+static uint32 JOURNAL_sequence(const uint8 *record)
+{
+	return ((uint32)record[JOURNAL_SEQUENCE_OFFSET]) |
+			((uint32)record[JOURNAL_SEQUENCE_OFFSET + 1] << 8) |
+			((uint32)record[JOURNAL_SEQUENCE_OFFSET + 2] << 16) |
+			((uint32)record[JOURNAL_SEQUENCE_OFFSET + 3] << 24);
+}
+
+static boolean JOURNAL_isValid(const uint8 *record)
+{
+	uint16 crc = CRC_crc16(record, JOURNAL_CRC_OFFSET);
+
+	return (JOURNAL_sequence(record) != JOURNAL_ERASED_SEQUENCE) &&
+			(record[JOURNAL_KEY_OFFSET] < JOURNAL_KEYS) &&
+			(record[JOURNAL_LENGTH_OFFSET] <= JOURNAL_DATA_SIZE) &&
+			(record[JOURNAL_CRC_OFFSET] == (uint8)(crc >> 8)) &&
+			(record[JOURNAL_CRC_OFFSET + 1] == (uint8)crc);
+}
+
+static boolean JOURNAL_isLatest(uint8 slot)
+{
+	uint8 key;
+
+	for(key = 0; key < JOURNAL_KEYS; key++)
+	{
+		if(g_latestSlot[key] == slot)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+void JOURNAL_init(void)
+{
+	uint8 record[JOURNAL_RECORD_SIZE];
+	uint32 sequence;
+	uint8 slot;
+	uint8 key;
+
+	for(key = 0; key < JOURNAL_KEYS; key++)
+	{
+		g_latestSlot[key] = JOURNAL_NO_SLOT;
+		g_latestSequence[key] = 0;
+	}
+	g_head = 0;
+	g_nextSequence = 0;
+
+	for(slot = 0; slot < JOURNAL_SLOTS; slot++)
+	{
+		if((EEPROM_readBlock(JOURNAL_SLOT_ADDRESS(slot), record, JOURNAL_RECORD_SIZE) != SUCCESS) ||
+				!JOURNAL_isValid(record))
+		{
+			/* an erased slot or a write that didn't finish */
+			continue;
+		}
+
+		sequence = JOURNAL_sequence(record);
+		key = record[JOURNAL_KEY_OFFSET];
+		if((g_latestSlot[key] == JOURNAL_NO_SLOT) || (sequence > g_latestSequence[key]))
+		{
+			g_latestSlot[key] = slot;
+			g_latestSequence[key] = sequence;
+		}
+
+		/* go on writing after the newest record of all the keys */
+		if(sequence >= g_nextSequence)
+		{
+			g_nextSequence = sequence + 1;
+			g_head = (slot + 1 == JOURNAL_SLOTS) ? 0 : (slot + 1);
+		}
+	}
+}
+
+JOURNAL_StatusType JOURNAL_write(JOURNAL_KeyType key, const uint8 *data, uint8 length)
+{
+	uint8 record[JOURNAL_RECORD_SIZE];
+	uint16 crc;
+	uint8 slot = g_head;
+	uint8 i;
+
+	if((key >= JOURNAL_KEYS) || (length > JOURNAL_DATA_SIZE))
+	{
+		return JOURNAL_INVALID_SIZE;
+	}
+
+	/* keep the newest records, the key's own one too until the new record is written */
+	while(JOURNAL_isLatest(slot))
+	{
+		slot = (slot + 1 == JOURNAL_SLOTS) ? 0 : (slot + 1);
+	}
+
+	record[JOURNAL_SEQUENCE_OFFSET] = (uint8)g_nextSequence;
+	record[JOURNAL_SEQUENCE_OFFSET + 1] = (uint8)(g_nextSequence >> 8);
+	record[JOURNAL_SEQUENCE_OFFSET + 2] = (uint8)(g_nextSequence >> 16);
+	record[JOURNAL_SEQUENCE_OFFSET + 3] = (uint8)(g_nextSequence >> 24);
+	record[JOURNAL_KEY_OFFSET] = key;
+	record[JOURNAL_LENGTH_OFFSET] = length;
+	for(i = 0; i < JOURNAL_DATA_SIZE; i++)
+	{
+		record[JOURNAL_DATA_OFFSET + i] = (i < length) ? data[i] : 0xFF;
+	}
+	crc = CRC_crc16(record, JOURNAL_CRC_OFFSET);
+	record[JOURNAL_CRC_OFFSET] = (uint8)(crc >> 8);
+	record[JOURNAL_CRC_OFFSET + 1] = (uint8)crc;
+
+	/* the sequence number is used even if the write fails, the slot may hold a part of it */
+	g_nextSequence++;
+	g_head = (slot + 1 == JOURNAL_SLOTS) ? 0 : (slot + 1);
+
+	/* the whole record is one page, it is written in one write cycle */
+	if((EEPROM_writePage(JOURNAL_SLOT_ADDRESS(slot), record, JOURNAL_RECORD_SIZE) != SUCCESS) ||
+			(EEPROM_flush() != SUCCESS))
+	{
+		/* a record left dirty in the cache would reach the eeprom later and win at boot */
+		EEPROM_cacheDiscard(JOURNAL_SLOT_ADDRESS(slot), JOURNAL_RECORD_SIZE);
+		return JOURNAL_EEPROM_ERROR;
+	}
+
+	g_latestSlot[key] = slot;
+	g_latestSequence[key] = g_nextSequence - 1;
+	return JOURNAL_OK;
+}
+
+JOURNAL_StatusType JOURNAL_read(JOURNAL_KeyType key, uint8 *data, uint8 *length)
+{
+	uint8 record[JOURNAL_RECORD_SIZE];
+	uint8 i;
+
+	if((key >= JOURNAL_KEYS) || (g_latestSlot[key] == JOURNAL_NO_SLOT))
+	{
+		return JOURNAL_NOT_FOUND;
+	}
+
+	if((EEPROM_readBlock(JOURNAL_SLOT_ADDRESS(g_latestSlot[key]), record, JOURNAL_RECORD_SIZE) != SUCCESS) ||
+			!JOURNAL_isValid(record))
+	{
+		return JOURNAL_EEPROM_ERROR;
+	}
+
+	*length = record[JOURNAL_LENGTH_OFFSET];
+	for(i = 0; i < *length; i++)
+	{
+		data[i] = record[JOURNAL_DATA_OFFSET + i];
+	}
+	return JOURNAL_OK;
+}
+
+uint16 JOURNAL_dataAddress(JOURNAL_KeyType key)
+{
+	if((key >= JOURNAL_KEYS) || (g_latestSlot[key] == JOURNAL_NO_SLOT))
+	{
+		return JOURNAL_NO_ADDRESS;
+	}
+	return JOURNAL_SLOT_ADDRESS(g_latestSlot[key]) + JOURNAL_DATA_OFFSET;
+}
@@ -0,0 +1,90 @@
+ /******************************************************************************
+ * Module: Journal
+ * File Name: journal.h
+ * Description: Header file for the log structured store of the settings in the
+ *              external EEPROM, each update is a new record in the next slot
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include	"std_types.h"
+#include	"external_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * EEPROM Layout:
+ * 	JOURNAL_SLOTS records of one EEPROM page from JOURNAL_REGION_ADDRESS, before the PIN holders table,
+ * 	| SEQUENCE (4 bytes, LSB first) | KEY | LENGTH | DATA[JOURNAL_DATA_SIZE] | CRC-16 (MSB first) |
+ * The records are written in turn around the region so the write cycles are spread over
+ * all the slots. The newest record of a key is never overwritten, a power loss during a
+ * write leaves a record with a wrong CRC and the previous one of its key is still read.
+ */
+#define JOURNAL_REGION_ADDRESS			0x000
+#define JOURNAL_SLOTS					16
+#define JOURNAL_RECORD_SIZE				EEPROM_PAGE_SIZE
+#define JOURNAL_DATA_SIZE				8
+
+/* Offsets in the record */
+#define JOURNAL_SEQUENCE_OFFSET			0
+#define JOURNAL_KEY_OFFSET				4
+#define JOURNAL_LENGTH_OFFSET			5
+#define JOURNAL_DATA_OFFSET				6
+#define JOURNAL_CRC_OFFSET				(JOURNAL_DATA_OFFSET + JOURNAL_DATA_SIZE)
+
+/* Returned instead of the address of a key that has no record */
+#define JOURNAL_NO_ADDRESS				0xFFFF
+
+#if (JOURNAL_CRC_OFFSET + 2 != JOURNAL_RECORD_SIZE)
+#error "a journal record should fill one EEPROM page"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	JOURNAL_KEY_PASSWORD, JOURNAL_KEY_PIN_SALT, JOURNAL_KEYS
+}JOURNAL_KeyType;
+
+typedef enum
+{
+	JOURNAL_OK, JOURNAL_NOT_FOUND, JOURNAL_INVALID_SIZE, JOURNAL_EEPROM_ERROR
+}JOURNAL_StatusType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read all the slots once and find the newest valid record of each key and the slot
+ * of the next write, it should be called after TWI_init.
+ */
+void JOURNAL_init(void);
+
+/*
+ * Description :
+ * Write a new record of the key with a higher sequence number in the next free slot,
+ * the previous record of the key stays valid until this one is fully written.
+ * Return: JOURNAL_OK, JOURNAL_INVALID_SIZE or JOURNAL_EEPROM_ERROR.
+ */
+JOURNAL_StatusType JOURNAL_write(JOURNAL_KeyType key, const uint8 *data, uint8 length);
+
+/*
+ * Description :
+ * Read the data of the newest record of the key while waiting, length is its size.
+ * Return: JOURNAL_OK, JOURNAL_NOT_FOUND or JOURNAL_EEPROM_ERROR.
+ */
+JOURNAL_StatusType JOURNAL_read(JOURNAL_KeyType key, uint8 *data, uint8 *length);
+
+/*
+ * Description :
+ * EEPROM address of the data of the newest record of the key, for the interrupt
+ * driven reads, or JOURNAL_NO_ADDRESS. It changes with each write of the key.
+ */
+uint16 JOURNAL_dataAddress(JOURNAL_KeyType key);
+
+#endif /* JOURNAL_H_ */
@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Module: Limit Switch
+ * File Name: limit_switch.c
+ * Description: Source file for the door bolt end position switches
+ * Author:	Yousif Adel
+ *******************************************************************************/
+#include "limit_switch.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Global variable to hold the address of the call back function in the application */
+static void (*volatile g_callBackPtr)(LIMIT_SWITCH_Type) = NULL_PTR;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+ISR(INT0_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)(LIMIT_SWITCH_UNLOCKED);
+	}
+}
+
+ISR(INT1_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)(LIMIT_SWITCH_LOCKED);
+	}
+}
+
+/*******************************************************************************
+ *                              Functions Definitions                         *
+ *******************************************************************************/
+void LIMIT_SWITCH_init(void)
+{
+	/* Input pins with the internal pull-ups, an open switch reads high */
+	GPIO_SETUP_PIN_DIRECTION(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_UNLOCKED_PIN_ID,PIN_INPUT);
+	GPIO_SETUP_PIN_DIRECTION(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_LOCKED_PIN_ID,PIN_INPUT);
+	GPIO_WRITE(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_UNLOCKED_PIN_ID,LOGIC_HIGH);
+	GPIO_WRITE(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_LOCKED_PIN_ID,LOGIC_HIGH);
+
+	/* Falling edge on INT0 & INT1: ISCx1 = 1 & ISCx0 = 0 */
+	MCUCR = (MCUCR & ~((1<<ISC00) | (1<<ISC01) | (1<<ISC10) | (1<<ISC11))) | (1<<ISC01) | (1<<ISC11);
+
+	/* Drop the edges seen while the pins were floating, then enable the interrupts */
+	GIFR = (1<<INTF0) | (1<<INTF1);
+	GICR |= (1<<INT0) | (1<<INT1);
+}
+
+void LIMIT_SWITCH_setCallBack(void(*a_ptr)(LIMIT_SWITCH_Type))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
+
+boolean LIMIT_SWITCH_isPressed(LIMIT_SWITCH_Type limit_switch)
+{
+	switch(limit_switch)
+	{
+	case LIMIT_SWITCH_UNLOCKED:
+		return (GPIO_READ(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_UNLOCKED_PIN_ID) == LIMIT_SWITCH_PRESSED);
+	case LIMIT_SWITCH_LOCKED:
+		return (GPIO_READ(LIMIT_SWITCH_PORT_ID,LIMIT_SWITCH_LOCKED_PIN_ID) == LIMIT_SWITCH_PRESSED);
+	default:
+		return FALSE;
+	}
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ * Module: Limit Switch
+ * File Name: limit_switch.h
+ * Description: Header file for the door bolt end position switches on the
+ *              external interrupts INT0 & INT1
+ * Author:	Yousif Adel
+ *******************************************************************************/
+
+#ifndef LIMIT_SWITCH_H_
+#define LIMIT_SWITCH_H_
+#include	"gpio.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * The switches close to ground when the bolt reaches the end position, the pins use the
+ * internal pull-ups. The pins are fixed by the hardware: INT0 = PD2 & INT1 = PD3.
+ */
+#define LIMIT_SWITCH_PORT_ID			PORTD_ID
+#define LIMIT_SWITCH_UNLOCKED_PIN_ID	PIN2_ID		/* INT0 */
+#define LIMIT_SWITCH_LOCKED_PIN_ID		PIN3_ID		/* INT1 */
+
+#define LIMIT_SWITCH_PRESSED			LOGIC_LOW
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	LIMIT_SWITCH_NONE, LIMIT_SWITCH_UNLOCKED, LIMIT_SWITCH_LOCKED
+}LIMIT_SWITCH_Type;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ ● Description
+	⮚ Setup the two switch pins as inputs with the internal pull-ups.
+	⮚ Enable INT0 & INT1 on the falling edge, the moment a switch closes.
+● Inputs: None
+● Return: None
+*/
+void LIMIT_SWITCH_init(void);
+
+/*
+● Description
+	⮚ Save the address of the function called from the interrupt when a switch closes.
+	⮚ A bouncing switch calls it more than once for the same press.
+● Inputs: pointer to the call back function, it takes the closed switch
+● Return: None
+*/
+void LIMIT_SWITCH_setCallBack(void(*a_ptr)(LIMIT_SWITCH_Type));
+
+/*
+● Description
+	⮚ Read the current state of a switch through the GPIO.
+● Inputs: the switch
+● Return: TRUE while the switch is closed
+*/
+boolean LIMIT_SWITCH_isPressed(LIMIT_SWITCH_Type limit_switch);
+
+#endif /* LIMIT_SWITCH_H_ */
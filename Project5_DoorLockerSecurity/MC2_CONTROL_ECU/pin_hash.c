@@ -0,0 +1,163 @@
+ /******************************************************************************
+ * Module: PIN Hash
+ * File Name: pin_hash.c
+ * Description: Source file for the salted & keyed hash of the PINs
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"pin_hash.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PIN_HASH_C_ROUNDS				2
+#define PIN_HASH_D_ROUNDS				4
+
+#define PIN_HASH_ROTL(X, B)				((uint32)(((X) << (B)) | ((X) >> (32 - (B)))))
+
+/* Little endian 32-bit word from 4 bytes & back */
+#define PIN_HASH_LOAD32(P)				(((uint32)(P)[0]) | ((uint32)(P)[1] << 8) | \
+										((uint32)(P)[2] << 16) | ((uint32)(P)[3] << 24))
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint32 v0;
+	uint32 v1;
+	uint32 v2;
+	uint32 v3;
+}PIN_HASH_StateType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static const uint8 g_buildKey[PIN_HASH_SALT_SIZE] = PIN_HASH_KEY;
+
+/* Hash key words, the build key until the salt is set */
+static uint32 g_k0 = 0;
+static uint32 g_k1 = 0;
+static boolean g_keyReady = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Run the SipHash round on the state rounds times.
+ */
+static void PIN_HASH_rounds(PIN_HASH_StateType *state, uint8 rounds);
+
+/*
+ * Description :
+ * Write the 32-bit word as 4 bytes, low byte first.
+ */
+static void PIN_HASH_store32(uint8 *bytes, uint32 word);
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+static void PIN_HASH_rounds(PIN_HASH_StateType *state, uint8 rounds)
+{
+	uint32 v0 = state->v0;
+	uint32 v1 = state->v1;
+	uint32 v2 = state->v2;
+	uint32 v3 = state->v3;
+
+	while(rounds != 0)
+	{
+		v0 += v1; v1 = PIN_HASH_ROTL(v1, 5); v1 ^= v0; v0 = PIN_HASH_ROTL(v0, 16);
+		v2 += v3; v3 = PIN_HASH_ROTL(v3, 8); v3 ^= v2;
+		v0 += v3; v3 = PIN_HASH_ROTL(v3, 7); v3 ^= v0;
+		v2 += v1; v1 = PIN_HASH_ROTL(v1, 13); v1 ^= v2; v2 = PIN_HASH_ROTL(v2, 16);
+		rounds--;
+	}
+
+	state->v0 = v0;
+	state->v1 = v1;
+	state->v2 = v2;
+	state->v3 = v3;
+}
+
+static void PIN_HASH_store32(uint8 *bytes, uint32 word)
+{
+	bytes[0] = (uint8)word;
+	bytes[1] = (uint8)(word >> 8);
+	bytes[2] = (uint8)(word >> 16);
+	bytes[3] = (uint8)(word >> 24);
+}
+
+void PIN_HASH_setSalt(const uint8 *salt)
+{
+	uint8 key[PIN_HASH_SALT_SIZE];
+	uint8 i;
+
+	for(i = 0; i < PIN_HASH_SALT_SIZE; i++)
+	{
+		key[i] = g_buildKey[i] ^ salt[i];
+	}
+	g_k0 = PIN_HASH_LOAD32(&key[0]);
+	g_k1 = PIN_HASH_LOAD32(&key[4]);
+	g_keyReady = TRUE;
+}
+
+void PIN_HASH_compute(const uint8 *pin, uint8 *digest)
+{
+	PIN_HASH_StateType state;
+	uint32 message;
+	uint32 last;
+	uint8 i;
+
+	if(!g_keyReady)
+	{
+		g_k0 = PIN_HASH_LOAD32(&g_buildKey[0]);
+		g_k1 = PIN_HASH_LOAD32(&g_buildKey[4]);
+		g_keyReady = TRUE;
+	}
+
+	state.v0 = g_k0;
+	state.v1 = g_k1 ^ 0xEE;		/* 64-bit output */
+	state.v2 = g_k0 ^ 0x6C796765UL;
+	state.v3 = g_k1 ^ 0x74656462UL;
+
+	/* the whole 4-byte words of the PIN */
+	for(i = 0; i + 4 <= PIN_HASH_PIN_SIZE; i += 4)
+	{
+		message = PIN_HASH_LOAD32(&pin[i]);
+		state.v3 ^= message;
+		PIN_HASH_rounds(&state, PIN_HASH_C_ROUNDS);
+		state.v0 ^= message;
+	}
+
+	/* the last word holds the length in its high byte & the remaining bytes */
+	last = (uint32)PIN_HASH_PIN_SIZE << 24;
+	for(; i < PIN_HASH_PIN_SIZE; i++)
+	{
+		last |= (uint32)pin[i] << ((i & 3) * 8);
+	}
+	state.v3 ^= last;
+	PIN_HASH_rounds(&state, PIN_HASH_C_ROUNDS);
+	state.v0 ^= last;
+
+	/* finalization, one half of the digest after each d rounds */
+	state.v2 ^= 0xEE;
+	PIN_HASH_rounds(&state, PIN_HASH_D_ROUNDS);
+	PIN_HASH_store32(&digest[0], state.v1 ^ state.v3);
+	state.v1 ^= 0xDD;
+	PIN_HASH_rounds(&state, PIN_HASH_D_ROUNDS);
+	PIN_HASH_store32(&digest[4], state.v1 ^ state.v3);
+}
+
+boolean PIN_HASH_equal(const uint8 *first, const uint8 *second, uint8 size)
+{
+	uint8 difference = 0;
+	uint8 i;
+
+	for(i = 0; i < size; i++)
+	{
+		difference |= first[i] ^ second[i];
+	}
+	return (difference == 0);
+}
@@ -0,0 +1,51 @@
+ /******************************************************************************
+ * Module: PIN Hash
+ * File Name: pin_hash.h
+ * Description: Header file for the salted & keyed hash of the PINs kept in the
+ *              external EEPROM (HalfSipHash-2-4 with a 64-bit output)
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef PIN_HASH_H_
+#define PIN_HASH_H_
+
+#include	"std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PIN_HASH_PIN_SIZE				5
+#define PIN_HASH_DIGEST_SIZE			8
+#define PIN_HASH_SALT_SIZE				8
+
+/*
+ * Secret key of the build, change it for each product. The hash key is this key xor the salt
+ * of the device kept in the EEPROM, so the same PIN gives a different digest on each device
+ * and a dump of the EEPROM alone isn't enough to try all the PINs.
+ */
+#define PIN_HASH_KEY					{0x4D, 0x43, 0x32, 0x2D, 0x44, 0x6F, 0x6F, 0x72}
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set the salt of the device, the hash key is the build key xor the salt.
+ */
+void PIN_HASH_setSalt(const uint8 *salt);
+
+/*
+ * Description :
+ * Calculate the digest of the PIN, 8 rounds on 32-bit words plus 4 for the second half
+ * of the digest, the rotations by 8 & 16 bits are only byte moves on the AVR.
+ */
+void PIN_HASH_compute(const uint8 *pin, uint8 *digest);
+
+/*
+ * Description :
+ * Compare size bytes in a constant time, all the bytes are compared even after a difference.
+ * Return: TRUE if they are equal.
+ */
+boolean PIN_HASH_equal(const uint8 *first, const uint8 *second, uint8 size);
+
+#endif /* PIN_HASH_H_ */
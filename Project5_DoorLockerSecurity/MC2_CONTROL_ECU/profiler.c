@@ -0,0 +1,123 @@
+ /******************************************************************************
+ * Module: Profiler
+ * File Name: profiler.c
+ * Description: Source file for the code sections profiler
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"profiler.h"
+#include	"scheduler.h"
+#include	"timer1.h"
+#include	"protocol.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint32 begin;		/* time of the running PROF_BEGIN */
+	uint16 count;		/* stops at 0xFFFF */
+	uint32 min;
+	uint32 max;
+	uint64 sum;
+}PROFILER_StatisticsType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static PROFILER_StatisticsType g_sections[PROF_SECTIONS];
+
+/* CPU cycles of one scheduler tick */
+static uint32 g_tickCycles;
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+void PROFILER_init(void)
+{
+	uint8 section;
+
+	for(section = 0; section < PROF_SECTIONS; section++)
+	{
+		g_sections[section].count = 0;
+		g_sections[section].min = 0;
+		g_sections[section].max = 0;
+		g_sections[section].sum = 0;
+	}
+	g_tickCycles = ((uint32)OCR1A_REG.TwoBytes + 1) * PROFILER_TIMER1_PRESCALER;
+}
+
+uint32 PROFILER_now(void)
+{
+	uint32 ticks;
+	uint16 counter;
+
+	/*
+	 * When Timer1 reaches its top between the two reads, the tick interrupt runs
+	 * before the ticks are read again, so the counter is read once more.
+	 */
+	do
+	{
+		ticks = SCHEDULER_getTicks();
+		counter = TCNT1_REG.TwoBytes;
+	}while(ticks != SCHEDULER_getTicks());
+
+	return (ticks * g_tickCycles) + ((uint32)counter * PROFILER_TIMER1_PRESCALER);
+}
+
+void PROFILER_begin(PROFILER_SectionType section)
+{
+	g_sections[section].begin = PROFILER_now();
+}
+
+void PROFILER_end(PROFILER_SectionType section)
+{
+	PROFILER_StatisticsType *statistics = &g_sections[section];
+	uint32 cycles = PROFILER_now() - statistics->begin;
+
+	if((statistics->count == 0) || (cycles < statistics->min))
+	{
+		statistics->min = cycles;
+	}
+	if(cycles > statistics->max)
+	{
+		statistics->max = cycles;
+	}
+	statistics->sum += cycles;
+	if(statistics->count != 0xFFFF)
+	{
+		statistics->count++;
+	}
+}
+
+void PROFILER_dump(void)
+{
+	uint8 payload[PROFILER_DATA_SIZE];
+	uint8 section;
+	uint8 i;
+
+	for(section = 0; section < PROF_SECTIONS; section++)
+	{
+		if(g_sections[section].count == 0)
+		{
+			continue;
+		}
+
+		payload[0] = section;
+		payload[1] = (uint8)g_sections[section].count;
+		payload[2] = (uint8)(g_sections[section].count >> 8);
+		for(i = 0; i < 4; i++)
+		{
+			payload[3 + i] = (uint8)(g_sections[section].min >> (8 * i));
+			payload[7 + i] = (uint8)(g_sections[section].max >> (8 * i));
+		}
+		for(i = 0; i < 8; i++)
+		{
+			payload[11 + i] = (uint8)(g_sections[section].sum >> (8 * i));
+		}
+		PROTOCOL_sendFrame(PROFILER_DATA, payload, PROFILER_DATA_SIZE);
+	}
+
+	/* end of the dump */
+	PROTOCOL_sendFrame(PROFILER_DATA, NULL_PTR, 0);
+}
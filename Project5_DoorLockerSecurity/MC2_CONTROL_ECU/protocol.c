@@ -0,0 +1,184 @@
+ /******************************************************************************
+ * Module: Protocol
+ * File Name: protocol.c
+ * Description: Source file for the framed UART protocol between MC1 & MC2
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"protocol.h"
+#include	"uart.h"
+#include	"crc.h"
+#include	"profiler.h"
+#include	"scheduler.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* States of the receiver while parsing a frame */
+typedef enum
+{
+	WAIT_START, WAIT_COMMAND, WAIT_LENGTH, WAIT_PAYLOAD, WAIT_CRC
+}PROTOCOL_RxStateType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static PROTOCOL_RxStateType g_rxState = WAIT_START;
+static uint8 g_rxIndex = 0;	/* index of the next payload byte */
+static uint8 g_rxCrc;		/* running CRC of the frame being received */
+static uint32 g_rxTick;		/* tick of the last received byte */
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Send one frame with the required command and payload through UART.
+ */
+void PROTOCOL_sendFrame(uint8 command, const uint8 *payload, uint8 length)
+{
+	uint8 crc = CRC8_INITIAL_VALUE;
+	uint8 i;
+
+	if(length > PROTOCOL_MAX_PAYLOAD)
+	{
+		/* The receiver can't accept this frame */
+		return;
+	}
+
+	UART_sendByte(PROTOCOL_START_BYTE);
+
+	UART_sendByte(command);
+	crc = CRC_crc8Update(crc, command);
+
+	UART_sendByte(length);
+	crc = CRC_crc8Update(crc, length);
+
+	for(i = 0; i < length; i++)
+	{
+		UART_sendByte(payload[i]);
+		crc = CRC_crc8Update(crc, payload[i]);
+	}
+
+	UART_sendByte(crc);
+}
+
+/*
+ * Description :
+ * Consume the received UART bytes without waiting.
+ * Return: PROTOCOL_FRAME_READY when a complete valid frame is stored in frame,
+ * PROTOCOL_CRC_ERROR when a corrupted frame is dropped, otherwise PROTOCOL_NO_FRAME.
+ */
+PROTOCOL_StatusType PROTOCOL_poll(PROTOCOL_FrameType *frame)
+{
+	uint32 now;
+	uint8 data;
+
+	while(UART_read(&data, 1) != 0)
+	{
+		now = SCHEDULER_getTicks();
+		if((g_rxState != WAIT_START) && (((now - g_rxTick) * SCHEDULER_TICK_MS) > PROTOCOL_BYTE_TIMEOUT_MS))
+		{
+			/* the rest of the frame was lost, don't take the next frame bytes for it */
+			g_rxState = WAIT_START;
+		}
+		g_rxTick = now;
+
+		switch(g_rxState)
+		{
+		case WAIT_START:
+			/* Skip any byte until the beginning of a frame */
+			if(data == PROTOCOL_START_BYTE)
+			{
+				g_rxCrc = CRC8_INITIAL_VALUE;
+				g_rxState = WAIT_COMMAND;
+			}
+			break;
+
+		case WAIT_COMMAND:
+			frame->command = data;
+			g_rxCrc = CRC_crc8Update(g_rxCrc, data);
+			g_rxState = WAIT_LENGTH;
+			break;
+
+		case WAIT_LENGTH:
+			if(data > PROTOCOL_MAX_PAYLOAD)
+			{
+				/* Not a valid frame, search for the next start byte */
+				g_rxState = WAIT_START;
+				break;
+			}
+			frame->length = data;
+			g_rxCrc = CRC_crc8Update(g_rxCrc, data);
+			g_rxIndex = 0;
+			g_rxState = (data == 0) ? WAIT_CRC : WAIT_PAYLOAD;
+			break;
+
+		case WAIT_PAYLOAD:
+			frame->payload[g_rxIndex] = data;
+			g_rxCrc = CRC_crc8Update(g_rxCrc, data);
+			g_rxIndex++;
+			if(g_rxIndex == frame->length)
+			{
+				g_rxState = WAIT_CRC;
+			}
+			break;
+
+		case WAIT_CRC:
+			g_rxState = WAIT_START;
+			if(data != g_rxCrc)
+			{
+				if(data == PROTOCOL_START_BYTE)
+				{
+					/* the CRC byte was lost, this is the start of the next frame */
+					g_rxCrc = CRC8_INITIAL_VALUE;
+					g_rxState = WAIT_COMMAND;
+				}
+				return PROTOCOL_CRC_ERROR;
+			}
+#ifdef PROFILER_ENABLE
+			if(frame->command == PROFILER_DUMP)
+			{
+				/* served here so the dump can be requested whatever the application waits for */
+				PROFILER_dump();
+				break;
+			}
+#endif
+			return PROTOCOL_FRAME_READY;
+		}
+	}
+	return PROTOCOL_NO_FRAME;
+}
+
+/*
+ * Description :
+ * Send the request and wait for one of its two answers, the other frames are dropped.
+ * The request is sent again when no answer comes in PROTOCOL_REPLY_TIMEOUT_MS, it is
+ * sent PROTOCOL_REQUEST_TRIES times at most. The scheduler should be ticking.
+ * Return: PROTOCOL_FRAME_READY when the answer is stored in frame, otherwise PROTOCOL_TIMEOUT.
+ */
+PROTOCOL_StatusType PROTOCOL_request(uint8 command, const uint8 *payload, uint8 length,
+		uint8 reply, uint8 other_reply, PROTOCOL_FrameType *frame)
+{
+	uint32 start;
+	uint8 tries;
+
+	/* a late answer of an earlier request doesn't answer this one */
+	while(PROTOCOL_poll(frame) != PROTOCOL_NO_FRAME){}
+
+	for(tries = 0; tries < PROTOCOL_REQUEST_TRIES; tries++)
+	{
+		PROTOCOL_sendFrame(command, payload, length);
+		start = SCHEDULER_getTicks();
+		while(((SCHEDULER_getTicks() - start) * SCHEDULER_TICK_MS) < PROTOCOL_REPLY_TIMEOUT_MS)
+		{
+			if((PROTOCOL_poll(frame) == PROTOCOL_FRAME_READY) &&
+					((frame->command == reply) || (frame->command == other_reply)))
+			{
+				return PROTOCOL_FRAME_READY;
+			}
+			HAL_BUSY_WAIT();
+		}
+	}
+	return PROTOCOL_TIMEOUT;
+}
@@ -27,8 +27,7 @@ void PWM_Timer0_Start (uint8 duty_cycle)
 	TCNT0 = 0;
 
 	/* 2. set the compare value in OCR0*/
-		/*The DutyCycle Is In Percentage So We Have To Make Some Calculations*/
-	OCR0=(uint8)(((float32)duty_cycle/100)*255);
+	PWM_Timer0_setDuty(duty_cycle);
 
 	/* 3. configure PB3/OC0 as output
 	      pin --> pin where the PWM signal is generated from MC
@@ -44,3 +43,19 @@ void PWM_Timer0_Start (uint8 duty_cycle)
 	 */
 	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (1<<CS01);
 }
+
+/*
+ * Description:
+➢ Change the duty cycle of the running PWM, only OCR0 is written.
+➢ OCR0 is double buffered in the Fast PWM mode, the new duty starts with the next period without a glitch.
+➢ A duty cycle above 100 is taken as 100.
+ */
+void PWM_Timer0_setDuty(uint8 duty_cycle)
+{
+	if(duty_cycle > PWM_MAX_DUTY_CYCLE)
+	{
+		duty_cycle = PWM_MAX_DUTY_CYCLE;
+	}
+	/*The DutyCycle Is In Percentage, scale it to the 8-bit compare value*/
+	OCR0 = PWM_DUTY_TO_COMPARE(duty_cycle);
+}
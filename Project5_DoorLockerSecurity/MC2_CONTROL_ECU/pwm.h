@@ -16,6 +16,11 @@
 #define PWM_PORT_ID					DDRB
 #define PWM_PIN_ID					PB3
 
+#define PWM_MAX_DUTY_CYCLE			100
+
+/* Duty cycle in percent to the OCR0 value, integer math: no soft-float in the motor path */
+#define PWM_DUTY_TO_COMPARE(DUTY)	((uint8)(((uint16)(DUTY) * 255) / PWM_MAX_DUTY_CYCLE))
+
 
 /*******************************************************************************
  *                              Functions Prototypes                         *
@@ -33,4 +38,12 @@
  */
 void PWM_Timer0_Start(uint8 duty_cycle);
 
+/*
+ * Description:
+➢ Change the duty cycle of the running PWM, only OCR0 is written.
+➢ OCR0 is double buffered in the Fast PWM mode, the new duty starts with the next period without a glitch.
+➢ A duty cycle above 100 is taken as 100.
+ */
+void PWM_Timer0_setDuty(uint8 duty_cycle);
+
 #endif /*PWM_H_*/
@@ -0,0 +1,191 @@
+ /******************************************************************************
+ * Module: Scheduler
+ * File Name: scheduler.c
+ * Description: Source file for the cooperative scheduler and its software timers
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include	"scheduler.h"
+#include	"hal.h"
+#include	<avr/io.h>
+#include	<avr/interrupt.h>
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	volatile uint16 remaining;		/* ticks until the task is due */
+	uint16 period;					/* reload value, zero for one shot timers */
+	void (*task)(void);				/* NULL_PTR if the timer is free */
+	volatile uint8 pending;			/* task is due and waiting for the dispatcher */
+}SCHEDULER_TimerType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static SCHEDULER_TimerType g_timers[SCHEDULER_MAX_TIMERS];
+static volatile uint32 g_ticks = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Reserve a free timer and start it.
+ */
+static SCHEDULER_TimerId SCHEDULER_start(uint16 time_ms, uint16 period_ms, void (*task)(void));
+
+/*******************************************************************************
+ *                      Functions Definitions                                   *
+ *******************************************************************************/
+
+void SCHEDULER_init(void)
+{
+	uint8 id;
+	uint8 sreg = SREG;
+
+	cli();
+	for(id = 0; id < SCHEDULER_MAX_TIMERS; id++)
+	{
+		g_timers[id].task = NULL_PTR;
+		g_timers[id].pending = 0;
+	}
+	g_ticks = 0;
+	SREG = sreg;
+}
+
+void SCHEDULER_tick(void)
+{
+	uint8 id;
+
+	g_ticks++;
+
+	for(id = 0; id < SCHEDULER_MAX_TIMERS; id++)
+	{
+		if((g_timers[id].task != NULL_PTR) && (g_timers[id].remaining != 0))
+		{
+			g_timers[id].remaining--;
+			if(g_timers[id].remaining == 0)
+			{
+				/* Let the dispatcher run the task outside the interrupt */
+				g_timers[id].pending = 1;
+				g_timers[id].remaining = g_timers[id].period;
+			}
+		}
+	}
+}
+
+void SCHEDULER_dispatch(void)
+{
+	uint8 id;
+	uint8 sreg;
+	void (*task)(void);
+
+	for(id = 0; id < SCHEDULER_MAX_TIMERS; id++)
+	{
+		if(g_timers[id].pending)
+		{
+			sreg = SREG;
+			cli();
+			task = g_timers[id].task;
+			g_timers[id].pending = 0;
+			if(g_timers[id].period == 0)
+			{
+				/* One shot timer is free again before its task runs,
+				 * so the task can start a new timer */
+				g_timers[id].task = NULL_PTR;
+			}
+			SREG = sreg;
+
+			if(task != NULL_PTR)
+			{
+				task();
+			}
+		}
+	}
+
+	/* The super loop only polls RAM between the dispatches, let the simulated time run */
+	HAL_BUSY_WAIT();
+}
+
+SCHEDULER_TimerId SCHEDULER_startOneShot(uint16 time_ms, void (*task)(void))
+{
+	return SCHEDULER_start(time_ms, 0, task);
+}
+
+SCHEDULER_TimerId SCHEDULER_startPeriodic(uint16 period_ms, void (*task)(void))
+{
+	return SCHEDULER_start(period_ms, period_ms, task);
+}
+
+void SCHEDULER_stop(SCHEDULER_TimerId id)
+{
+	uint8 sreg = SREG;
+
+	if(id >= SCHEDULER_MAX_TIMERS)
+	{
+		return;
+	}
+
+	cli();
+	g_timers[id].task = NULL_PTR;
+	g_timers[id].pending = 0;
+	SREG = sreg;
+}
+
+uint32 SCHEDULER_getTicks(void)
+{
+	uint32 ticks;
+	uint8 sreg = SREG;
+
+	/* The 32-bit counter is updated by the timer interrupt */
+	cli();
+	ticks = g_ticks;
+	SREG = sreg;
+
+	return ticks;
+}
+
+static SCHEDULER_TimerId SCHEDULER_start(uint16 time_ms, uint16 period_ms, void (*task)(void))
+{
+	SCHEDULER_TimerId id;
+	uint8 sreg = SREG;
+	uint16 ticks = time_ms / SCHEDULER_TICK_MS;
+	uint16 period = period_ms / SCHEDULER_TICK_MS;
+
+	if(task == NULL_PTR)
+	{
+		return SCHEDULER_INVALID_TIMER;
+	}
+
+	/* A timer needs at least one tick */
+	if(ticks == 0)
+	{
+		ticks = 1;
+	}
+	if((period_ms != 0) && (period == 0))
+	{
+		period = 1;
+	}
+
+	cli();
+	for(id = 0; id < SCHEDULER_MAX_TIMERS; id++)
+	{
+		if(g_timers[id].task == NULL_PTR)
+		{
+			g_timers[id].remaining = ticks;
+			g_timers[id].period = period;
+			g_timers[id].pending = 0;
+			g_timers[id].task = task;
+			break;
+		}
+	}
+	SREG = sreg;
+
+	if(id == SCHEDULER_MAX_TIMERS)
+	{
+		return SCHEDULER_INVALID_TIMER;
+	}
+	return id;
+}
@@ -0,0 +1,79 @@
+ /******************************************************************************
+ * Module: Scheduler
+ * File Name: scheduler.h
+ * Description: Header file for the cooperative scheduler and its software timers
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include	"std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* Time between two calls of SCHEDULER_tick in ms */
+#define SCHEDULER_TICK_MS				1
+
+/* Maximum number of software timers running at the same time */
+#define SCHEDULER_MAX_TIMERS			8
+
+/* Returned when no software timer is free */
+#define SCHEDULER_INVALID_TIMER			0xFF
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef uint8 SCHEDULER_TimerId;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Stop all the software timers.
+ */
+void SCHEDULER_init(void);
+
+/*
+ * Description :
+ * Count one tick for all the running timers, it should be called every
+ * SCHEDULER_TICK_MS from the timer interrupt (the Timer 1 call back).
+ */
+void SCHEDULER_tick(void);
+
+/*
+ * Description :
+ * Run the tasks of the expired timers, each task runs to completion in the
+ * main loop context. It should be called continuously from the main loop.
+ */
+void SCHEDULER_dispatch(void);
+
+/*
+ * Description :
+ * Start a timer that runs task once after time_ms.
+ * Return: the timer id or SCHEDULER_INVALID_TIMER if all timers are used.
+ */
+SCHEDULER_TimerId SCHEDULER_startOneShot(uint16 time_ms, void (*task)(void));
+
+/*
+ * Description :
+ * Start a timer that runs task every period_ms until it is stopped.
+ * Return: the timer id or SCHEDULER_INVALID_TIMER if all timers are used.
+ */
+SCHEDULER_TimerId SCHEDULER_startPeriodic(uint16 period_ms, void (*task)(void));
+
+/*
+ * Description :
+ * Stop the timer before its task runs, an invalid id is ignored.
+ */
+void SCHEDULER_stop(SCHEDULER_TimerId id);
+
+/*
+ * Description :
+ * Return the number of ticks since the scheduler has been initialized.
+ */
+uint32 SCHEDULER_getTicks(void);
+
+#endif /* SCHEDULER_H_ */
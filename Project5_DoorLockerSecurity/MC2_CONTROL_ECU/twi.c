@@ -6,8 +6,130 @@
  *******************************************************************************/
 #include	"twi.h"
 #include	<avr/io.h>
+#include	<avr/interrupt.h>
 #include	"common_macros.h"
+#include	"hal.h"
 
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Set when the last polled operation didn't get the TWINT flag in time */
+static boolean g_timeout = FALSE;
+
+/* Queue of the interrupt driven transactions */
+static TWI_TransactionType * volatile g_queue[TWI_QUEUE_SIZE];
+static volatile uint8 g_queueHead = 0;
+static volatile uint8 g_queueTail = 0;
+
+/* The transaction in progress and its state */
+static TWI_TransactionType * volatile g_current = NULL_PTR;
+static volatile uint8 g_index = 0;		/* index of the next byte to send or receive */
+static volatile uint8 g_reading = 0;	/* R/W bit of the current phase */
+static volatile uint8 g_ticksLeft = 0;	/* deadline of the current transaction */
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Wait for the TWINT flag with a timeout instead of hanging if the bus is stuck.
+ */
+static void TWI_waitForFlag(void);
+
+/*
+ * Description :
+ * Start the next queued transaction if the TWI is free, called with interrupts disabled.
+ */
+static void TWI_startNext(void);
+
+/*
+ * Description :
+ * Send the Stop Bit, report the result of the current transaction and start the next one.
+ */
+static void TWI_finish(TWI_TransactionStatus status, uint8 error);
+
+/*
+ * Description :
+ * Report the result of the current transaction and start the next one.
+ */
+static void TWI_complete(TWI_TransactionStatus status, uint8 error);
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+ISR(TWI_vect)
+{
+	TWI_TransactionType *transaction = g_current;
+	uint8 status = TWSR & 0xF8;
+
+	if(transaction == NULL_PTR)
+	{
+		/* Nothing in progress, just release the bus */
+		TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+		return;
+	}
+
+	switch(status)
+	{
+	case TWI_START:
+	case TWI_REP_START:
+		/* Start with the write phase unless there is nothing to write, a repeated start
+		 * before the bytes are written means the bus was still held, not the read phase */
+		g_reading = (g_index >= transaction->write_length);
+		g_index = 0;
+		TWDR = transaction->slave_address | g_reading;
+		TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		break;
+
+	case TWI_MT_SLA_W_ACK:
+	case TWI_MT_DATA_ACK:
+		if(g_index < transaction->write_length)
+		{
+			/* Send the next byte */
+			TWDR = transaction->write_buffer[g_index];
+			g_index++;
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		}
+		else if(transaction->read_length != 0)
+		{
+			/* Write phase finished, switch to the read phase */
+			TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+		}
+		else
+		{
+			TWI_finish(TWI_DONE, status);
+		}
+		break;
+
+	case TWI_MT_SLA_R_ACK:
+		/* Send ACK after each byte except the last one */
+		if(transaction->read_length > 1)
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+		else
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		break;
+
+	case TWI_MR_DATA_ACK:
+		transaction->read_buffer[g_index] = TWDR;
+		g_index++;
+		if(g_index < (transaction->read_length - 1))
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA);
+		else
+			TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWIE);
+		break;
+
+	case TWI_MR_DATA_NACK:
+		transaction->read_buffer[g_index] = TWDR;
+		TWI_finish(TWI_DONE, status);
+		break;
+
+	default:
+		/* NACK from the slave, arbitration lost or bus error */
+		TWI_finish(TWI_FAILED, status);
+		break;
+	}
+}
 
 /*******************************************************************************
  *                      Functions Definitions                                   *
@@ -27,8 +149,44 @@ void TWI_init(const TWI_ConfigType * Config_Ptr)
 	TWCR = (1<<TWEN);
 }
 
+static void TWI_waitForFlag(void)
+{
+	uint16 count = 0;
+
+	/* Wait for TWINT flag set in TWCR Register */
+	while(BIT_IS_CLEAR(TWCR, TWINT))
+	{
+		count++;
+		if(count == TWI_FLAG_TIMEOUT)
+		{
+			/* The bus is stuck, TWI_getStatus will report TWI_TIMEOUT. Reset the TWI to
+			 * release the bus, the next TWI_start sends a new Start Bit not a repeated one */
+			g_timeout = TRUE;
+			TWCR = 0;
+			TWCR = (1 << TWEN);
+			return;
+		}
+	}
+}
+
 void TWI_start(void)
 {
+	uint16 count = 0;
+
+	g_timeout = FALSE;
+
+	/* The polled operations can't share the bus with the interrupt driven transactions */
+	while(!TWI_isIdle())
+	{
+		HAL_BUSY_WAIT();
+		count++;
+		if(count == TWI_FLAG_TIMEOUT)
+		{
+			g_timeout = TRUE;
+			return;
+		}
+	}
+
     /*
 	 * Clear the TWINT flag before sending the start bit TWINT=1
 	 * send the start bit by TWSTA=1
@@ -37,7 +195,7 @@ void TWI_start(void)
     TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
 
     /* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
-    while(BIT_IS_CLEAR(TWCR, TWINT));
+    TWI_waitForFlag();
 }
 
 void TWI_stop(void)
@@ -52,6 +210,8 @@ void TWI_stop(void)
 
 void TWI_writeByte(uint8 data)
 {
+	g_timeout = FALSE;
+
     /* Put data On TWI data Register */
 	TWDR = data;
 
@@ -62,11 +222,13 @@ void TWI_writeByte(uint8 data)
     TWCR = (1 << TWINT) | (1 << TWEN);
 
     /* Wait for TWINT flag set in TWCR Register(data is send successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    TWI_waitForFlag();
 }
 
 uint8 TWI_readByteWithACK(void)
 {
+	g_timeout = FALSE;
+
     /*
 	 * Clear the TWINT flag before sending the data TWINT=1
 	 * Enable TWI Module TWEN=1
@@ -74,21 +236,23 @@ uint8 TWI_readByteWithACK(void)
     TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
 
     /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR,TWINT));
+    TWI_waitForFlag();
 
     /* Return the Data */
-    return TWCR;
+    return TWDR;
 }
 
 uint8 TWI_readByteWithNACK(void)
 {
+	g_timeout = FALSE;
+
 	/*
 	 * Clear the TWINT flag before reading the data TWINT=1
 	 * Enable TWI Module TWEN=1
 	 */
     TWCR = (1 << TWINT) | (1 << TWEN);
     /* Wait for TWINT flag set in TWCR Register (data received successfully) */
-    while(BIT_IS_CLEAR(TWCR, TWINT));
+    TWI_waitForFlag();
     /* Read Data */
     return TWDR;
 }
@@ -96,8 +260,117 @@ uint8 TWI_readByteWithNACK(void)
 uint8 TWI_getStatus(void)
 {
     uint8 status;
+
+    if(g_timeout)
+    {
+    	return TWI_TIMEOUT;
+    }
+
     /* masking to eliminate first 3 bits and get the last 5 bits (status bits) */
     status = TWSR & 0xF8;		/* 1111 1000*/
 
     return status;
 }
+
+boolean TWI_submit(TWI_TransactionType *transaction)
+{
+	uint8 sreg = SREG;
+	uint8 next;
+
+	transaction->status = TWI_PENDING;
+	transaction->error = 0;
+
+	cli();
+	next = (g_queueHead + 1) & (TWI_QUEUE_SIZE - 1);
+	if(next == g_queueTail)
+	{
+		/* The queue is full */
+		SREG = sreg;
+		return FALSE;
+	}
+	g_queue[g_queueHead] = transaction;
+	g_queueHead = next;
+
+	/* Start it now if the TWI is free, otherwise the ISR will start it later */
+	if(g_current == NULL_PTR)
+	{
+		TWI_startNext();
+	}
+	SREG = sreg;
+
+	return TRUE;
+}
+
+boolean TWI_isIdle(void)
+{
+	return ((g_current == NULL_PTR) && (g_queueHead == g_queueTail));
+}
+
+static void TWI_startNext(void)
+{
+	if(g_queueTail == g_queueHead)
+	{
+		g_current = NULL_PTR;
+		return;
+	}
+
+	g_current = g_queue[g_queueTail];
+	g_queueTail = (g_queueTail + 1) & (TWI_QUEUE_SIZE - 1);
+	g_ticksLeft = TWI_TRANSACTION_TIMEOUT_TICKS;
+	g_index = 0;
+
+	/* Send the Start Bit, the rest is done by the TWI_vect ISR */
+	TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE);
+}
+
+static void TWI_finish(TWI_TransactionStatus status, uint8 error)
+{
+	uint16 count = 0;
+
+	/* Send the Stop Bit and wait until it is sent before any new Start Bit */
+	TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+	while(BIT_IS_SET(TWCR, TWSTO) && (count < TWI_FLAG_TIMEOUT))
+	{
+		count++;
+	}
+
+	TWI_complete(status, error);
+}
+
+static void TWI_complete(TWI_TransactionStatus status, uint8 error)
+{
+	TWI_TransactionType *transaction = g_current;
+
+	if(status == TWI_FAILED)
+	{
+		transaction->error = error;
+	}
+	transaction->status = status;
+
+	if(transaction->callBack != NULL_PTR)
+	{
+		transaction->callBack(transaction);
+	}
+
+	TWI_startNext();
+}
+
+void TWI_tick(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	if((g_current != NULL_PTR) && (g_ticksLeft != 0))
+	{
+		g_ticksLeft--;
+		if(g_ticksLeft == 0)
+		{
+			/* TWINT didn't come, send the Stop Bit and reset the TWI to release the bus */
+			TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+			TWCR = 0;
+			TWCR = (1 << TWEN);
+			TWI_complete(TWI_FAILED, TWI_TIMEOUT);
+		}
+	}
+	SREG = sreg;
+}
@@ -26,6 +26,23 @@
 
 #define TWI_MR_DATA_NACK  0x58 /* Master received data but doesn't send ACK to slave. */
 
+/* Driver status returned by TWI_getStatus when the TWINT flag wasn't set in time,
+ * the first 3 bits of a real TWSR status are always zero after masking */
+#define TWI_TIMEOUT       0x01
+
+/* Number of polling loops to wait for the TWINT flag before giving up */
+#define TWI_FLAG_TIMEOUT  50000
+
+/* TWI_tick calls (1 ms scheduler ticks) an interrupt driven transaction may take before it is
+ * aborted, longer than a 255 bytes transfer at 100 kHz */
+#define TWI_TRANSACTION_TIMEOUT_TICKS	50
+
+/* Number of transactions that can wait in the interrupt driven queue, it should be power of two */
+#define TWI_QUEUE_SIZE    4
+
+#if ((TWI_QUEUE_SIZE & (TWI_QUEUE_SIZE - 1)) != 0)
+#error "TWI queue size should be power of two"
+#endif
 
 /*******************************************************************************
  *                         Types Declaration                                   *
@@ -45,6 +62,27 @@ typedef struct{
 	TWI_BaudRate bit_rate;
 }TWI_ConfigType;
 
+typedef enum{
+	TWI_PENDING, TWI_DONE, TWI_FAILED
+}TWI_TransactionStatus;
+
+/*
+ * Description of one interrupt driven transaction:
+ * 	START, SLA+W, write_buffer bytes, then if read_length != 0:
+ * 	REPEATED START, SLA+R, read_buffer bytes, then STOP.
+ * If write_length is zero the transaction starts directly with SLA+R.
+ */
+typedef struct TWI_Transaction{
+	uint8 slave_address;					/* device address with R/W=0 */
+	const uint8 *write_buffer;
+	uint8 write_length;
+	uint8 *read_buffer;
+	uint8 read_length;
+	void (*callBack)(struct TWI_Transaction *transaction);	/* called from the ISR when finished, can be NULL_PTR */
+	volatile TWI_TransactionStatus status;
+	volatile uint8 error;					/* TWSR status that failed the transaction or TWI_TIMEOUT */
+}TWI_TransactionType;
+
 
 /*******************************************************************************
  *                      Functions Prototypes                                   *
@@ -57,4 +95,27 @@ uint8 TWI_readByteWithACK(void);
 uint8 TWI_readByteWithNACK(void);
 uint8 TWI_getStatus(void);
 
+/*
+ * Description :
+ * Queue a transaction to be done by the TWI_vect ISR without waiting.
+ * The transaction must stay valid until its status is not TWI_PENDING.
+ * Return: FALSE if the queue is full.
+ */
+boolean TWI_submit(TWI_TransactionType *transaction);
+
+/*
+ * Description :
+ * Return TRUE if there is no interrupt driven transaction in progress or queued.
+ */
+boolean TWI_isIdle(void);
+
+/*
+ * Description :
+ * Count the deadline of the interrupt driven transaction in progress, it should be called
+ * from the timer interrupt. When TWINT doesn't come in time (a slave holds SCL low or the
+ * Start Bit is lost) the TWI is reset, the transaction fails with the error TWI_TIMEOUT
+ * and the next queued one is started.
+ */
+void TWI_tick(void);
+
 #endif	/* TWI_H_ */
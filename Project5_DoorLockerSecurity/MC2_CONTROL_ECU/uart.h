@@ -9,9 +9,35 @@
 #define UART_H_
 
 #include	"std_types.h"
+#include	"hal.h"
 
 /* Define The UART Speed Mode */
 #define UART_SPEED_MODE 	ASYNCHRONOUS_DOUBLE_SPEED_MODE
+
+/*
+ * Define The UART Operating Mode:
+ * 	- UART_INTERRUPT_MODE defined : RX/TX are handled by the USART_RXC & USART_UDRE ISRs through ring buffers
+ * 	- UART_INTERRUPT_MODE not defined : RX/TX are handled by polling the RXC & UDRE flags
+ */
+#define UART_INTERRUPT_MODE
+
+#ifdef UART_INTERRUPT_MODE
+/* Size of the RX & TX ring buffers, it should be power of two and not greater than 128 */
+#define UART_RX_BUFFER_SIZE			32
+#define UART_TX_BUFFER_SIZE			32
+
+#if (((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) != 0) || (UART_RX_BUFFER_SIZE > 128))
+#error "UART RX buffer size should be power of two and not greater than 128"
+#endif
+
+#if (((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)) != 0) || (UART_TX_BUFFER_SIZE > 128))
+#error "UART TX buffer size should be power of two and not greater than 128"
+#endif
+
+/* Masks used to wrap the ring buffers indices */
+#define UART_RX_BUFFER_MASK			(UART_RX_BUFFER_SIZE - 1)
+#define UART_TX_BUFFER_MASK			(UART_TX_BUFFER_SIZE - 1)
+#endif /* UART_INTERRUPT_MODE */
 /*******************************************************************************
  *                         Macros 		                                   *
  *******************************************************************************/
@@ -180,17 +206,17 @@ typedef union {
 /******************************************************************************/
 
 /**************************** UART Registers Definitions ***********************/
-#define UART_UCSRA_REG			(*(volatile UART_UCSRA_Type*)0x2B)
-#define UART_UCSRB_REG			(*(volatile UART_UCSRB_Type*)(0x2A))
+#define UART_UCSRA_REG			(*(volatile UART_UCSRA_Type*)HAL_IO_ADDRESS(0x2B))
+#define UART_UCSRB_REG			(*(volatile UART_UCSRB_Type*)HAL_IO_ADDRESS(0x2A))
 
-#define UART_UDR_REG			(*(volatile UART_UDR_Type*)0x2C)
+#define UART_UDR_REG			(*(volatile UART_UDR_Type*)HAL_IO_ADDRESS(0x2C))
 
-#define UART_UCSRC_REG			(*(volatile UART_UCSRC_Type*)(0x40))
-#define UART_UBRRH_REG			(*(volatile UART_UBRRH_Type *)(0x40))
+#define UART_UCSRC_REG			(*(volatile UART_UCSRC_Type*)HAL_IO_ADDRESS(0x40))
+#define UART_UBRRH_REG			(*(volatile UART_UBRRH_Type *)HAL_IO_ADDRESS(0x40))
 
-#define UART_UBRRL_REG			(*(volatile UART_UBRRL_Type*)(0x29))
+#define UART_UBRRL_REG			(*(volatile UART_UBRRL_Type*)HAL_IO_ADDRESS(0x29))
 /*******************************************************************************/
-#define S_REG      			(*(volatile SREG_Type*)0x5F)
+#define S_REG      			(*(volatile SREG_Type*)HAL_IO_ADDRESS(0x5F))
 /*******************************************************************************/
 
 
@@ -212,6 +238,7 @@ void UART_init(const UART_ConfigType * Config_Ptr);
 /*
  * Description :
  * Functional responsible for send byte to another UART device.
+ * In interrupt mode it waits only if the TX ring buffer is full.
  */
 void UART_sendByte(const uint8 data);
 
@@ -219,9 +246,43 @@ void UART_sendByte(const uint8 data);
 /*
  * Description :
  * Functional responsible for receive byte from another UART device.
+ * In interrupt mode it waits until the RX ring buffer has at least one byte.
  */
 uint8 UART_recieveByte(void);
 
+/*
+ * Description :
+ * Queue up to size bytes to be sent without waiting.
+ * Return: the number of bytes accepted, the rest is counted as TX overflow.
+ */
+uint8 UART_write(const uint8 *data, uint8 size);
+
+/*
+ * Description :
+ * Copy up to size received bytes into data without waiting.
+ * Return: the number of bytes copied.
+ */
+uint8 UART_read(uint8 *data, uint8 size);
+
+/*
+ * Description :
+ * Return the number of received bytes ready to be read.
+ */
+uint8 UART_available(void);
+
+/*
+ * Description :
+ * Return the number of received bytes lost because the RX ring buffer was full
+ * or the UART hardware buffer was overrun.
+ */
+uint16 UART_getRxOverflowCount(void);
+
+/*
+ * Description :
+ * Return the number of bytes rejected by UART_write because the TX ring buffer was full.
+ */
+uint16 UART_getTxOverflowCount(void);
+
 /*
  * Description :
  * Send the required string through UART to the other UART device.
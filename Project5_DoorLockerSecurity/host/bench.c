@@ -0,0 +1,68 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: bench.c
+ * Description: Timing of the drivers functions in simulated CPU cycles
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include "bench.h"
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+uint64_t BENCH_begin(void)
+{
+	return SIM_cycles;
+}
+
+void BENCH_end(BENCH_ResultType *result, uint64_t begin)
+{
+	uint64_t cycles = SIM_cycles - begin;
+
+	if((result->iterations == 0) || (cycles < result->min))
+	{
+		result->min = cycles;
+	}
+	if(cycles > result->max)
+	{
+		result->max = cycles;
+	}
+	result->sum += cycles;
+	result->iterations++;
+}
+
+int BENCH_writeJson(const char *path, const char *ecu, const BENCH_ResultType *results, uint8_t count)
+{
+	FILE *file = stdout;
+	uint64_t average;
+	uint8_t i;
+
+	if(path != NULL)
+	{
+		file = fopen(path, "w");
+		if(file == NULL)
+		{
+			perror(path);
+			return -1;
+		}
+	}
+
+	fprintf(file, "{\n  \"ecu\": \"%s\",\n  \"cpu_hz\": %llu,\n  \"results\": [\n", ecu, (unsigned long long)SIM_CPU_HZ);
+	for(i = 0; i < count; i++)
+	{
+		average = (results[i].iterations != 0) ? (results[i].sum / results[i].iterations) : 0;
+		fprintf(file, "    {\"name\": \"%s\", \"iterations\": %u, \"min_cycles\": %llu, \"avg_cycles\": %llu, "
+				"\"max_cycles\": %llu, \"min_us\": %.3f, \"avg_us\": %.3f, \"max_us\": %.3f}%s\n",
+				results[i].name, results[i].iterations, (unsigned long long)results[i].min,
+				(unsigned long long)average, (unsigned long long)results[i].max,
+				(double)results[i].min / (double)SIM_CYCLES_PER_US, (double)average / (double)SIM_CYCLES_PER_US,
+				(double)results[i].max / (double)SIM_CYCLES_PER_US, (i + 1 < count) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	if(file != stdout)
+	{
+		fclose(file);
+	}
+	return 0;
+}
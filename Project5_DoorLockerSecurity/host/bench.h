@@ -0,0 +1,53 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: bench.h
+ * Description: Timing of the drivers functions in simulated CPU cycles for the
+ *              bench programs of the two ECUs.
+ *
+ * The peripherals times (UART frames, TWI bits, EEPROM write cycle, LCD timing)
+ * are exact, the CPU time of the code itself is counted as HAL_ACCESS_CYCLES per
+ * register access so it only follows the I/O done by the code.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	const char *name;
+	uint32_t iterations;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+}BENCH_ResultType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Simulated time at the start of a measured call.
+ */
+uint64_t BENCH_begin(void);
+
+/*
+ * Description :
+ * Add the cycles since begin to the result.
+ */
+void BENCH_end(BENCH_ResultType *result, uint64_t begin);
+
+/*
+ * Description :
+ * Write the results as JSON to the file named by path, stdout when it is NULL.
+ * Return: 0 when the file is written.
+ */
+int BENCH_writeJson(const char *path, const char *ecu, const BENCH_ResultType *results, uint8_t count);
+
+#endif /* BENCH_H_ */
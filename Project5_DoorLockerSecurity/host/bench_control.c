@@ -0,0 +1,427 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: bench_control.c
+ * Description: Bench of the Control ECU drivers (external EEPROM over TWI, PWM,
+ *              DC motor, PIN hash, credential table & journal) on the simulated ATmega32, the results
+ *              are written as JSON.
+ *              Usage: bench_mc2 [json file], stdout by default.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include "bench.h"
+#include "twi.h"
+#include "external_eeprom.h"
+#include "pwm.h"
+#include "dc_motor.h"
+#include "credential.h"
+#include "journal.h"
+#include "pin_hash.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define BENCH_EEPROM_BYTES				16
+#define BENCH_EEPROM_ADDRESS			0x740	/* after the credential table */
+#define BENCH_EEPROM_PAGE_ADDRESS		0x780
+#define BENCH_EEPROM_PAGE_SIZE			16
+#define BENCH_EEPROM_PAGES				8
+#define BENCH_PWM_CALLS					16
+#define BENCH_MOTOR_TICKS				1000
+#define BENCH_CREDENTIALS				100
+#define BENCH_JOURNAL_WRITES			40		/* two and a half turns around the journal */
+#define BENCH_PIN_HASH_CALLS			16
+
+typedef enum
+{
+	BENCH_EEPROM_WRITE_BYTE, BENCH_EEPROM_READ_BYTE, BENCH_EEPROM_WRITE_PAGE, BENCH_EEPROM_READ_BLOCK,
+	BENCH_EEPROM_CACHE_LOAD, BENCH_EEPROM_READ_BLOCK_CACHED, BENCH_EEPROM_WRITE_PAGE_CACHED, BENCH_EEPROM_FLUSH,
+	BENCH_PWM_TIMER0_START, BENCH_PWM_TIMER0_SET_DUTY, BENCH_DC_MOTOR_ROTATE, BENCH_DC_MOTOR_TICK,
+	BENCH_PIN_HASH_COMPUTE,
+	BENCH_CREDENTIAL_INIT, BENCH_CREDENTIAL_ADD, BENCH_CREDENTIAL_LOOKUP_HIT, BENCH_CREDENTIAL_LOOKUP_MISS,
+	BENCH_JOURNAL_WRITE, BENCH_JOURNAL_INIT, BENCH_JOURNAL_READ,
+	BENCH_RESULTS
+}BENCH_ControlResultType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static const TWI_ConfigType g_twiConfiguration = {0x01, BR_400K};
+
+/* The ticks run through the whole profile, ramps & cruise */
+static const DcMotor_ProfileType g_profile = {DC_MOTOR_S_CURVE, 100, 300, 300, 300};
+
+static BENCH_ResultType g_results[BENCH_RESULTS] =
+{
+	{"EEPROM_writeByte"},
+	{"EEPROM_readByte"},
+	{"EEPROM_writePage_16"},
+	{"EEPROM_readBlock_16"},
+	{"EEPROM_cacheLoad_16"},
+	{"EEPROM_readBlock_16_cached"},
+	{"EEPROM_writePage_16_cached"},
+	{"EEPROM_flush_16"},
+	{"PWM_Timer0_Start"},
+	{"PWM_Timer0_setDuty"},
+	{"DcMotor_Rotate"},
+	{"DcMotor_tick"},
+	{"PIN_HASH_compute"},
+	{"CREDENTIAL_init"},
+	{"CREDENTIAL_add"},
+	{"CREDENTIAL_lookup_hit"},
+	{"CREDENTIAL_lookup_miss"},
+	{"JOURNAL_write"},
+	{"JOURNAL_init"},
+	{"JOURNAL_read"}
+};
+
+/* Set when a driver call fails, the bench then fails */
+static uint8 g_failed = FALSE;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static void BENCH_check(uint8 status, const char *name)
+{
+	if(status != SUCCESS)
+	{
+		fprintf(stderr, "%s failed\n", name);
+		g_failed = TRUE;
+	}
+}
+
+/*
+ * Description :
+ * The writes include the ACK polling of the EEPROM internal write cycle, the cached
+ * writes only reach the EEPROM in the flush.
+ */
+static void BENCH_eeprom(void)
+{
+	EEPROM_RequestType request;
+	uint8 page[BENCH_EEPROM_PAGE_SIZE];
+	uint64_t begin;
+	uint8 data;
+	uint8 i;
+
+	TWI_init(&g_twiConfiguration);
+
+	for(i = 0; i < BENCH_EEPROM_BYTES; i++)
+	{
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_writeByte(BENCH_EEPROM_ADDRESS + i, i), "EEPROM_writeByte");
+		BENCH_end(&g_results[BENCH_EEPROM_WRITE_BYTE], begin);
+	}
+
+	for(i = 0; i < BENCH_EEPROM_BYTES; i++)
+	{
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_readByte(BENCH_EEPROM_ADDRESS + i, &data), "EEPROM_readByte");
+		BENCH_end(&g_results[BENCH_EEPROM_READ_BYTE], begin);
+		BENCH_check((data == i) ? SUCCESS : ERROR, "EEPROM_readByte data");
+	}
+
+	for(i = 0; i < BENCH_EEPROM_PAGE_SIZE; i++)
+	{
+		page[i] = (uint8)(0xA0 + i);
+	}
+	for(i = 0; i < BENCH_EEPROM_PAGES; i++)
+	{
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_writePage(BENCH_EEPROM_PAGE_ADDRESS + (i * BENCH_EEPROM_PAGE_SIZE), page,
+				BENCH_EEPROM_PAGE_SIZE), "EEPROM_writePage");
+		BENCH_end(&g_results[BENCH_EEPROM_WRITE_PAGE], begin);
+	}
+	for(i = 0; i < BENCH_EEPROM_PAGES; i++)
+	{
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_readBlock(BENCH_EEPROM_PAGE_ADDRESS + (i * BENCH_EEPROM_PAGE_SIZE), page,
+				BENCH_EEPROM_PAGE_SIZE), "EEPROM_readBlock");
+		BENCH_end(&g_results[BENCH_EEPROM_READ_BLOCK], begin);
+	}
+
+	begin = BENCH_begin();
+	BENCH_check(EEPROM_cacheLoad(BENCH_EEPROM_ADDRESS, BENCH_EEPROM_PAGE_SIZE), "EEPROM_cacheLoad");
+	BENCH_end(&g_results[BENCH_EEPROM_CACHE_LOAD], begin);
+	for(i = 0; i < BENCH_EEPROM_PAGES; i++)
+	{
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_readBlock(BENCH_EEPROM_ADDRESS, page, BENCH_EEPROM_PAGE_SIZE), "EEPROM_readBlock cached");
+		BENCH_end(&g_results[BENCH_EEPROM_READ_BLOCK_CACHED], begin);
+		BENCH_check((page[i] == i) ? SUCCESS : ERROR, "EEPROM_readBlock cached data");
+	}
+	for(i = 0; i < BENCH_EEPROM_PAGES; i++)
+	{
+		page[0] = i;
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_writePage(BENCH_EEPROM_ADDRESS, page, BENCH_EEPROM_PAGE_SIZE), "EEPROM_writePage cached");
+		BENCH_end(&g_results[BENCH_EEPROM_WRITE_PAGE_CACHED], begin);
+
+		begin = BENCH_begin();
+		BENCH_check(EEPROM_flush(), "EEPROM_flush");
+		BENCH_end(&g_results[BENCH_EEPROM_FLUSH], begin);
+	}
+
+	/* a dirty cached byte read across the page boundary with the next page that isn't cached */
+	BENCH_check(EEPROM_writeByte(BENCH_EEPROM_ADDRESS + BENCH_EEPROM_PAGE_SIZE - 1, 0x5A), "EEPROM_writeByte cached");
+	BENCH_check(EEPROM_readBlockAsync(&request, BENCH_EEPROM_ADDRESS + BENCH_EEPROM_PAGE_SIZE - 2, page, 4, NULL_PTR),
+			"EEPROM_readBlockAsync");
+	while(request.transaction.status == TWI_PENDING)
+	{
+		HAL_BUSY_WAIT();
+	}
+	BENCH_check(((request.transaction.status == TWI_DONE) && (page[1] == 0x5A)) ? SUCCESS : ERROR,
+			"EEPROM_readBlockAsync dirty page");
+}
+
+static void BENCH_motor(void)
+{
+	uint64_t begin;
+	uint16 i16;
+	uint8 i;
+
+	for(i = 0; i < BENCH_PWM_CALLS; i++)
+	{
+		begin = BENCH_begin();
+		PWM_Timer0_Start((uint8)((i * 100) / (BENCH_PWM_CALLS - 1)));
+		BENCH_end(&g_results[BENCH_PWM_TIMER0_START], begin);
+	}
+	for(i = 0; i < BENCH_PWM_CALLS; i++)
+	{
+		begin = BENCH_begin();
+		PWM_Timer0_setDuty((uint8)((i * 100) / (BENCH_PWM_CALLS - 1)));
+		BENCH_end(&g_results[BENCH_PWM_TIMER0_SET_DUTY], begin);
+	}
+
+	DcMotor_init();
+	for(i = 0; i < BENCH_PWM_CALLS; i++)
+	{
+		begin = BENCH_begin();
+		DcMotor_Rotate((i & 1) ? CW : OFF, 100);
+		BENCH_end(&g_results[BENCH_DC_MOTOR_ROTATE], begin);
+	}
+	DcMotor_Rotate(OFF, 0);
+
+	DcMotor_moveProfile(CW, &g_profile);
+	for(i16 = 0; i16 < BENCH_MOTOR_TICKS; i16++)
+	{
+		begin = BENCH_begin();
+		DcMotor_tick();
+		BENCH_end(&g_results[BENCH_DC_MOTOR_TICK], begin);
+	}
+	BENCH_check((DcMotor_isMoving() == FALSE) ? SUCCESS : ERROR, "DcMotor_moveProfile end");
+
+	/* S-curve distance 300 * (u^3 - u^4 / 2) in the middle of the ramps, 28.125 ms at full speed */
+	BENCH_check(((DcMotor_profileDistance(&g_profile, 150) == 28) &&
+			(DcMotor_profileDistance(&g_profile, 450) == 300) &&
+			(DcMotor_profileDistance(&g_profile, 750) == 572) &&
+			(DcMotor_profileDistance(&g_profile, BENCH_MOTOR_TICKS) == 600)) ? SUCCESS : ERROR, "DcMotor_profileDistance");
+}
+
+/*
+ * Description :
+ * HalfSipHash-2-4 with the 64-bit output of the message 00 01 02 03 04 under the key
+ * 00 01 .. 07, from the test vectors of the reference implementation. The hash key is
+ * the build key xor the salt, so the salt is chosen to give the reference key.
+ */
+static void BENCH_pinHash(void)
+{
+	static const uint8 reference[PIN_HASH_DIGEST_SIZE] = {0xCB, 0x9D, 0x7C, 0x3F, 0x2F, 0x3D, 0xB5, 0x80};
+	static const uint8 build_key[PIN_HASH_SALT_SIZE] = PIN_HASH_KEY;
+	uint8 salt[PIN_HASH_SALT_SIZE];
+	uint8 pin[PIN_HASH_PIN_SIZE];
+	uint8 digest[PIN_HASH_DIGEST_SIZE];
+	uint64_t begin;
+	uint8 i;
+
+	for(i = 0; i < PIN_HASH_SALT_SIZE; i++)
+	{
+		salt[i] = build_key[i] ^ i;
+	}
+	for(i = 0; i < PIN_HASH_PIN_SIZE; i++)
+	{
+		pin[i] = i;
+	}
+	PIN_HASH_setSalt(salt);
+
+	for(i = 0; i < BENCH_PIN_HASH_CALLS; i++)
+	{
+		begin = BENCH_begin();
+		PIN_HASH_compute(pin, digest);
+		BENCH_end(&g_results[BENCH_PIN_HASH_COMPUTE], begin);
+	}
+	BENCH_check(PIN_HASH_equal(digest, reference, PIN_HASH_DIGEST_SIZE) ? SUCCESS : ERROR, "PIN_HASH_compute vector");
+}
+
+/*
+ * Description :
+ * Digest of the PIN with the digits of number, the PINs of the holders are
+ * 0 .. BENCH_CREDENTIALS - 1, the PIN BENCH_CREDENTIALS + i is never added.
+ */
+static void BENCH_digest(uint16 number, uint8 *digest)
+{
+	uint8 pin[PIN_HASH_PIN_SIZE];
+	uint8 i;
+
+	for(i = PIN_HASH_PIN_SIZE; i > 0; i--)
+	{
+		pin[i - 1] = (uint8)(number % 10);
+		number /= 10;
+	}
+	PIN_HASH_compute(pin, digest);
+}
+
+/*
+ * Description :
+ * Time of a whole lookup, from its start until the last EEPROM read is done.
+ */
+static CREDENTIAL_StatusType BENCH_lookup(const uint8 *digest, BENCH_ResultType *result)
+{
+	CREDENTIAL_StatusType status;
+	uint64_t begin = BENCH_begin();
+
+	CREDENTIAL_lookupStart(digest);
+	while((status = CREDENTIAL_lookupPoll()) == CREDENTIAL_PENDING)
+	{
+		HAL_BUSY_WAIT();
+	}
+	BENCH_end(result, begin);
+	return status;
+}
+
+/*
+ * Description :
+ * The misses rejected by the Bloom filter don't read the EEPROM, only its false positives
+ * walk the index. The filter is built again by the init with the same bits.
+ */
+static void BENCH_credential(void)
+{
+	CREDENTIAL_FilterInfoType info;
+	CREDENTIAL_FilterInfoType boot;
+	uint8 digest[PIN_HASH_DIGEST_SIZE];
+	uint64_t begin;
+	uint8 id;
+	uint8 removed = 0;
+	uint16 i;
+
+	begin = BENCH_begin();
+	CREDENTIAL_init();
+	BENCH_end(&g_results[BENCH_CREDENTIAL_INIT], begin);
+
+	for(i = 0; i < BENCH_CREDENTIALS; i++)
+	{
+		BENCH_digest(i, digest);
+		begin = BENCH_begin();
+		BENCH_check((CREDENTIAL_add(digest, &id) == CREDENTIAL_OK) ? SUCCESS : ERROR, "CREDENTIAL_add");
+		BENCH_end(&g_results[BENCH_CREDENTIAL_ADD], begin);
+		if(i == 0)
+		{
+			removed = id;
+		}
+	}
+	BENCH_check((CREDENTIAL_count() == BENCH_CREDENTIALS) ? SUCCESS : ERROR, "CREDENTIAL_count");
+
+	for(i = 0; i < BENCH_CREDENTIALS; i++)
+	{
+		BENCH_digest(i, digest);
+		BENCH_check((BENCH_lookup(digest, &g_results[BENCH_CREDENTIAL_LOOKUP_HIT]) == CREDENTIAL_OK) ? SUCCESS : ERROR,
+				"CREDENTIAL_lookup hit");
+		BENCH_digest(BENCH_CREDENTIALS + i, digest);
+		BENCH_check((BENCH_lookup(digest, &g_results[BENCH_CREDENTIAL_LOOKUP_MISS]) == CREDENTIAL_NOT_FOUND) ?
+				SUCCESS : ERROR, "CREDENTIAL_lookup miss");
+	}
+
+	CREDENTIAL_filterInfo(&info);
+	BENCH_check(((info.entries == BENCH_CREDENTIALS) && (info.rejected + info.falsePositives == BENCH_CREDENTIALS)) ?
+			SUCCESS : ERROR, "CREDENTIAL_filterInfo");
+
+	CREDENTIAL_init();
+	CREDENTIAL_filterInfo(&boot);
+	BENCH_check(((boot.entries == info.entries) && (boot.bitsSet == info.bitsSet)) ? SUCCESS : ERROR,
+			"CREDENTIAL_init filter");
+
+	/* the filter after a remove should be the one built at boot from the other holders */
+	BENCH_check((CREDENTIAL_remove(removed) == CREDENTIAL_OK) ? SUCCESS : ERROR, "CREDENTIAL_remove");
+	BENCH_digest(0, digest);
+	BENCH_check((BENCH_lookup(digest, &g_results[BENCH_CREDENTIAL_LOOKUP_MISS]) == CREDENTIAL_NOT_FOUND) ?
+			SUCCESS : ERROR, "CREDENTIAL_lookup removed");
+	CREDENTIAL_filterInfo(&info);
+	CREDENTIAL_init();
+	CREDENTIAL_filterInfo(&boot);
+	BENCH_check(((info.entries == (BENCH_CREDENTIALS - 1)) && (boot.entries == info.entries) &&
+			(boot.bitsSet == info.bitsSet)) ? SUCCESS : ERROR, "CREDENTIAL_remove filter");
+}
+
+/*
+ * Description :
+ * The record i holds i in all its bytes. After the writes the newest record is broken
+ * like by a power loss during its write cycle, the recovery should find the previous one.
+ */
+static void BENCH_journal(void)
+{
+	uint8 data[JOURNAL_DATA_SIZE];
+	uint64_t begin;
+	uint16 slot;
+	uint8 length;
+	uint8 i;
+	uint8 j;
+
+	JOURNAL_init();
+	for(i = 0; i < BENCH_JOURNAL_WRITES; i++)
+	{
+		for(j = 0; j < JOURNAL_DATA_SIZE; j++)
+		{
+			data[j] = i;
+		}
+		begin = BENCH_begin();
+		BENCH_check((JOURNAL_write(JOURNAL_KEY_PASSWORD, data, JOURNAL_DATA_SIZE) == JOURNAL_OK) ? SUCCESS : ERROR,
+				"JOURNAL_write");
+		BENCH_end(&g_results[BENCH_JOURNAL_WRITE], begin);
+	}
+
+	/* a record whose flush failed must not reach the eeprom with a later flush, its slot is
+	 * the one after the newest record and it is cached first to be written back */
+	slot = JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD) - JOURNAL_DATA_OFFSET - JOURNAL_REGION_ADDRESS;
+	slot = JOURNAL_REGION_ADDRESS + ((slot + JOURNAL_RECORD_SIZE) % (JOURNAL_SLOTS * JOURNAL_RECORD_SIZE));
+	BENCH_check(EEPROM_readByte(slot, &j), "JOURNAL cache the next slot");
+	for(j = 0; j < JOURNAL_DATA_SIZE; j++)
+	{
+		data[j] = 0xEE;
+	}
+	SIM_twiGlitch();
+	BENCH_check((JOURNAL_write(JOURNAL_KEY_PASSWORD, data, JOURNAL_DATA_SIZE) == JOURNAL_EEPROM_ERROR) ?
+			SUCCESS : ERROR, "JOURNAL_write failed flush");
+	BENCH_check(EEPROM_flush(), "JOURNAL flush after the failed write");
+	JOURNAL_init();
+	BENCH_check(((JOURNAL_read(JOURNAL_KEY_PASSWORD, data, &length) == JOURNAL_OK) &&
+			(data[0] == BENCH_JOURNAL_WRITES - 1)) ? SUCCESS : ERROR, "JOURNAL failed write dropped");
+
+	BENCH_check(EEPROM_writeByte(JOURNAL_dataAddress(JOURNAL_KEY_PASSWORD), 0x00), "JOURNAL break the record");
+
+	begin = BENCH_begin();
+	JOURNAL_init();
+	BENCH_end(&g_results[BENCH_JOURNAL_INIT], begin);
+
+	begin = BENCH_begin();
+	BENCH_check((JOURNAL_read(JOURNAL_KEY_PASSWORD, data, &length) == JOURNAL_OK) ? SUCCESS : ERROR, "JOURNAL_read");
+	BENCH_end(&g_results[BENCH_JOURNAL_READ], begin);
+	BENCH_check(((length == JOURNAL_DATA_SIZE) && (data[0] == BENCH_JOURNAL_WRITES - 2)) ? SUCCESS : ERROR,
+			"JOURNAL recovery");
+}
+
+int main(int argc, char *argv[])
+{
+	sei();
+	BENCH_eeprom();
+	BENCH_motor();
+	BENCH_pinHash();
+	BENCH_credential();
+	BENCH_journal();
+
+	if(BENCH_writeJson((argc > 1) ? argv[1] : NULL, "MC2", g_results, BENCH_RESULTS) != 0)
+	{
+		return EXIT_FAILURE;
+	}
+	return (g_failed == FALSE) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: bench_hmi.c
+ * Description: Bench of the HMI ECU drivers (UART, LCD & keypad) on the simulated
+ *              ATmega32, the results are written as JSON.
+ *              Usage: bench_mc1 [json file], stdout by default.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <stdlib.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include "bench.h"
+#include "uart.h"
+#include "lcd.h"
+#include "keypad.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define BENCH_UART_BYTES				64
+#define BENCH_LCD_STRINGS				16
+#define BENCH_KEYPAD_TICKS				1000
+
+/* Keys pressed while the keypad ticks run, so the scans see pressed keys too */
+#define BENCH_KEYPAD_SCRIPT				"5 5 5 5"
+
+typedef enum
+{
+	BENCH_UART_SEND_BYTE, BENCH_LCD_DISPLAY_STRING, BENCH_LCD_DISPLAY_STRING_DONE, BENCH_KEYPAD_TICK,
+	BENCH_RESULTS
+}BENCH_HmiResultType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static const UART_ConfigType g_uartConfiguration = {EIGHT_BITS, DISABLED, ONE_BIT, BD_9600, ASYNCHRONOUS, ASYNCHRONOUS_DOUBLE_SPEED};
+
+static BENCH_ResultType g_results[BENCH_RESULTS] =
+{
+	{"UART_sendByte"},
+	{"LCD_displayString"},
+	{"LCD_displayString_until_idle"},
+	{"KEYPAD_tick"}
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * The bytes are sent back to back, the first calls only fill the TX buffer and
+ * the last ones wait for the UART to free a place.
+ */
+static void BENCH_uart(void)
+{
+	uint64_t begin;
+	uint8 i;
+
+	UART_init(&g_uartConfiguration);
+	for(i = 0; i < BENCH_UART_BYTES; i++)
+	{
+		begin = BENCH_begin();
+		UART_sendByte(i);
+		BENCH_end(&g_results[BENCH_UART_SEND_BYTE], begin);
+	}
+}
+
+/*
+ * Description :
+ * Time to queue a full row & time until the Timer2 interrupt has sent it to the LCD.
+ */
+static void BENCH_lcd(void)
+{
+	uint64_t begin;
+	uint8 i;
+
+	LCD_init();
+	while(LCD_isIdle() == FALSE){HAL_BUSY_WAIT();}
+
+	for(i = 0; i < BENCH_LCD_STRINGS; i++)
+	{
+		LCD_moveCursor(i & 1, 0);
+		while(LCD_isIdle() == FALSE){HAL_BUSY_WAIT();}
+
+		begin = BENCH_begin();
+		LCD_displayString("Plz Enter Pass: ");
+		BENCH_end(&g_results[BENCH_LCD_DISPLAY_STRING], begin);
+		while(LCD_isIdle() == FALSE){HAL_BUSY_WAIT();}
+		BENCH_end(&g_results[BENCH_LCD_DISPLAY_STRING_DONE], begin);
+	}
+}
+
+/*
+ * Description :
+ * One tick per ms like the scheduler tick, only some of the ticks scan the keypad.
+ */
+static void BENCH_keypad(void)
+{
+	KEYPAD_EventType event;
+	uint64_t begin;
+	uint16 i;
+
+	KEYPAD_init();
+	for(i = 0; i < BENCH_KEYPAD_TICKS; i++)
+	{
+		begin = BENCH_begin();
+		KEYPAD_tick();
+		BENCH_end(&g_results[BENCH_KEYPAD_TICK], begin);
+
+		while(KEYPAD_poll(&event) == TRUE);
+		_delay_ms(1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	/* read by the keypad model on the first register access */
+	setenv("HAL_KEYPAD", BENCH_KEYPAD_SCRIPT, 0);
+
+	sei();
+	BENCH_uart();
+	BENCH_lcd();
+	BENCH_keypad();
+
+	return (BENCH_writeJson((argc > 1) ? argv[1] : NULL, "MC1", g_results, BENCH_RESULTS) == 0) ?
+			EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,652 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: door_sim.c
+ * Description: Runs the host builds of MC1 & MC2 together, the UART of each ECU is
+ *              connected by a socket pair (HAL_UART_FD) to this process which passes
+ *              the bytes to the other ECU like the wire between them.
+ *              Usage: door_sim [mc1_host] [mc2_host], the HAL_* options are passed on.
+ *
+ * The wire can be made worse with these options:
+ *   HAL_LINK_BAUD          the wire carries one 10 bits frame per byte at this baud
+ *                          rate, a faster sender is slowed down to it (0: no limit)
+ *   HAL_LINK_LATENCY_US    delay added to every byte
+ *   HAL_LINK_JITTER_US     random delay of 0 .. jitter added to every byte
+ *   HAL_LINK_DROP_PPM      bytes lost per million
+ *   HAL_LINK_BIT_ERROR_PPM data bits flipped per million
+ *   HAL_LINK_SEED          seed of the random drops, errors & jitter
+ *   HAL_LINK_JSON          file the requests latencies are also written to as JSON
+ * The frames on the wire are decoded to measure the time from the start of each
+ * MC1 request to the end of the MC2 reply (to the end of the request when MC2 does
+ * not reply), a latency histogram of each request is printed at the end.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sim.h"
+#include "sim_link.h"
+#include "protocol.h"
+#include "crc.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define DOOR_SIM_ECUS					2
+#define DOOR_SIM_HMI					0
+#define DOOR_SIM_CONTROL				1
+
+/* The socket end of each ECU is moved to this descriptor */
+#define DOOR_SIM_LINK_FD				3
+
+/* Start, 8 data & stop bits */
+#define DOOR_SIM_FRAME_BITS				10
+
+#define DOOR_SIM_HISTOGRAM_BUCKETS		10
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* States of the decoder of the protocol frames on the wire, like protocol.c */
+typedef enum
+{
+	FRAME_WAIT_START, FRAME_WAIT_COMMAND, FRAME_WAIT_LENGTH, FRAME_WAIT_PAYLOAD, FRAME_WAIT_CRC
+}DOOR_SIM_FrameStateType;
+
+/* Bytes sent by one ECU */
+typedef struct
+{
+	const char *name;
+	int fd;
+	uint8_t message[SIM_LINK_MESSAGE_SIZE];
+	uint8_t messageLength;
+	uint64_t time;				/* sender time of the last message */
+	uint64_t lastArrival;		/* arrival time of the last byte */
+	uint64_t random;
+
+	/* frame decoder of the bytes as the other ECU receives them */
+	DOOR_SIM_FrameStateType frameState;
+	uint8_t frameCommand;
+	uint8_t frameRemaining;
+	uint8_t frameCrc;
+	uint64_t frameStart;
+
+	/* statistics */
+	uint64_t bytes;
+	uint64_t dropped;
+	uint64_t corrupted;
+	uint64_t badFrames;
+}DOOR_SIM_PortType;
+
+/* Request sent by MC1 */
+typedef struct
+{
+	uint8_t command;
+	const char *name;
+	uint8_t replied;			/* MC2 answers it with a frame */
+	uint64_t count;
+	uint64_t unanswered;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint64_t histogram[DOOR_SIM_HISTOGRAM_BUCKETS];
+}DOOR_SIM_TransactionType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static DOOR_SIM_PortType g_ports[DOOR_SIM_ECUS] = {{"MC1", -1}, {"MC2", -1}};
+
+static DOOR_SIM_TransactionType g_transactions[] =
+{
+	{SAVE_PASSWORD,			"SAVE_PASSWORD",		1},
+	{PASSWORD_CHECK,		"PASSWORD_CHECK",		1},
+	{UNLOCK_THE_DOOR,		"UNLOCK_THE_DOOR",		0},
+	{DOOR_STATUS_REQUEST,	"DOOR_STATUS_REQUEST",	1},
+	{BUZZER_ON_BYTE,		"BUZZER_ON_BYTE",		0},
+	{EMERGENCY_LOCK,		"EMERGENCY_LOCK",		0},
+	{CREDENTIAL_ADD,		"CREDENTIAL_ADD",		1},
+	{CREDENTIAL_REMOVE,		"CREDENTIAL_REMOVE",	1},
+	{CREDENTIAL_LIST,		"CREDENTIAL_LIST",		1},
+	{CREDENTIAL_FILTER_INFO,	"CREDENTIAL_FILTER_INFO",	1}
+};
+
+/* Upper limits of the histogram buckets in ms, the last bucket has no limit */
+static const uint32_t g_bucketLimits[DOOR_SIM_HISTOGRAM_BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+
+/* Request waiting for the reply of MC2 */
+static DOOR_SIM_TransactionType *g_pending = NULL;
+static uint64_t g_pendingStart;
+
+/* Wire options in CPU cycles */
+static uint64_t g_frameCycles;
+static uint64_t g_latency;
+static uint64_t g_jitter;
+static uint64_t g_dropPpm;
+static uint64_t g_bitErrorPpm;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static uint64_t DOOR_SIM_option(const char *name, uint64_t default_value)
+{
+	const char *value = getenv(name);
+
+	return (value != NULL) ? strtoull(value, NULL, 0) : default_value;
+}
+
+/*
+ * Description :
+ * xorshift64* generator, each ECU has its own so a run does not depend on the
+ * order the two ECUs are served in.
+ */
+static uint64_t DOOR_SIM_random(DOOR_SIM_PortType *port)
+{
+	port->random ^= port->random >> 12;
+	port->random ^= port->random << 25;
+	port->random ^= port->random >> 27;
+	return port->random * 0x2545F4914F6CDD1DULL;
+}
+
+static int DOOR_SIM_chance(DOOR_SIM_PortType *port, uint64_t ppm)
+{
+	return (ppm != 0) && ((DOOR_SIM_random(port) % 1000000ULL) < ppm);
+}
+
+static void DOOR_SIM_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void DOOR_SIM_log(const char *format, ...)
+{
+	uint64_t now = g_ports[DOOR_SIM_HMI].time;
+	va_list args;
+
+	if(g_ports[DOOR_SIM_CONTROL].time > now)
+	{
+		now = g_ports[DOOR_SIM_CONTROL].time;
+	}
+	printf("LINK %11.3f ms  ", (double)now / (double)SIM_CYCLES_PER_MS);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	putchar('\n');
+}
+
+static void DOOR_SIM_record(DOOR_SIM_TransactionType *transaction, uint64_t latency)
+{
+	uint8_t bucket = 0;
+
+	while((bucket < DOOR_SIM_HISTOGRAM_BUCKETS - 1) && (latency >= g_bucketLimits[bucket] * SIM_CYCLES_PER_MS))
+	{
+		bucket++;
+	}
+	transaction->histogram[bucket]++;
+
+	if((transaction->count == 0) || (latency < transaction->min))
+	{
+		transaction->min = latency;
+	}
+	if(latency > transaction->max)
+	{
+		transaction->max = latency;
+	}
+	transaction->sum += latency;
+	transaction->count++;
+}
+
+/*
+ * Description :
+ * A valid frame reached the other ECU, start & end are the sender time of its
+ * start byte & the arrival time of its CRC byte.
+ */
+static void DOOR_SIM_frameDone(DOOR_SIM_PortType *port, uint64_t start, uint64_t end)
+{
+	uint8_t i;
+
+	if(port == &g_ports[DOOR_SIM_CONTROL])
+	{
+		/* MC2 only sends frames to answer the requests */
+		if(g_pending != NULL)
+		{
+			DOOR_SIM_record(g_pending, end - g_pendingStart);
+			g_pending = NULL;
+		}
+		return;
+	}
+
+	for(i = 0; i < sizeof(g_transactions) / sizeof(g_transactions[0]); i++)
+	{
+		if(g_transactions[i].command != port->frameCommand)
+		{
+			continue;
+		}
+		if(!g_transactions[i].replied)
+		{
+			DOOR_SIM_record(&g_transactions[i], end - start);
+			return;
+		}
+		if(g_pending != NULL)
+		{
+			/* MC1 stopped waiting for the last reply */
+			g_pending->unanswered++;
+		}
+		g_pending = &g_transactions[i];
+		g_pendingStart = start;
+		return;
+	}
+}
+
+static void DOOR_SIM_frameByte(DOOR_SIM_PortType *port, uint8_t data, uint64_t sent, uint64_t arrival)
+{
+	switch(port->frameState)
+	{
+	case FRAME_WAIT_START:
+		if(data == PROTOCOL_START_BYTE)
+		{
+			port->frameStart = sent;
+			port->frameCrc = CRC8_INITIAL_VALUE;
+			port->frameState = FRAME_WAIT_COMMAND;
+		}
+		break;
+
+	case FRAME_WAIT_COMMAND:
+		port->frameCommand = data;
+		port->frameCrc = CRC_crc8Update(port->frameCrc, data);
+		port->frameState = FRAME_WAIT_LENGTH;
+		break;
+
+	case FRAME_WAIT_LENGTH:
+		if(data > PROTOCOL_MAX_PAYLOAD)
+		{
+			port->badFrames++;
+			port->frameState = FRAME_WAIT_START;
+			break;
+		}
+		port->frameRemaining = data;
+		port->frameCrc = CRC_crc8Update(port->frameCrc, data);
+		port->frameState = (data == 0) ? FRAME_WAIT_CRC : FRAME_WAIT_PAYLOAD;
+		break;
+
+	case FRAME_WAIT_PAYLOAD:
+		port->frameCrc = CRC_crc8Update(port->frameCrc, data);
+		port->frameRemaining--;
+		if(port->frameRemaining == 0)
+		{
+			port->frameState = FRAME_WAIT_CRC;
+		}
+		break;
+
+	case FRAME_WAIT_CRC:
+		port->frameState = FRAME_WAIT_START;
+		if(data != port->frameCrc)
+		{
+			port->badFrames++;
+			break;
+		}
+		DOOR_SIM_frameDone(port, port->frameStart, arrival);
+		break;
+	}
+}
+
+/*
+ * Description :
+ * One ECU ended, the other one sees its link closed.
+ */
+static void DOOR_SIM_disconnect(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		if(g_ports[i].fd >= 0)
+		{
+			close(g_ports[i].fd);
+			g_ports[i].fd = -1;
+		}
+	}
+}
+
+static void DOOR_SIM_send(DOOR_SIM_PortType *port, const uint8_t *message)
+{
+	ssize_t sent;
+	size_t offset = 0;
+
+	while((port->fd >= 0) && (offset < SIM_LINK_MESSAGE_SIZE))
+	{
+		sent = send(port->fd, &message[offset], SIM_LINK_MESSAGE_SIZE - offset, MSG_NOSIGNAL);
+		if(sent < 0)
+		{
+			if(errno != EINTR)
+			{
+				DOOR_SIM_disconnect();
+			}
+			continue;
+		}
+		offset += (size_t)sent;
+	}
+}
+
+/*
+ * Description :
+ * Pass a complete message of the source ECU to the other one, a byte on the wire
+ * may be delayed, lost or corrupted. A lost byte still passes its sender time.
+ */
+static void DOOR_SIM_forward(DOOR_SIM_PortType *source, DOOR_SIM_PortType *destination)
+{
+	uint8_t *message = source->message;
+	uint64_t arrival;
+	uint8_t data;
+	uint8_t bit;
+
+	source->time = SIM_linkGet64(&message[SIM_LINK_SENDER_TIME_OFFSET]);
+	if(message[SIM_LINK_TYPE_OFFSET] == SIM_LINK_DATA)
+	{
+		source->bytes++;
+		if(DOOR_SIM_chance(source, g_dropPpm))
+		{
+			source->dropped++;
+			message[SIM_LINK_TYPE_OFFSET] = SIM_LINK_TIME;
+		}
+		else
+		{
+			data = message[SIM_LINK_DATA_OFFSET];
+			for(bit = 0; bit < 8; bit++)
+			{
+				if(DOOR_SIM_chance(source, g_bitErrorPpm))
+				{
+					data ^= (uint8_t)(1 << bit);
+				}
+			}
+			if(data != message[SIM_LINK_DATA_OFFSET])
+			{
+				source->corrupted++;
+				message[SIM_LINK_DATA_OFFSET] = data;
+			}
+
+			/* a later arrival keeps the lookahead promise of the sender, the order is kept */
+			arrival = SIM_linkGet64(&message[SIM_LINK_ARRIVAL_OFFSET]) + g_latency;
+			if(g_jitter != 0)
+			{
+				arrival += DOOR_SIM_random(source) % (g_jitter + 1);
+			}
+			if(arrival < source->lastArrival + g_frameCycles)
+			{
+				arrival = source->lastArrival + g_frameCycles;
+			}
+			source->lastArrival = arrival;
+			SIM_linkPut64(&message[SIM_LINK_ARRIVAL_OFFSET], arrival);
+
+			DOOR_SIM_frameByte(source, data, source->time, arrival);
+		}
+	}
+	DOOR_SIM_send(destination, message);
+}
+
+/*
+ * Description :
+ * Read the messages of the source ECU.
+ */
+static void DOOR_SIM_receive(DOOR_SIM_PortType *source, DOOR_SIM_PortType *destination)
+{
+	uint8_t buffer[64 * SIM_LINK_MESSAGE_SIZE];
+	ssize_t received;
+	ssize_t i;
+
+	received = read(source->fd, buffer, sizeof(buffer));
+	if((received < 0) && (errno == EINTR))
+	{
+		return;
+	}
+	if(received <= 0)
+	{
+		DOOR_SIM_disconnect();
+		return;
+	}
+
+	for(i = 0; i < received; i++)
+	{
+		source->message[source->messageLength++] = buffer[i];
+		if(source->messageLength == SIM_LINK_MESSAGE_SIZE)
+		{
+			source->messageLength = 0;
+			DOOR_SIM_forward(source, destination);
+		}
+	}
+}
+
+static void DOOR_SIM_relay(void)
+{
+	struct pollfd fds[DOOR_SIM_ECUS];
+	uint8_t i;
+
+	while((g_ports[DOOR_SIM_HMI].fd >= 0) || (g_ports[DOOR_SIM_CONTROL].fd >= 0))
+	{
+		for(i = 0; i < DOOR_SIM_ECUS; i++)
+		{
+			fds[i].fd = g_ports[i].fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if((poll(fds, DOOR_SIM_ECUS, -1) < 0) && (errno != EINTR))
+		{
+			perror("poll");
+			return;
+		}
+		for(i = 0; i < DOOR_SIM_ECUS; i++)
+		{
+			if((g_ports[i].fd >= 0) && (fds[i].revents != 0))
+			{
+				DOOR_SIM_receive(&g_ports[i], &g_ports[1 - i]);
+			}
+		}
+	}
+}
+
+static void DOOR_SIM_report(void)
+{
+	DOOR_SIM_TransactionType *transaction;
+	char histogram[256];
+	int length;
+	uint8_t i;
+	uint8_t bucket;
+
+	if(g_pending != NULL)
+	{
+		g_pending->unanswered++;
+		g_pending = NULL;
+	}
+
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		DOOR_SIM_log("%s -> %s %llu bytes, %llu dropped, %llu corrupted, %llu bad frames", g_ports[i].name,
+				g_ports[1 - i].name, (unsigned long long)g_ports[i].bytes, (unsigned long long)g_ports[i].dropped,
+				(unsigned long long)g_ports[i].corrupted, (unsigned long long)g_ports[i].badFrames);
+	}
+
+	for(i = 0; i < sizeof(g_transactions) / sizeof(g_transactions[0]); i++)
+	{
+		transaction = &g_transactions[i];
+		if((transaction->count == 0) && (transaction->unanswered == 0))
+		{
+			continue;
+		}
+		if(transaction->count == 0)
+		{
+			DOOR_SIM_log("%s 0 done, %llu unanswered", transaction->name, (unsigned long long)transaction->unanswered);
+			continue;
+		}
+		DOOR_SIM_log("%s %llu done, %llu unanswered, latency min %.3f avg %.3f max %.3f ms", transaction->name,
+				(unsigned long long)transaction->count, (unsigned long long)transaction->unanswered,
+				(double)transaction->min / (double)SIM_CYCLES_PER_MS,
+				(double)transaction->sum / (double)transaction->count / (double)SIM_CYCLES_PER_MS,
+				(double)transaction->max / (double)SIM_CYCLES_PER_MS);
+
+		length = 0;
+		for(bucket = 0; bucket < DOOR_SIM_HISTOGRAM_BUCKETS; bucket++)
+		{
+			if(bucket < DOOR_SIM_HISTOGRAM_BUCKETS - 1)
+			{
+				length += snprintf(&histogram[length], sizeof(histogram) - (size_t)length, " <%u:%llu",
+						g_bucketLimits[bucket], (unsigned long long)transaction->histogram[bucket]);
+			}
+			else
+			{
+				length += snprintf(&histogram[length], sizeof(histogram) - (size_t)length, " >=%u:%llu",
+						g_bucketLimits[bucket - 1], (unsigned long long)transaction->histogram[bucket]);
+			}
+		}
+		DOOR_SIM_log("%s histogram ms%s", transaction->name, histogram);
+	}
+}
+
+/*
+ * Description :
+ * Write the requests latencies as JSON to the file named by HAL_LINK_JSON.
+ */
+static void DOOR_SIM_writeJson(const char *path)
+{
+	DOOR_SIM_TransactionType *transaction;
+	FILE *file;
+	uint8_t i;
+	uint8_t bucket;
+	uint8_t first = 1;
+
+	file = fopen(path, "w");
+	if(file == NULL)
+	{
+		perror(path);
+		return;
+	}
+
+	fprintf(file, "{\n  \"cpu_hz\": %llu,\n  \"bucket_limits_ms\": [", (unsigned long long)SIM_CPU_HZ);
+	for(bucket = 0; bucket < DOOR_SIM_HISTOGRAM_BUCKETS - 1; bucket++)
+	{
+		fprintf(file, "%s%u", (bucket != 0) ? ", " : "", g_bucketLimits[bucket]);
+	}
+	fprintf(file, "],\n  \"transactions\": [");
+
+	for(i = 0; i < sizeof(g_transactions) / sizeof(g_transactions[0]); i++)
+	{
+		transaction = &g_transactions[i];
+		if((transaction->count == 0) && (transaction->unanswered == 0))
+		{
+			continue;
+		}
+		fprintf(file, "%s\n    {\"name\": \"%s\", \"count\": %llu, \"unanswered\": %llu, \"min_cycles\": %llu, "
+				"\"avg_cycles\": %llu, \"max_cycles\": %llu, \"histogram\": [", first ? "" : ",", transaction->name,
+				(unsigned long long)transaction->count, (unsigned long long)transaction->unanswered,
+				(unsigned long long)transaction->min,
+				(unsigned long long)((transaction->count != 0) ? (transaction->sum / transaction->count) : 0),
+				(unsigned long long)transaction->max);
+		for(bucket = 0; bucket < DOOR_SIM_HISTOGRAM_BUCKETS; bucket++)
+		{
+			fprintf(file, "%s%llu", (bucket != 0) ? ", " : "", (unsigned long long)transaction->histogram[bucket]);
+		}
+		fprintf(file, "]}");
+		first = 0;
+	}
+	fprintf(file, "\n  ]\n}\n");
+	fclose(file);
+}
+
+static pid_t DOOR_SIM_start(const char *program, const char *name, int link_fd, const int *fds, uint8_t fds_count)
+{
+	pid_t pid;
+	uint8_t i;
+
+	fflush(stdout);
+	pid = fork();
+	if(pid != 0)
+	{
+		return pid;
+	}
+
+	/* only the ECU end of its own socket pair is kept */
+	for(i = 0; i < fds_count; i++)
+	{
+		if(fds[i] != link_fd)
+		{
+			close(fds[i]);
+		}
+	}
+	if(link_fd != DOOR_SIM_LINK_FD)
+	{
+		dup2(link_fd, DOOR_SIM_LINK_FD);
+		close(link_fd);
+	}
+	setenv("HAL_UART_FD", "3", 1);
+	setenv("HAL_NAME", name, 1);
+	execl(program, program, (char *)NULL);
+	perror(program);
+	_exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *programs[DOOR_SIM_ECUS] = {"./mc1_host", "./mc2_host"};
+	pid_t pids[DOOR_SIM_ECUS];
+	int fds[2 * DOOR_SIM_ECUS];
+	uint64_t baud;
+	int status;
+	int result = EXIT_SUCCESS;
+	int i;
+
+	for(i = 1; (i < argc) && (i <= DOOR_SIM_ECUS); i++)
+	{
+		programs[i - 1] = argv[i];
+	}
+
+	baud = DOOR_SIM_option("HAL_LINK_BAUD", 0);
+	g_frameCycles = (baud != 0) ? (DOOR_SIM_FRAME_BITS * SIM_CPU_HZ + baud - 1) / baud : 0;
+	g_latency = DOOR_SIM_option("HAL_LINK_LATENCY_US", 0) * SIM_CYCLES_PER_US;
+	g_jitter = DOOR_SIM_option("HAL_LINK_JITTER_US", 0) * SIM_CYCLES_PER_US;
+	g_dropPpm = DOOR_SIM_option("HAL_LINK_DROP_PPM", 0);
+	g_bitErrorPpm = DOOR_SIM_option("HAL_LINK_BIT_ERROR_PPM", 0);
+
+	/* fds[2 * i] is the end of this process, fds[2 * i + 1] the end of ECU i */
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, &fds[2 * i]) != 0)
+		{
+			perror("socketpair");
+			return EXIT_FAILURE;
+		}
+		g_ports[i].fd = fds[2 * i];
+		g_ports[i].random = (DOOR_SIM_option("HAL_LINK_SEED", 1) + 1) * 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+	}
+
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		pids[i] = DOOR_SIM_start(programs[i], g_ports[i].name, fds[2 * i + 1], fds, 2 * DOOR_SIM_ECUS);
+		if(pids[i] < 0)
+		{
+			perror("fork");
+			return EXIT_FAILURE;
+		}
+	}
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		close(fds[2 * i + 1]);
+	}
+
+	DOOR_SIM_relay();
+
+	for(i = 0; i < DOOR_SIM_ECUS; i++)
+	{
+		if((waitpid(pids[i], &status, 0) < 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+		{
+			fprintf(stderr, "%s failed\n", g_ports[i].name);
+			result = EXIT_FAILURE;
+		}
+	}
+	DOOR_SIM_report();
+	if(getenv("HAL_LINK_JSON") != NULL)
+	{
+		DOOR_SIM_writeJson(getenv("HAL_LINK_JSON"));
+	}
+	return result;
+}
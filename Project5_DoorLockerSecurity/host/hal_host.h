@@ -0,0 +1,55 @@
+ /******************************************************************************
+ * Module: HAL
+ * File Name: hal_host.h
+ * Description: Host (Linux) side of the HAL seam, every register access of the
+ *              drivers is routed to the simulated ATmega32 peripherals
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef HAL_HOST_H_
+#define HAL_HOST_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* CPU cycles charged for each register access & each pass of a busy loop */
+#define HAL_ACCESS_CYCLES				4
+#define HAL_BUSY_WAIT_CYCLES			8
+
+/* Address of a memory mapped I/O register, it points into the simulated I/O space */
+#define HAL_IO_ADDRESS(ADDRESS)			HAL_ioAccess(ADDRESS)
+
+#define HAL_BUSY_WAIT()					HAL_busyWait()
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Let the simulated hardware run for one register access then return the location
+ * the driver reads or writes for the register at address.
+ */
+volatile void *HAL_ioAccess(uint16_t address);
+
+/*
+ * Description :
+ * Let the simulated hardware run for one pass of a busy loop.
+ */
+void HAL_busyWait(void);
+
+/*
+ * Description :
+ * Let the simulated hardware run for the given number of CPU cycles (util/delay.h).
+ */
+void HAL_delayCycles(uint64_t cycles);
+
+/*
+ * Description :
+ * Clear & set the I-bit (avr/interrupt.h), sei delivers the pending interrupts.
+ */
+void HAL_cli(void);
+void HAL_sei(void);
+
+#endif /* HAL_HOST_H_ */
@@ -0,0 +1,18 @@
+ /******************************************************************************
+ * Module: HAL
+ * File Name: interrupt.h
+ * Description: Host replacement of <avr/interrupt.h>, an ISR is a plain function
+ *              called by the simulator when its interrupt is taken
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include "hal_host.h"
+
+#define ISR(VECTOR, ...)		void HAL_ISR_##VECTOR(void); void HAL_ISR_##VECTOR(void)
+
+#define cli()					HAL_cli()
+#define sei()					HAL_sei()
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
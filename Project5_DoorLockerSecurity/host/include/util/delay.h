@@ -0,0 +1,19 @@
+ /******************************************************************************
+ * Module: HAL
+ * File Name: delay.h
+ * Description: Host replacement of <util/delay.h>, the delays run the simulated time
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "hal_host.h"
+
+#ifndef F_CPU
+#error "F_CPU must be defined for the delay functions"
+#endif
+
+#define _delay_ms(MS)			HAL_delayCycles((uint64_t)((MS) * ((double)F_CPU / 1000.0)))
+#define _delay_us(US)			HAL_delayCycles((uint64_t)((US) * ((double)F_CPU / 1000000.0)))
+
+#endif /* HOST_UTIL_DELAY_H_ */
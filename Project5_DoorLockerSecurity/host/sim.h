@@ -0,0 +1,170 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim.h
+ * Description: Internal interface between the simulator core and the models of
+ *              the ATmega32 peripherals & the boards devices
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal_host.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_CPU_HZ						8000000ULL
+#define SIM_CYCLES_PER_MS				(SIM_CPU_HZ / 1000ULL)
+#define SIM_CYCLES_PER_US				(SIM_CPU_HZ / 1000000ULL)
+
+/* Returned by the next event function of a model that waits for nothing */
+#define SIM_NO_EVENT					UINT64_MAX
+
+/* Size of the I/O space, the registers use their data memory addresses 0x20 .. 0x5F */
+#define SIM_IO_SIZE						0x60
+
+/* Data memory addresses of the registers used by the models */
+#define SIM_TWBR						0x20
+#define SIM_TWSR						0x21
+#define SIM_TWDR						0x23
+#define SIM_UBRRL						0x29
+#define SIM_UCSRB						0x2A
+#define SIM_UCSRA						0x2B
+#define SIM_UDR							0x2C
+#define SIM_PIND						0x30
+#define SIM_DDRD						0x31
+#define SIM_PORTD						0x32
+#define SIM_PINC						0x33
+#define SIM_DDRC						0x34
+#define SIM_PORTC						0x35
+#define SIM_PINB						0x36
+#define SIM_DDRB						0x37
+#define SIM_PORTB						0x38
+#define SIM_PINA						0x39
+#define SIM_DDRA						0x3A
+#define SIM_PORTA						0x3B
+#define SIM_UCSRC_UBRRH					0x40
+#define SIM_OCR2						0x43
+#define SIM_TCNT2						0x44
+#define SIM_TCCR2						0x45
+#define SIM_OCR1B						0x48
+#define SIM_OCR1A						0x4A
+#define SIM_TCNT1						0x4C
+#define SIM_TCCR1B						0x4E
+#define SIM_TCCR1A						0x4F
+#define SIM_TCNT0						0x52
+#define SIM_TCCR0						0x53
+#define SIM_MCUCR						0x55
+#define SIM_TWCR						0x56
+#define SIM_TIFR						0x58
+#define SIM_TIMSK						0x59
+#define SIM_GIFR						0x5A
+#define SIM_GICR						0x5B
+#define SIM_OCR0						0x5C
+#define SIM_SREG						0x5F
+
+#define SIM_SREG_I						7
+
+/* PINx, DDRx & PORTx of a port, PORTA_ID = 0 .. PORTD_ID = 3 like gpio.h */
+#define SIM_PIN_ADDRESS(PORT)			(SIM_PINA - (3 * (PORT)))
+#define SIM_DDR_ADDRESS(PORT)			(SIM_DDRA - (3 * (PORT)))
+#define SIM_PORT_ADDRESS(PORT)			(SIM_PORTA - (3 * (PORT)))
+
+/* ATmega32 interrupt vector numbers, the lower number has the higher priority */
+#define SIM_INT0_VECTOR					1
+#define SIM_INT1_VECTOR					2
+#define SIM_INT2_VECTOR					3
+#define SIM_TIMER2_COMP_VECTOR			4
+#define SIM_TIMER2_OVF_VECTOR			5
+#define SIM_TIMER1_CAPT_VECTOR			6
+#define SIM_TIMER1_COMPA_VECTOR			7
+#define SIM_TIMER1_COMPB_VECTOR			8
+#define SIM_TIMER1_OVF_VECTOR			9
+#define SIM_TIMER0_COMP_VECTOR			10
+#define SIM_TIMER0_OVF_VECTOR			11
+#define SIM_USART_RXC_VECTOR			13
+#define SIM_USART_UDRE_VECTOR			14
+#define SIM_USART_TXC_VECTOR			15
+#define SIM_TWI_VECTOR					19
+#define SIM_NO_VECTOR					0
+
+#define SIM_VECTOR_MASK(VECTOR)			(1UL << (VECTOR))
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	const char *name;
+
+	/* Called once before the first register access */
+	void (*init)(void);
+
+	/* Called on each entry to the simulator, it sees the registers written by the firmware */
+	void (*observe)(void);
+
+	/*
+	 * Called before the firmware accesses the register at address, the model may update
+	 * the register in SIM_io. It returns 1 when it needs to know what the firmware did
+	 * with the value it puts in presented, the access is committed on the next entry.
+	 */
+	int (*access)(uint8_t address, uint8_t *presented);
+
+	/* The firmware finished the access claimed by the access function */
+	void (*commit)(uint8_t address, const uint8_t *presented, const uint8_t *accessed, uint8_t vector);
+
+	/* Absolute cycle of the next internal event */
+	uint64_t (*nextEvent)(void);
+
+	/* Run the model up to the current cycle */
+	void (*advance)(void);
+
+	/* Mask of the vectors with a pending interrupt (flag & enable bits set) */
+	uint32_t (*pending)(void);
+
+	/* The vector is taken, clear the flags cleared by the hardware */
+	void (*acknowledge)(uint8_t vector);
+
+	/* Called at the end of the simulation */
+	void (*exit)(void);
+}SIM_ModelType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Simulated I/O space */
+extern uint8_t SIM_io[SIM_IO_SIZE];
+
+/* Current simulated time in CPU cycles */
+extern uint64_t SIM_cycles;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/* Add a model, called by the constructors of the models */
+void SIM_register(const SIM_ModelType *model);
+
+/* Print a line prefixed by the ECU name and the simulated time */
+void SIM_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/* Read an environment option, default_value if it is not set */
+const char *SIM_option(const char *name, const char *default_value);
+uint64_t SIM_optionNumber(const char *name, uint64_t default_value);
+
+/* End the simulation, the models exit functions are called */
+void SIM_exit(int status) __attribute__((noreturn));
+
+/* Lose the next TWI operation like HAL_TWI_GLITCH_MS, used by the bench */
+void SIM_twiGlitch(void);
+
+/* avr-libc function missing from the host C library, used by lcd.c */
+char *itoa(int value, char *string, int radix);
+
+/* 16-bit registers helpers, low byte first */
+uint16_t SIM_read16(uint8_t address);
+void SIM_write16(uint8_t address, uint16_t value);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,303 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_control.c
+ * Description: Models of the Control ECU devices, the DC motor (direction pins &
+ *              Timer0 PWM duty), the buzzer and the door bolt with its limit switches
+ *              on INT0 & INT1, their changes are printed.
+ *              The wiring is taken from dc_motor.h, buzzer.h & limit_switch.h.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include "sim.h"
+#include "gpio.h"
+#include "dc_motor.h"
+#include "buzzer.h"
+#include "limit_switch.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_MOTOR_STOP					0
+#define SIM_MOTOR_CW					1
+#define SIM_MOTOR_ACW					2
+#define SIM_MOTOR_BRAKE					3
+
+/* TCCR0 bits */
+#define SIM_COM01						5
+#define SIM_CS0_MASK					0x07
+
+/* GICR & GIFR bits of INT0 & INT1, MCUCR sense control of INTn at bit 2n */
+#define SIM_INT0_BIT					6
+#define SIM_INT1_BIT					7
+#define SIM_ISC_MASK					0x03
+#define SIM_ISC_LOW_LEVEL				0
+#define SIM_ISC_ANY_CHANGE				1
+#define SIM_ISC_FALLING					2
+#define SIM_ISC_RISING					3
+
+/* Number of external interrupts with a limit switch, INT0 = unlocked & INT1 = locked */
+#define SIM_SWITCHES					2
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8_t g_motor = SIM_MOTOR_STOP;
+static uint8_t g_buzzer = 0;
+
+static const char * const g_motorNames[4] = {"STOP", "CW", "ACW", "BRAKE"};
+
+/*
+ * Door bolt: it moves by the PWM duty (percent) every cycle, the full travel is
+ * HAL_BOLT_TRAVEL_MS at 100%. Position 0 is locked, g_boltTravel is unlocked.
+ * A travel of 0 means the switches are not fitted, their pins stay pulled up.
+ */
+static uint64_t g_boltTravel = 0;
+static uint64_t g_boltPosition = 0;
+static uint64_t g_boltLast = 0;
+static uint8_t g_boltDuty = 0;
+
+/* Pins, GICR/GIFR bits & names of the switches, indexed by the INT number */
+static const uint8_t g_switchPins[SIM_SWITCHES] = {LIMIT_SWITCH_UNLOCKED_PIN_ID, LIMIT_SWITCH_LOCKED_PIN_ID};
+static const uint8_t g_switchBits[SIM_SWITCHES] = {SIM_INT0_BIT, SIM_INT1_BIT};
+static const char * const g_switchNames[SIM_SWITCHES] = {"UNLOCKED", "LOCKED"};
+static uint8_t g_switchLevels[SIM_SWITCHES] = {1, 1};
+static uint8_t g_switchPressed[SIM_SWITCHES] = {0, 0};
+
+/* Statistics */
+static uint64_t g_motorStarts = 0;
+static uint64_t g_buzzerStarts = 0;
+static uint64_t g_switchPresses = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Duty cycle in percent of the Timer0 PWM output (OC0).
+ */
+static uint8_t SIM_pwmDuty(void)
+{
+	if(!(SIM_io[SIM_TCCR0] & SIM_CS0_MASK) || !(SIM_io[SIM_TCCR0] & (1 << SIM_COM01)))
+	{
+		return 0;
+	}
+	return (uint8_t)(((SIM_io[SIM_OCR0] + 1) * 100 + 128) / 256);
+}
+
+/*
+ * Description :
+ * The switch is closed while the bolt is at its end position.
+ */
+static uint8_t SIM_switchPressed(uint8_t index)
+{
+	return (g_boltTravel != 0) && (g_boltPosition == ((index == 0) ? g_boltTravel : 0));
+}
+
+/*
+ * Description :
+ * Level of the switch pin: low while the switch is closed, otherwise high when the
+ * internal pull-up is on.
+ */
+static uint8_t SIM_switchLevel(uint8_t index)
+{
+	uint8_t pin = g_switchPins[index];
+
+	return !SIM_switchPressed(index) && ((SIM_io[SIM_PORT_ADDRESS(LIMIT_SWITCH_PORT_ID)] &
+			~SIM_io[SIM_DDR_ADDRESS(LIMIT_SWITCH_PORT_ID)] & (1 << pin)) != 0);
+}
+
+/*
+ * Description :
+ * Move the bolt up to the current cycle, update the switch pins and raise the
+ * INTn flags on the edges selected in MCUCR.
+ */
+static void SIM_boltAdvance(void)
+{
+	uint64_t distance = (SIM_cycles - g_boltLast) * g_boltDuty;
+	uint8_t level;
+	uint8_t sense;
+	uint8_t i;
+
+	g_boltLast = SIM_cycles;
+	if(g_motor == SIM_MOTOR_CW)
+	{
+		g_boltPosition = (distance < g_boltTravel - g_boltPosition) ? (g_boltPosition + distance) : g_boltTravel;
+	}
+	else if(g_motor == SIM_MOTOR_ACW)
+	{
+		g_boltPosition = (distance < g_boltPosition) ? (g_boltPosition - distance) : 0;
+	}
+
+	for(i = 0; i < SIM_SWITCHES; i++)
+	{
+		if(SIM_switchPressed(i) != g_switchPressed[i])
+		{
+			g_switchPressed[i] = SIM_switchPressed(i);
+			if(g_switchPressed[i])
+			{
+				g_switchPresses++;
+				SIM_log("LIMIT %s", g_switchNames[i]);
+			}
+		}
+
+		level = SIM_switchLevel(i);
+		if(level == g_switchLevels[i])
+		{
+			continue;
+		}
+
+		sense = (uint8_t)((SIM_io[SIM_MCUCR] >> (2 * i)) & SIM_ISC_MASK);
+		if((sense == SIM_ISC_ANY_CHANGE) || ((sense == SIM_ISC_FALLING) && !level) ||
+				((sense == SIM_ISC_RISING) && level))
+		{
+			SIM_io[SIM_GIFR] |= (uint8_t)(1 << g_switchBits[i]);
+		}
+		g_switchLevels[i] = level;
+		SIM_io[SIM_PIN_ADDRESS(LIMIT_SWITCH_PORT_ID)] = (uint8_t)((SIM_io[SIM_PIN_ADDRESS(LIMIT_SWITCH_PORT_ID)] &
+				~(1 << g_switchPins[i])) | (level << g_switchPins[i]));
+	}
+}
+
+static void SIM_controlInit(void)
+{
+	uint8_t i;
+
+	/* the bolt starts locked */
+	g_boltTravel = SIM_optionNumber("HAL_BOLT_TRAVEL_MS", 0) * SIM_CYCLES_PER_MS * 100;
+	for(i = 0; i < SIM_SWITCHES; i++)
+	{
+		g_switchPressed[i] = SIM_switchPressed(i);
+		SIM_io[SIM_PIN_ADDRESS(LIMIT_SWITCH_PORT_ID)] |= (uint8_t)(1 << g_switchPins[i]);
+	}
+}
+
+static void SIM_controlObserve(void)
+{
+	uint8_t pins = SIM_io[SIM_PORT_ADDRESS(DC_MOTOR_PORT_ID)] & SIM_io[SIM_DDR_ADDRESS(DC_MOTOR_PORT_ID)];
+	uint8_t motor = (uint8_t)(((pins >> DC_MOTOR_First_PIN_ID) & 1) | (((pins >> DC_MOTOR_Second_PIN_ID) & 1) << 1));
+	uint8_t buzzer = (SIM_io[SIM_PORT_ADDRESS(BUZZER_PORT_ID)] & SIM_io[SIM_DDR_ADDRESS(BUZZER_PORT_ID)] &
+			(1 << BUZZER_PIN_ID)) != 0;
+
+	/* the bolt moved with the old motor state up to now */
+	SIM_boltAdvance();
+	g_boltDuty = ((motor == SIM_MOTOR_CW) || (motor == SIM_MOTOR_ACW)) ? SIM_pwmDuty() : 0;
+
+	if(motor != g_motor)
+	{
+		g_motor = motor;
+		if((motor == SIM_MOTOR_CW) || (motor == SIM_MOTOR_ACW))
+		{
+			g_motorStarts++;
+			SIM_log("MOTOR %s %u%%", g_motorNames[motor], SIM_pwmDuty());
+		}
+		else
+		{
+			SIM_log("MOTOR %s", g_motorNames[motor]);
+		}
+	}
+
+	if(buzzer != g_buzzer)
+	{
+		g_buzzer = buzzer;
+		g_buzzerStarts += buzzer;
+		SIM_log("BUZZER %s", buzzer ? "ON" : "OFF");
+	}
+}
+
+static int SIM_controlAccess(uint8_t address, uint8_t *presented)
+{
+	(void)presented;
+
+	/* GIFR is write one to clear, the drivers only write it */
+	return (address == SIM_GIFR);
+}
+
+static void SIM_controlCommit(uint8_t address, const uint8_t *presented, const uint8_t *accessed, uint8_t vector)
+{
+	(void)address;
+	(void)presented;
+	(void)vector;
+	SIM_io[SIM_GIFR] &= (uint8_t)~accessed[0];
+}
+
+/*
+ * Description :
+ * Cycle when the moving bolt reaches its end position.
+ */
+static uint64_t SIM_controlNextEvent(void)
+{
+	uint64_t remaining;
+
+	if((g_boltTravel == 0) || (g_boltDuty == 0))
+	{
+		return SIM_NO_EVENT;
+	}
+	if(g_motor == SIM_MOTOR_CW)
+	{
+		remaining = g_boltTravel - g_boltPosition;
+	}
+	else if(g_motor == SIM_MOTOR_ACW)
+	{
+		remaining = g_boltPosition;
+	}
+	else
+	{
+		return SIM_NO_EVENT;
+	}
+	return (remaining == 0) ? SIM_NO_EVENT : (g_boltLast + (remaining + g_boltDuty - 1) / g_boltDuty);
+}
+
+static uint32_t SIM_controlPending(void)
+{
+	uint32_t pending = 0;
+	uint8_t i;
+
+	for(i = 0; i < SIM_SWITCHES; i++)
+	{
+		if(!(SIM_io[SIM_GICR] & (1 << g_switchBits[i])))
+		{
+			continue;
+		}
+		/* the low level interrupt has no flag, it stays pending while the pin is low */
+		if((SIM_io[SIM_GIFR] & (1 << g_switchBits[i])) ||
+				((((SIM_io[SIM_MCUCR] >> (2 * i)) & SIM_ISC_MASK) == SIM_ISC_LOW_LEVEL) && !g_switchLevels[i]))
+		{
+			pending |= SIM_VECTOR_MASK(SIM_INT0_VECTOR + i);
+		}
+	}
+	return pending;
+}
+
+static void SIM_controlAcknowledge(uint8_t vector)
+{
+	if((vector == SIM_INT0_VECTOR) || (vector == SIM_INT1_VECTOR))
+	{
+		SIM_io[SIM_GIFR] &= (uint8_t)~(1 << g_switchBits[vector - SIM_INT0_VECTOR]);
+	}
+}
+
+static void SIM_controlExit(void)
+{
+	SIM_log("motor started %llu times, buzzer started %llu times, limit switches pressed %llu times",
+			(unsigned long long)g_motorStarts, (unsigned long long)g_buzzerStarts,
+			(unsigned long long)g_switchPresses);
+}
+
+static const SIM_ModelType g_controlModel =
+{
+	"control",
+	SIM_controlInit,
+	SIM_controlObserve,
+	SIM_controlAccess,
+	SIM_controlCommit,
+	SIM_controlNextEvent,
+	SIM_boltAdvance,
+	SIM_controlPending,
+	SIM_controlAcknowledge,
+	SIM_controlExit
+};
+
+__attribute__((constructor)) static void SIM_controlRegister(void)
+{
+	SIM_register(&g_controlModel);
+}
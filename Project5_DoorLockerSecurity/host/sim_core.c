@@ -0,0 +1,458 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_core.c
+ * Description: Core of the host simulator, it owns the I/O space & the simulated
+ *              time, runs the models and calls the ISRs of the firmware
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_MAX_MODELS					8
+
+#ifndef SIM_ECU_NAME
+#define SIM_ECU_NAME					"ECU"
+#endif
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* A register access that the owner model will see once the firmware finished it */
+typedef struct
+{
+	const SIM_ModelType *owner;		/* NULL if no access is waiting */
+	uint8_t address;
+	uint8_t vector;					/* vector being served during the access */
+	uint8_t presented[2];
+	uint8_t value[2];				/* the location used by the firmware */
+}SIM_SlotType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+uint8_t SIM_io[SIM_IO_SIZE];
+uint64_t SIM_cycles = 0;
+
+static const SIM_ModelType *g_models[SIM_MAX_MODELS];
+static uint8_t g_modelsCount = 0;
+
+static int g_started = 0;
+static int g_exiting = 0;
+static const char *g_name = SIM_ECU_NAME;
+static uint64_t g_endCycle = SIM_NO_EVENT;
+
+static SIM_SlotType g_slot;
+
+/* Vector of the running ISR, SIM_NO_VECTOR in the main code */
+static uint8_t g_vector = SIM_NO_VECTOR;
+
+/* Statistics printed at the end */
+static uint64_t g_accesses = 0;
+static uint64_t g_interrupts = 0;
+
+/* ISRs of the firmware, weak so the vectors not used by an ECU stay NULL */
+#define SIM_ISR(VECTOR)					extern void HAL_ISR_##VECTOR(void) __attribute__((weak));
+SIM_ISR(INT0_vect)
+SIM_ISR(INT1_vect)
+SIM_ISR(INT2_vect)
+SIM_ISR(TIMER2_COMP_vect)
+SIM_ISR(TIMER2_OVF_vect)
+SIM_ISR(TIMER1_CAPT_vect)
+SIM_ISR(TIMER1_COMPA_vect)
+SIM_ISR(TIMER1_COMPB_vect)
+SIM_ISR(TIMER1_OVF_vect)
+SIM_ISR(TIMER0_COMP_vect)
+SIM_ISR(TIMER0_OVF_vect)
+SIM_ISR(SPI_STC_vect)
+SIM_ISR(USART_RXC_vect)
+SIM_ISR(USART_UDRE_vect)
+SIM_ISR(USART_TXC_vect)
+SIM_ISR(ADC_vect)
+SIM_ISR(EE_RDY_vect)
+SIM_ISR(ANA_COMP_vect)
+SIM_ISR(TWI_vect)
+SIM_ISR(SPM_RDY_vect)
+
+/* Indexed by the vector number, vector 0 is the reset */
+static void (* const g_isr[])(void) =
+{
+	NULL,
+	HAL_ISR_INT0_vect, HAL_ISR_INT1_vect, HAL_ISR_INT2_vect,
+	HAL_ISR_TIMER2_COMP_vect, HAL_ISR_TIMER2_OVF_vect,
+	HAL_ISR_TIMER1_CAPT_vect, HAL_ISR_TIMER1_COMPA_vect, HAL_ISR_TIMER1_COMPB_vect, HAL_ISR_TIMER1_OVF_vect,
+	HAL_ISR_TIMER0_COMP_vect, HAL_ISR_TIMER0_OVF_vect,
+	HAL_ISR_SPI_STC_vect,
+	HAL_ISR_USART_RXC_vect, HAL_ISR_USART_UDRE_vect, HAL_ISR_USART_TXC_vect,
+	HAL_ISR_ADC_vect, HAL_ISR_EE_RDY_vect, HAL_ISR_ANA_COMP_vect,
+	HAL_ISR_TWI_vect, HAL_ISR_SPM_RDY_vect
+};
+
+#define SIM_VECTORS_COUNT				(sizeof(g_isr) / sizeof(g_isr[0]))
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the models before the first register access.
+ */
+static void SIM_start(void);
+
+/*
+ * Description :
+ * Entry to the simulator from the firmware, commit the last claimed access and
+ * let the models see the registers written since the last entry.
+ */
+static void SIM_enter(void);
+
+/*
+ * Description :
+ * Absolute cycle of the earliest event of all the models.
+ */
+static uint64_t SIM_nextEvent(void);
+
+/*
+ * Description :
+ * Run the models & the interrupts for the given number of cycles.
+ */
+static void SIM_run(uint64_t cycles);
+
+/*
+ * Description :
+ * Call the ISRs of the pending interrupts while the I-bit is set.
+ */
+static void SIM_deliver(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void SIM_register(const SIM_ModelType *model)
+{
+	if(g_modelsCount == SIM_MAX_MODELS)
+	{
+		fprintf(stderr, "too many simulation models\n");
+		exit(EXIT_FAILURE);
+	}
+	g_models[g_modelsCount++] = model;
+}
+
+const char *SIM_option(const char *name, const char *default_value)
+{
+	const char *value = getenv(name);
+
+	return ((value != NULL) && (value[0] != '\0')) ? value : default_value;
+}
+
+uint64_t SIM_optionNumber(const char *name, uint64_t default_value)
+{
+	const char *value = SIM_option(name, NULL);
+
+	return (value != NULL) ? strtoull(value, NULL, 0) : default_value;
+}
+
+void SIM_log(const char *format, ...)
+{
+	va_list args;
+
+	printf("%s %11.3f ms  ", g_name, (double)SIM_cycles / (double)SIM_CYCLES_PER_MS);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	putchar('\n');
+}
+
+void SIM_exit(int status)
+{
+	uint8_t i;
+
+	if(!g_exiting)
+	{
+		g_exiting = 1;
+		for(i = 0; i < g_modelsCount; i++)
+		{
+			if(g_models[i]->exit != NULL)
+			{
+				g_models[i]->exit();
+			}
+		}
+		SIM_log("simulation ended, %llu register accesses, %llu interrupts",
+				(unsigned long long)g_accesses, (unsigned long long)g_interrupts);
+	}
+	fflush(stdout);
+	exit(status);
+}
+
+uint16_t SIM_read16(uint8_t address)
+{
+	return (uint16_t)(SIM_io[address] | (SIM_io[address + 1] << 8));
+}
+
+void SIM_write16(uint8_t address, uint16_t value)
+{
+	SIM_io[address] = (uint8_t)value;
+	SIM_io[address + 1] = (uint8_t)(value >> 8);
+}
+
+char *itoa(int value, char *string, int radix)
+{
+	char digits[sizeof(int) * 8 + 1];
+	unsigned int magnitude = (value < 0 && radix == 10) ? (0u - (unsigned int)value) : (unsigned int)value;
+	char *out = string;
+	int count = 0;
+
+	do
+	{
+		digits[count++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % (unsigned int)radix];
+		magnitude /= (unsigned int)radix;
+	}while(magnitude != 0);
+
+	if(value < 0 && radix == 10)
+	{
+		*out++ = '-';
+	}
+	while(count > 0)
+	{
+		*out++ = digits[--count];
+	}
+	*out = '\0';
+	return string;
+}
+
+static void SIM_start(void)
+{
+	uint64_t max_time_ms;
+	uint8_t i;
+
+	g_started = 1;
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	g_name = SIM_option("HAL_NAME", SIM_ECU_NAME);
+	max_time_ms = SIM_optionNumber("HAL_MAX_TIME_MS", 0);
+	if(max_time_ms != 0)
+	{
+		g_endCycle = max_time_ms * SIM_CYCLES_PER_MS;
+	}
+
+	for(i = 0; i < g_modelsCount; i++)
+	{
+		if(g_models[i]->init != NULL)
+		{
+			g_models[i]->init();
+		}
+	}
+}
+
+static void SIM_enter(void)
+{
+	const SIM_ModelType *owner = g_slot.owner;
+	uint8_t i;
+
+	if(!g_started)
+	{
+		SIM_start();
+	}
+
+	if(owner != NULL)
+	{
+		g_slot.owner = NULL;
+		owner->commit(g_slot.address, g_slot.presented, g_slot.value, g_slot.vector);
+	}
+
+	for(i = 0; i < g_modelsCount; i++)
+	{
+		if(g_models[i]->observe != NULL)
+		{
+			g_models[i]->observe();
+		}
+	}
+}
+
+static uint64_t SIM_nextEvent(void)
+{
+	uint64_t next = SIM_NO_EVENT;
+	uint64_t event;
+	uint8_t i;
+
+	for(i = 0; i < g_modelsCount; i++)
+	{
+		if(g_models[i]->nextEvent != NULL)
+		{
+			event = g_models[i]->nextEvent();
+			if(event < next)
+			{
+				next = event;
+			}
+		}
+	}
+	return next;
+}
+
+static void SIM_run(uint64_t cycles)
+{
+	uint64_t end = SIM_cycles + cycles;
+	uint64_t next;
+	uint8_t i;
+
+	SIM_deliver();
+
+	while(SIM_cycles < end)
+	{
+		/* jump to the next event of any model, the models do nothing in between */
+		next = SIM_nextEvent();
+		if(next > end)
+		{
+			next = end;
+		}
+		if(next <= SIM_cycles)
+		{
+			next = SIM_cycles + 1;
+		}
+		if(next >= g_endCycle)
+		{
+			SIM_cycles = g_endCycle;
+			SIM_exit(EXIT_SUCCESS);
+		}
+
+		SIM_cycles = next;
+		for(i = 0; i < g_modelsCount; i++)
+		{
+			if(g_models[i]->advance != NULL)
+			{
+				g_models[i]->advance();
+			}
+		}
+
+		SIM_deliver();
+	}
+}
+
+static void SIM_deliver(void)
+{
+	uint32_t pending;
+	uint8_t vector;
+	uint8_t saved_vector;
+	uint8_t i;
+
+	while(SIM_io[SIM_SREG] & (1 << SIM_SREG_I))
+	{
+		pending = 0;
+		for(i = 0; i < g_modelsCount; i++)
+		{
+			if(g_models[i]->pending != NULL)
+			{
+				pending |= g_models[i]->pending();
+			}
+		}
+		if(pending == 0)
+		{
+			return;
+		}
+
+		/* the lowest vector number has the highest priority */
+		vector = (uint8_t)__builtin_ctz(pending);
+		for(i = 0; i < g_modelsCount; i++)
+		{
+			if(g_models[i]->acknowledge != NULL)
+			{
+				g_models[i]->acknowledge(vector);
+			}
+		}
+
+		if((vector >= SIM_VECTORS_COUNT) || (g_isr[vector] == NULL))
+		{
+			/* the AVR jumps to the bad interrupt vector and resets */
+			SIM_log("interrupt %u is enabled without an ISR", vector);
+			SIM_exit(EXIT_FAILURE);
+		}
+
+		g_interrupts++;
+		saved_vector = g_vector;
+		g_vector = vector;
+		SIM_io[SIM_SREG] &= (uint8_t)~(1 << SIM_SREG_I);
+
+		g_isr[vector]();
+
+		/* RETI */
+		SIM_enter();
+		SIM_io[SIM_SREG] |= (1 << SIM_SREG_I);
+		g_vector = saved_vector;
+	}
+}
+
+volatile void *HAL_ioAccess(uint16_t address)
+{
+	uint8_t i;
+
+	SIM_enter();
+	SIM_run(HAL_ACCESS_CYCLES);
+	g_accesses++;
+
+	if(address >= SIM_IO_SIZE)
+	{
+		SIM_log("access to 0x%X outside the I/O space", address);
+		SIM_exit(EXIT_FAILURE);
+	}
+
+	g_slot.presented[0] = SIM_io[address];
+	g_slot.presented[1] = (address + 1 < SIM_IO_SIZE) ? SIM_io[address + 1] : 0;
+	for(i = 0; i < g_modelsCount; i++)
+	{
+		if((g_models[i]->access != NULL) && g_models[i]->access((uint8_t)address, g_slot.presented))
+		{
+			g_slot.owner = g_models[i];
+			g_slot.address = (uint8_t)address;
+			g_slot.vector = g_vector;
+			g_slot.value[0] = g_slot.presented[0];
+			g_slot.value[1] = g_slot.presented[1];
+			return g_slot.value;
+		}
+	}
+	return &SIM_io[address];
+}
+
+void HAL_busyWait(void)
+{
+	uint64_t next;
+
+	SIM_enter();
+
+	/* the loop polls RAM only, nothing changes before the next event & its interrupt */
+	next = SIM_nextEvent();
+	if((next == SIM_NO_EVENT) && (g_endCycle == SIM_NO_EVENT))
+	{
+		SIM_log("waiting for an event that never comes");
+		SIM_exit(EXIT_FAILURE);
+	}
+	if(next > g_endCycle)
+	{
+		next = g_endCycle;
+	}
+	SIM_run((next > SIM_cycles + HAL_BUSY_WAIT_CYCLES) ? (next - SIM_cycles) : HAL_BUSY_WAIT_CYCLES);
+}
+
+void HAL_delayCycles(uint64_t cycles)
+{
+	SIM_enter();
+	SIM_run(cycles);
+}
+
+void HAL_cli(void)
+{
+	SIM_enter();
+	SIM_run(1);
+	SIM_io[SIM_SREG] &= (uint8_t)~(1 << SIM_SREG_I);
+}
+
+void HAL_sei(void)
+{
+	SIM_enter();
+	SIM_io[SIM_SREG] |= (1 << SIM_SREG_I);
+	SIM_run(1);
+}
@@ -0,0 +1,405 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_hmi.c
+ * Description: Models of the HMI ECU devices: the 4x4 keypad played from a script
+ *              (HAL_KEYPAD) and the HD44780 LCD printed when its text settles.
+ *              The wiring is taken from keypad.h & lcd.h.
+ *
+ * Keypad script: the keys 0-9 % * - = + and E (Enter), "@<ms>" waits without
+ * pressing, "H<ms>" sets how long the next keys are held, "Q" ends the simulation.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "gpio.h"
+#include "keypad.h"
+#include "lcd.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* Keys of the 4x4 keypad in (row * 4) + column order, like g_keyMap in kepad.c */
+#define SIM_KEYPAD_LAYOUT				"789%456*123-E0=+"
+
+#define SIM_KEY_RELEASED				(-1)
+
+/* The LCD text is printed when it is not changed for this time */
+#define SIM_LCD_SETTLE_MS				20
+
+/* Execution times from the HD44780 data sheet */
+#define SIM_LCD_EXECUTION_US			37
+#define SIM_LCD_CLEAR_EXECUTION_US		1520
+
+#define SIM_LCD_DDRAM_SIZE				0x80
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Keypad */
+static const char *g_script = "";
+static int g_pressedKey = SIM_KEY_RELEASED;
+static uint64_t g_keyChange = SIM_NO_EVENT;
+static uint64_t g_holdCycles;
+static uint64_t g_gapCycles;
+static uint64_t g_keysPressed = 0;
+
+/* LCD */
+static uint8_t g_lastEnable = 0;
+#if (LCD_DATA_BITS_MODE == 4)
+static uint8_t g_eightBitInterface = 1;
+static uint8_t g_highNibble;
+static uint8_t g_highNibbleValid = 0;
+#endif
+static uint8_t g_ddram[SIM_LCD_DDRAM_SIZE];
+static uint8_t g_addressCounter = 0;
+static uint8_t g_displayOn = 0;
+static uint64_t g_readyAt = 0;
+static uint64_t g_lastWrite = 0;
+static uint8_t g_changed = 0;
+static char g_printed[LCD_ROWS][LCD_COLUMNS + 1];
+static uint64_t g_busyWrites = 0;
+
+static const uint8_t g_rowAddress[4] =
+{
+	LCD_ROW0_ADDRESS, LCD_ROW1_ADDRESS, LCD_ROW2_ADDRESS, LCD_ROW3_ADDRESS
+};
+
+/*******************************************************************************
+ *                      Functions Definitions (Keypad)                         *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Run the script from the current position until the next key change.
+ */
+static void SIM_keypadNextStep(void)
+{
+	const char *key;
+	char *end;
+	uint64_t value;
+
+	while(*g_script != '\0')
+	{
+		if(isspace((unsigned char)*g_script))
+		{
+			g_script++;
+		}
+		else if((*g_script == '@') || (*g_script == 'H'))
+		{
+			value = strtoull(g_script + 1, &end, 10) * SIM_CYCLES_PER_MS;
+			if(*g_script == '@')
+			{
+				g_script = end;
+				g_keyChange = SIM_cycles + value;
+				return;
+			}
+			g_holdCycles = value;
+			g_script = end;
+		}
+		else if(*g_script == 'Q')
+		{
+			SIM_log("keypad script finished");
+			SIM_exit(EXIT_SUCCESS);
+		}
+		else
+		{
+			key = strchr(SIM_KEYPAD_LAYOUT, *g_script);
+			if(key == NULL)
+			{
+				SIM_log("unknown key '%c' in the keypad script", *g_script);
+				SIM_exit(EXIT_FAILURE);
+			}
+			g_script++;
+			g_pressedKey = (int)(key - SIM_KEYPAD_LAYOUT);
+			g_keyChange = SIM_cycles + g_holdCycles;
+			g_keysPressed++;
+			SIM_log("KEY %c", *key);
+			return;
+		}
+	}
+	g_keyChange = SIM_NO_EVENT;
+}
+
+/*
+ * Description :
+ * Levels forced on the port pins by the pressed key, 0xFF when nothing is pressed.
+ */
+static uint8_t SIM_keypadLevels(uint8_t port)
+{
+	uint8_t row_pin;
+	uint8_t col_pin;
+	uint8_t levels = 0xFF;
+	uint8_t row_driven_low;
+	uint8_t col_driven_low;
+
+	if(g_pressedKey == SIM_KEY_RELEASED)
+	{
+		return levels;
+	}
+
+	row_pin = (uint8_t)(KEYPAD_FIRST_ROW_PIN_ID + (g_pressedKey / 4));
+	col_pin = (uint8_t)(KEYPAD_FIRST_COL_PIN_ID + (g_pressedKey % 4));
+	row_driven_low = (SIM_io[SIM_DDR_ADDRESS(KEYPAD_ROW_PORT_ID)] & (1 << row_pin)) &&
+			!(SIM_io[SIM_PORT_ADDRESS(KEYPAD_ROW_PORT_ID)] & (1 << row_pin));
+	col_driven_low = (SIM_io[SIM_DDR_ADDRESS(KEYPAD_COL_PORT_ID)] & (1 << col_pin)) &&
+			!(SIM_io[SIM_PORT_ADDRESS(KEYPAD_COL_PORT_ID)] & (1 << col_pin));
+
+	/* the switch connects the row to the column */
+	if((port == KEYPAD_COL_PORT_ID) && row_driven_low)
+	{
+		levels &= (uint8_t)~(1 << col_pin);
+	}
+	if((port == KEYPAD_ROW_PORT_ID) && col_driven_low)
+	{
+		levels &= (uint8_t)~(1 << row_pin);
+	}
+	return levels;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions (LCD)                            *
+ *******************************************************************************/
+
+static void SIM_lcdPrint(void)
+{
+	char row[LCD_COLUMNS + 1];
+	uint8_t r;
+	uint8_t c;
+	uint8_t changed = 0;
+
+	for(r = 0; r < LCD_ROWS; r++)
+	{
+		for(c = 0; c < LCD_COLUMNS; c++)
+		{
+			row[c] = g_displayOn ? (char)g_ddram[(g_rowAddress[r] + c) & (SIM_LCD_DDRAM_SIZE - 1)] : ' ';
+			if(!isprint((unsigned char)row[c]))
+			{
+				row[c] = '?';
+			}
+		}
+		row[LCD_COLUMNS] = '\0';
+		if(strcmp(row, g_printed[r]) != 0)
+		{
+			strcpy(g_printed[r], row);
+			changed = 1;
+		}
+	}
+
+	if(changed)
+	{
+		for(r = 0; r < LCD_ROWS; r++)
+		{
+			SIM_log("LCD |%s|", g_printed[r]);
+		}
+	}
+	g_changed = 0;
+}
+
+static void SIM_lcdExecute(uint8_t rs, uint8_t data)
+{
+	uint64_t execution = SIM_LCD_EXECUTION_US;
+
+	if(SIM_cycles < g_readyAt)
+	{
+		/* a real HD44780 may lose what is sent while it is busy */
+		if(g_busyWrites++ == 0)
+		{
+			SIM_log("LCD written while busy (rs %u, data 0x%02X)", rs, data);
+		}
+	}
+
+	if(rs)
+	{
+		g_ddram[g_addressCounter] = data;
+		g_addressCounter = (g_addressCounter + 1) & (SIM_LCD_DDRAM_SIZE - 1);
+	}
+	else if(data & 0x80)
+	{
+		g_addressCounter = data & (SIM_LCD_DDRAM_SIZE - 1);
+	}
+	else if(data & 0x40)
+	{
+		/* CGRAM address, custom characters are not modeled */
+	}
+	else if(data & 0x20)
+	{
+#if (LCD_DATA_BITS_MODE == 4)
+		g_eightBitInterface = (data & 0x10) != 0;
+#endif
+	}
+	else if(data & 0x08)
+	{
+		g_displayOn = (data & 0x04) != 0;
+	}
+	else if(data & 0x02)
+	{
+		g_addressCounter = 0;
+		execution = SIM_LCD_CLEAR_EXECUTION_US;
+	}
+	else if(data == 0x01)
+	{
+		memset(g_ddram, ' ', sizeof(g_ddram));
+		g_addressCounter = 0;
+		execution = SIM_LCD_CLEAR_EXECUTION_US;
+	}
+
+	g_readyAt = SIM_cycles + execution * SIM_CYCLES_PER_US;
+	g_lastWrite = SIM_cycles;
+	g_changed = 1;
+}
+
+/*
+ * Description :
+ * The LCD latches RS & the data pins on the falling edge of E.
+ */
+static void SIM_lcdLatch(void)
+{
+	uint8_t rs = (SIM_io[SIM_PORT_ADDRESS(LCD_RS_PORT_ID)] >> LCD_RS_PIN_ID) & 1;
+	uint8_t port = SIM_io[SIM_PORT_ADDRESS(LCD_DATA_PORT_ID)];
+
+#if (LCD_DATA_BITS_MODE == 4)
+	uint8_t nibble = (uint8_t)((((port >> LCD_DB4_PIN_ID) & 1) << 0) | (((port >> LCD_DB5_PIN_ID) & 1) << 1) |
+			(((port >> LCD_DB6_PIN_ID) & 1) << 2) | (((port >> LCD_DB7_PIN_ID) & 1) << 3));
+
+	if(g_eightBitInterface)
+	{
+		/* still in the 8-bit interface after the reset, DB0..DB3 are not wired */
+		SIM_lcdExecute(rs, (uint8_t)(nibble << 4));
+	}
+	else if(!g_highNibbleValid)
+	{
+		g_highNibble = nibble;
+		g_highNibbleValid = 1;
+	}
+	else
+	{
+		g_highNibbleValid = 0;
+		SIM_lcdExecute(rs, (uint8_t)((g_highNibble << 4) | nibble));
+	}
+#else
+	SIM_lcdExecute(rs, port);
+#endif
+}
+
+/*******************************************************************************
+ *                      Functions Definitions (Model)                          *
+ *******************************************************************************/
+
+static void SIM_hmiInit(void)
+{
+	uint8_t r;
+
+	g_holdCycles = SIM_optionNumber("HAL_KEY_HOLD_MS", 60) * SIM_CYCLES_PER_MS;
+	g_gapCycles = SIM_optionNumber("HAL_KEY_GAP_MS", 60) * SIM_CYCLES_PER_MS;
+	g_script = SIM_option("HAL_KEYPAD", "");
+	g_keyChange = SIM_optionNumber("HAL_KEYPAD_START_MS", 100) * SIM_CYCLES_PER_MS;
+
+	memset(g_ddram, ' ', sizeof(g_ddram));
+	for(r = 0; r < LCD_ROWS; r++)
+	{
+		memset(g_printed[r], ' ', LCD_COLUMNS);
+		g_printed[r][LCD_COLUMNS] = '\0';
+	}
+}
+
+static void SIM_hmiObserve(void)
+{
+	uint8_t enable = (SIM_io[SIM_PORT_ADDRESS(LCD_E_PORT_ID)] >> LCD_E_PIN_ID) & 1;
+
+	if(g_lastEnable && !enable)
+	{
+		SIM_lcdLatch();
+	}
+	g_lastEnable = enable;
+}
+
+static int SIM_hmiAccess(uint8_t address, uint8_t *presented)
+{
+	uint8_t port;
+	uint8_t levels;
+
+	for(port = 0; port < NUM_OF_PORTS; port++)
+	{
+		if(address == SIM_PIN_ADDRESS(port))
+		{
+			/* the outputs read their own level, the inputs are pulled up unless forced */
+			levels = SIM_keypadLevels(port);
+#ifdef LCD_BUSY_FLAG_MODE
+			if((port == LCD_DATA_PORT_ID) && (SIM_io[SIM_PORT_ADDRESS(LCD_RW_PORT_ID)] & (1 << LCD_RW_PIN_ID)) &&
+					(SIM_io[SIM_PORT_ADDRESS(LCD_E_PORT_ID)] & (1 << LCD_E_PIN_ID)))
+			{
+				/* the LCD drives the busy flag & the address counter */
+				levels = (uint8_t)(((SIM_cycles < g_readyAt) ? 0x80 : 0x00) | g_addressCounter);
+			}
+#endif
+			SIM_io[address] = (uint8_t)((SIM_io[SIM_PORT_ADDRESS(port)] & SIM_io[SIM_DDR_ADDRESS(port)]) |
+					(levels & ~SIM_io[SIM_DDR_ADDRESS(port)]));
+			presented[0] = SIM_io[address];
+			break;
+		}
+	}
+	return 0;
+}
+
+static uint64_t SIM_hmiNextEvent(void)
+{
+	uint64_t next = g_keyChange;
+
+	if(g_changed && (g_lastWrite + SIM_LCD_SETTLE_MS * SIM_CYCLES_PER_MS < next))
+	{
+		next = g_lastWrite + SIM_LCD_SETTLE_MS * SIM_CYCLES_PER_MS;
+	}
+	return next;
+}
+
+static void SIM_hmiAdvance(void)
+{
+	if(g_keyChange <= SIM_cycles)
+	{
+		if(g_pressedKey != SIM_KEY_RELEASED)
+		{
+			g_pressedKey = SIM_KEY_RELEASED;
+			g_keyChange = SIM_cycles + g_gapCycles;
+		}
+		else
+		{
+			SIM_keypadNextStep();
+		}
+	}
+
+	if(g_changed && (SIM_cycles >= g_lastWrite + SIM_LCD_SETTLE_MS * SIM_CYCLES_PER_MS))
+	{
+		SIM_lcdPrint();
+	}
+}
+
+static void SIM_hmiExit(void)
+{
+	if(g_changed)
+	{
+		SIM_lcdPrint();
+	}
+	SIM_log("keypad %llu keys pressed, LCD %llu writes while busy",
+			(unsigned long long)g_keysPressed, (unsigned long long)g_busyWrites);
+}
+
+static const SIM_ModelType g_hmiModel =
+{
+	"hmi",
+	SIM_hmiInit,
+	SIM_hmiObserve,
+	SIM_hmiAccess,
+	NULL,
+	SIM_hmiNextEvent,
+	SIM_hmiAdvance,
+	NULL,
+	NULL,
+	SIM_hmiExit
+};
+
+__attribute__((constructor)) static void SIM_hmiRegister(void)
+{
+	SIM_register(&g_hmiModel);
+}
@@ -0,0 +1,57 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_link.h
+ * Description: Messages carried between the UART models of the two ECUs & the
+ *              door_sim link in between them
+ *
+ * Message: | TYPE | DATA | SENDER TIME (8 bytes) | ARRIVAL TIME (8 bytes) |
+ * The times are CPU cycles, low byte first. A DATA message is a byte on the wire,
+ * it reaches the other UART at its arrival time. A TIME message only tells the
+ * sender time so the other ECU may run further.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#ifndef SIM_LINK_H_
+#define SIM_LINK_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_LINK_MESSAGE_SIZE			18
+#define SIM_LINK_DATA					'D'
+#define SIM_LINK_TIME					'T'
+
+/* Offsets of the fields in a message */
+#define SIM_LINK_TYPE_OFFSET			0
+#define SIM_LINK_DATA_OFFSET			1
+#define SIM_LINK_SENDER_TIME_OFFSET		2
+#define SIM_LINK_ARRIVAL_OFFSET			10
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static inline void SIM_linkPut64(uint8_t *buffer, uint64_t value)
+{
+	uint8_t i;
+
+	for(i = 0; i < 8; i++)
+	{
+		buffer[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+static inline uint64_t SIM_linkGet64(const uint8_t *buffer)
+{
+	uint64_t value = 0;
+	uint8_t i;
+
+	for(i = 0; i < 8; i++)
+	{
+		value |= (uint64_t)buffer[i] << (8 * i);
+	}
+	return value;
+}
+
+#endif /* SIM_LINK_H_ */
@@ -0,0 +1,337 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_timers.c
+ * Description: Model of the ATmega32 Timer1 & Timer2 in the normal & CTC modes,
+ *              Timer0 is only used for the PWM and is read by the motor model
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_TIMERS_COUNT				2
+
+/* TIFR & TIMSK bits */
+#define SIM_TIMER2_COMPARE_FLAG			7
+#define SIM_TIMER2_OVERFLOW_FLAG		6
+#define SIM_TIMER1_COMPARE_A_FLAG		4
+#define SIM_TIMER1_COMPARE_B_FLAG		3
+#define SIM_TIMER1_OVERFLOW_FLAG		2
+
+#define SIM_NO_COMPARE					UINT32_MAX
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint32_t prescaler;					/* 0 when the timer is stopped */
+	uint32_t top;						/* the counter goes back to zero after top */
+	int overflow;						/* TOV is set when the counter passes top */
+	uint32_t compare[2];				/* SIM_NO_COMPARE if not used */
+}SIM_TimerSetupType;
+
+typedef struct
+{
+	const char *name;
+	uint8_t counter_address;
+	uint32_t max;						/* 0xFF or 0xFFFF */
+	void (*setup)(SIM_TimerSetupType *setup);
+	uint8_t compare_flag[2];
+	uint8_t overflow_flag;
+	uint64_t last;						/* cycle already counted */
+	uint32_t remainder;					/* cycles counted by the prescaler */
+}SIM_TimerType;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+static void SIM_timer1Setup(SIM_TimerSetupType *setup);
+static void SIM_timer2Setup(SIM_TimerSetupType *setup);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static const uint32_t g_timer1Prescalers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+static const uint32_t g_timer2Prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+static SIM_TimerType g_timers[SIM_TIMERS_COUNT] =
+{
+	{"Timer1", SIM_TCNT1, 0xFFFF, SIM_timer1Setup,
+	 {SIM_TIMER1_COMPARE_A_FLAG, SIM_TIMER1_COMPARE_B_FLAG}, SIM_TIMER1_OVERFLOW_FLAG, 0, 0},
+	{"Timer2", SIM_TCNT2, 0xFF, SIM_timer2Setup,
+	 {SIM_TIMER2_COMPARE_FLAG, SIM_TIMER2_COMPARE_FLAG}, SIM_TIMER2_OVERFLOW_FLAG, 0, 0}
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static void SIM_timer1Setup(SIM_TimerSetupType *setup)
+{
+	uint8_t wgm = (uint8_t)(((SIM_io[SIM_TCCR1B] >> 1) & 0x0C) | (SIM_io[SIM_TCCR1A] & 0x03));
+
+	setup->prescaler = g_timer1Prescalers[SIM_io[SIM_TCCR1B] & 0x07];
+	setup->compare[0] = SIM_read16(SIM_OCR1A);
+	setup->compare[1] = SIM_read16(SIM_OCR1B);
+	if(wgm == 4)
+	{
+		/* CTC, OCR1A is the top */
+		setup->top = setup->compare[0];
+		setup->overflow = 0;
+	}
+	else
+	{
+		/* the PWM modes are counted like the normal mode */
+		setup->top = 0xFFFF;
+		setup->overflow = 1;
+	}
+}
+
+static void SIM_timer2Setup(SIM_TimerSetupType *setup)
+{
+	uint8_t tccr2 = SIM_io[SIM_TCCR2];
+
+	setup->prescaler = g_timer2Prescalers[tccr2 & 0x07];
+	setup->compare[0] = SIM_io[SIM_OCR2];
+	setup->compare[1] = SIM_NO_COMPARE;
+	if((tccr2 & 0x48) == 0x08)
+	{
+		/* CTC, OCR2 is the top */
+		setup->top = setup->compare[0];
+		setup->overflow = 0;
+	}
+	else
+	{
+		setup->top = 0xFF;
+		setup->overflow = 1;
+	}
+}
+
+static uint32_t SIM_timerCounter(const SIM_TimerType *timer)
+{
+	return (timer->max == 0xFF) ? SIM_io[timer->counter_address] : SIM_read16(timer->counter_address);
+}
+
+static void SIM_timerSetCounter(const SIM_TimerType *timer, uint32_t value)
+{
+	if(timer->max == 0xFF)
+	{
+		SIM_io[timer->counter_address] = (uint8_t)value;
+	}
+	else
+	{
+		SIM_write16(timer->counter_address, (uint16_t)value);
+	}
+}
+
+/*
+ * Description :
+ * Timer ticks until the next flag is set, counted from counter.
+ */
+static uint32_t SIM_timerTicksToEvent(const SIM_TimerSetupType *setup, uint32_t counter, uint32_t max)
+{
+	/* ticks until the counter goes back to zero, a counter written above top runs to max */
+	uint32_t ticks = ((counter <= setup->top) ? setup->top : max) - counter + 1;
+	uint8_t i;
+
+	for(i = 0; i < 2; i++)
+	{
+		if((setup->compare[i] != SIM_NO_COMPARE) && (setup->compare[i] > counter) &&
+				(setup->compare[i] - counter < ticks))
+		{
+			ticks = setup->compare[i] - counter;
+		}
+	}
+	return ticks;
+}
+
+static void SIM_timerAdvance(SIM_TimerType *timer)
+{
+	SIM_TimerSetupType setup;
+	uint64_t elapsed = SIM_cycles - timer->last;
+	uint64_t total;
+	uint64_t ticks;
+	uint32_t counter;
+	uint32_t limit;
+	uint32_t step;
+	uint8_t i;
+
+	timer->last = SIM_cycles;
+	timer->setup(&setup);
+	if(setup.prescaler == 0)
+	{
+		timer->remainder = 0;
+		return;
+	}
+
+	total = timer->remainder + elapsed;
+	ticks = total / setup.prescaler;
+	timer->remainder = (uint32_t)(total % setup.prescaler);
+	counter = SIM_timerCounter(timer);
+
+	while(ticks != 0)
+	{
+		limit = (counter <= setup.top) ? setup.top : timer->max;
+		step = SIM_timerTicksToEvent(&setup, counter, timer->max);
+		if(ticks < step)
+		{
+			counter += (uint32_t)ticks;
+			break;
+		}
+		ticks -= step;
+		counter += step;
+
+		if(counter > limit)
+		{
+			/* back to zero after top (CTC) or after max (normal or written above top) */
+			if(setup.overflow || (limit == timer->max))
+			{
+				SIM_io[SIM_TIFR] |= (uint8_t)(1 << timer->overflow_flag);
+			}
+			counter = 0;
+		}
+		else
+		{
+			for(i = 0; i < 2; i++)
+			{
+				if(counter == setup.compare[i])
+				{
+					SIM_io[SIM_TIFR] |= (uint8_t)(1 << timer->compare_flag[i]);
+				}
+			}
+		}
+	}
+	SIM_timerSetCounter(timer, counter);
+}
+
+static uint64_t SIM_timerNextEvent(const SIM_TimerType *timer)
+{
+	SIM_TimerSetupType setup;
+	uint64_t ticks;
+
+	timer->setup(&setup);
+	if(setup.prescaler == 0)
+	{
+		return SIM_NO_EVENT;
+	}
+	ticks = SIM_timerTicksToEvent(&setup, SIM_timerCounter(timer), timer->max);
+	return timer->last + (ticks * setup.prescaler) - timer->remainder;
+}
+
+static void SIM_timersInit(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < SIM_TIMERS_COUNT; i++)
+	{
+		g_timers[i].last = SIM_cycles;
+		g_timers[i].remainder = 0;
+	}
+}
+
+static int SIM_timersAccess(uint8_t address, uint8_t *presented)
+{
+	(void)presented;
+
+	/* TIFR is write one to clear, the drivers only write it */
+	return (address == SIM_TIFR);
+}
+
+static void SIM_timersCommit(uint8_t address, const uint8_t *presented, const uint8_t *accessed, uint8_t vector)
+{
+	(void)address;
+	(void)presented;
+	(void)vector;
+	SIM_io[SIM_TIFR] &= (uint8_t)~accessed[0];
+}
+
+static uint64_t SIM_timersNextEvent(void)
+{
+	uint64_t next = SIM_NO_EVENT;
+	uint64_t event;
+	uint8_t i;
+
+	for(i = 0; i < SIM_TIMERS_COUNT; i++)
+	{
+		event = SIM_timerNextEvent(&g_timers[i]);
+		if(event < next)
+		{
+			next = event;
+		}
+	}
+	return next;
+}
+
+static void SIM_timersAdvance(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < SIM_TIMERS_COUNT; i++)
+	{
+		SIM_timerAdvance(&g_timers[i]);
+	}
+}
+
+static uint32_t SIM_timersPending(void)
+{
+	uint8_t flags = SIM_io[SIM_TIFR] & SIM_io[SIM_TIMSK];
+	uint32_t pending = 0;
+
+	if(flags & (1 << SIM_TIMER2_COMPARE_FLAG))
+		pending |= SIM_VECTOR_MASK(SIM_TIMER2_COMP_VECTOR);
+	if(flags & (1 << SIM_TIMER2_OVERFLOW_FLAG))
+		pending |= SIM_VECTOR_MASK(SIM_TIMER2_OVF_VECTOR);
+	if(flags & (1 << SIM_TIMER1_COMPARE_A_FLAG))
+		pending |= SIM_VECTOR_MASK(SIM_TIMER1_COMPA_VECTOR);
+	if(flags & (1 << SIM_TIMER1_COMPARE_B_FLAG))
+		pending |= SIM_VECTOR_MASK(SIM_TIMER1_COMPB_VECTOR);
+	if(flags & (1 << SIM_TIMER1_OVERFLOW_FLAG))
+		pending |= SIM_VECTOR_MASK(SIM_TIMER1_OVF_VECTOR);
+	return pending;
+}
+
+static void SIM_timersAcknowledge(uint8_t vector)
+{
+	/* the flag of a taken vector is cleared by the hardware */
+	switch(vector)
+	{
+	case SIM_TIMER2_COMP_VECTOR:
+		SIM_io[SIM_TIFR] &= (uint8_t)~(1 << SIM_TIMER2_COMPARE_FLAG);
+		break;
+	case SIM_TIMER2_OVF_VECTOR:
+		SIM_io[SIM_TIFR] &= (uint8_t)~(1 << SIM_TIMER2_OVERFLOW_FLAG);
+		break;
+	case SIM_TIMER1_COMPA_VECTOR:
+		SIM_io[SIM_TIFR] &= (uint8_t)~(1 << SIM_TIMER1_COMPARE_A_FLAG);
+		break;
+	case SIM_TIMER1_COMPB_VECTOR:
+		SIM_io[SIM_TIFR] &= (uint8_t)~(1 << SIM_TIMER1_COMPARE_B_FLAG);
+		break;
+	case SIM_TIMER1_OVF_VECTOR:
+		SIM_io[SIM_TIFR] &= (uint8_t)~(1 << SIM_TIMER1_OVERFLOW_FLAG);
+		break;
+	default:
+		break;
+	}
+}
+
+static const SIM_ModelType g_timersModel =
+{
+	"timers",
+	SIM_timersInit,
+	NULL,
+	SIM_timersAccess,
+	SIM_timersCommit,
+	SIM_timersNextEvent,
+	SIM_timersAdvance,
+	SIM_timersPending,
+	SIM_timersAcknowledge,
+	NULL
+};
+
+__attribute__((constructor)) static void SIM_timersRegister(void)
+{
+	SIM_register(&g_timersModel);
+}
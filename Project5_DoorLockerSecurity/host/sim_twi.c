@@ -0,0 +1,382 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_twi.c
+ * Description: Model of the ATmega32 TWI in the master mode with a 24C16 EEPROM
+ *              (2 KB, 16 bytes pages, 3 block bits in the device address) on the bus
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* TWCR bits */
+#define SIM_TWINT						7
+#define SIM_TWEA						6
+#define SIM_TWSTA						5
+#define SIM_TWSTO						4
+#define SIM_TWWC						3
+#define SIM_TWEN						2
+#define SIM_TWIE						0
+
+/* Control bits kept by the model, TWINT is the model flag */
+#define SIM_TWCR_CONTROL_BITS			((1 << SIM_TWEA) | (1 << SIM_TWSTA) | (1 << SIM_TWEN) | (1 << SIM_TWIE))
+
+/* Status codes */
+#define SIM_TWI_START					0x08
+#define SIM_TWI_REP_START				0x10
+#define SIM_TWI_MT_SLA_W_ACK			0x18
+#define SIM_TWI_MT_SLA_W_NACK			0x20
+#define SIM_TWI_MT_DATA_ACK				0x28
+#define SIM_TWI_MR_SLA_R_ACK			0x40
+#define SIM_TWI_MR_SLA_R_NACK			0x48
+#define SIM_TWI_MR_DATA_ACK				0x50
+#define SIM_TWI_MR_DATA_NACK			0x58
+
+/* 24C16 */
+#define SIM_EEPROM_SIZE					2048
+#define SIM_EEPROM_PAGE_SIZE			16
+#define SIM_EEPROM_DEVICE_TYPE			0xA0
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	SIM_BUS_IDLE,
+	SIM_BUS_STARTED,		/* start sent, waiting for the device address */
+	SIM_BUS_TRANSMIT,		/* device addressed for writing */
+	SIM_BUS_RECEIVE,		/* device addressed for reading */
+	SIM_BUS_NOT_ACKED		/* no device answered, waiting for the stop */
+}SIM_BusStateType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8_t g_control = 0;
+static uint8_t g_interruptFlag = 0;
+static SIM_BusStateType g_busState = SIM_BUS_IDLE;
+
+/* Operation on the bus, it ends with TWINT set & the status in TWSR */
+static uint64_t g_operationDone = SIM_NO_EVENT;
+static uint8_t g_operationStatus;
+static uint8_t g_operationData;
+static uint8_t g_operationHasData;
+
+/* EEPROM */
+static uint8_t g_memory[SIM_EEPROM_SIZE];
+static uint16_t g_pointer = 0;
+static uint8_t g_block = 0;
+static uint8_t g_wordAddressNext = 0;
+static uint16_t g_pageAddress[SIM_EEPROM_PAGE_SIZE];
+static uint8_t g_pageData[SIM_EEPROM_PAGE_SIZE];
+static uint8_t g_pageCount = 0;
+static uint64_t g_busyUntil = 0;
+static uint64_t g_writeCycle;
+static const char *g_file = NULL;
+
+/* Bus glitch, the first operation from this time never ends (TWINT is lost) */
+static uint64_t g_glitchAt = SIM_NO_EVENT;
+
+/* Statistics */
+static uint64_t g_writeCycles = 0;
+static uint64_t g_nacks = 0;
+static uint64_t g_glitches = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * CPU cycles of one SCL period with the current TWBR & TWPS.
+ */
+static uint64_t SIM_twiSclCycles(void)
+{
+	static const uint32_t prescaler[4] = {1, 4, 16, 64};
+
+	return 16 + 2ULL * SIM_io[SIM_TWBR] * prescaler[SIM_io[SIM_TWSR] & 0x03];
+}
+
+static void SIM_twiSchedule(uint8_t status, uint64_t scl_periods)
+{
+	g_operationStatus = status;
+	g_operationHasData = 0;
+	g_operationDone = SIM_cycles + scl_periods * SIM_twiSclCycles();
+	if(SIM_cycles >= g_glitchAt)
+	{
+		/* a slave holds SCL low, the operation never ends until the TWI is reset */
+		g_glitchAt = SIM_NO_EVENT;
+		g_operationDone = SIM_NO_EVENT;
+		g_glitches++;
+	}
+}
+
+static void SIM_eepromSave(void)
+{
+	FILE *file;
+
+	if(g_file == NULL)
+	{
+		return;
+	}
+	file = fopen(g_file, "wb");
+	if(file == NULL)
+	{
+		SIM_log("can't write the EEPROM file %s", g_file);
+		return;
+	}
+	fwrite(g_memory, 1, SIM_EEPROM_SIZE, file);
+	fclose(file);
+}
+
+/*
+ * Description :
+ * Stop condition, a page write starts the internal write cycle of the EEPROM.
+ */
+static void SIM_twiStop(void)
+{
+	uint8_t i;
+
+	if((g_busState == SIM_BUS_TRANSMIT) && (g_pageCount != 0))
+	{
+		for(i = 0; i < g_pageCount; i++)
+		{
+			g_memory[g_pageAddress[i]] = g_pageData[i];
+		}
+		g_pageCount = 0;
+		g_busyUntil = SIM_cycles + g_writeCycle;
+		g_writeCycles++;
+		SIM_eepromSave();
+	}
+	g_busState = SIM_BUS_IDLE;
+}
+
+/*
+ * Description :
+ * The device address byte in TWDR is sent after a start.
+ */
+static void SIM_twiAddress(uint8_t address)
+{
+	uint8_t reading = address & 0x01;
+
+	if(((address & 0xF0) != SIM_EEPROM_DEVICE_TYPE) || (SIM_cycles < g_busyUntil))
+	{
+		/* no device or the EEPROM is busy with its write cycle (ACK polling) */
+		g_nacks++;
+		g_busState = SIM_BUS_NOT_ACKED;
+		SIM_twiSchedule(reading ? SIM_TWI_MR_SLA_R_NACK : SIM_TWI_MT_SLA_W_NACK, 9);
+		return;
+	}
+
+	g_block = (address >> 1) & 0x07;
+	if(reading)
+	{
+		g_busState = SIM_BUS_RECEIVE;
+		SIM_twiSchedule(SIM_TWI_MR_SLA_R_ACK, 9);
+	}
+	else
+	{
+		g_busState = SIM_BUS_TRANSMIT;
+		g_wordAddressNext = 1;
+		g_pageCount = 0;
+		SIM_twiSchedule(SIM_TWI_MT_SLA_W_ACK, 9);
+	}
+}
+
+static void SIM_twiTransmit(uint8_t data)
+{
+	uint16_t page;
+
+	if(g_wordAddressNext)
+	{
+		g_wordAddressNext = 0;
+		g_pointer = (uint16_t)((g_block << 8) | data);
+	}
+	else if(g_pageCount < SIM_EEPROM_PAGE_SIZE)
+	{
+		g_pageAddress[g_pageCount] = g_pointer;
+		g_pageData[g_pageCount] = data;
+		g_pageCount++;
+
+		/* the address rolls over inside the page */
+		page = g_pointer & (uint16_t)~(SIM_EEPROM_PAGE_SIZE - 1);
+		g_pointer = page | ((g_pointer + 1) & (SIM_EEPROM_PAGE_SIZE - 1));
+	}
+	else
+	{
+		/* more than a page: the oldest bytes of the page are written again */
+		memmove(&g_pageAddress[0], &g_pageAddress[1], sizeof(g_pageAddress) - sizeof(g_pageAddress[0]));
+		memmove(&g_pageData[0], &g_pageData[1], sizeof(g_pageData) - sizeof(g_pageData[0]));
+		g_pageAddress[SIM_EEPROM_PAGE_SIZE - 1] = g_pointer;
+		g_pageData[SIM_EEPROM_PAGE_SIZE - 1] = data;
+		page = g_pointer & (uint16_t)~(SIM_EEPROM_PAGE_SIZE - 1);
+		g_pointer = page | ((g_pointer + 1) & (SIM_EEPROM_PAGE_SIZE - 1));
+	}
+	SIM_twiSchedule(SIM_TWI_MT_DATA_ACK, 9);
+}
+
+static void SIM_twiReceive(uint8_t acknowledge)
+{
+	SIM_twiSchedule(acknowledge ? SIM_TWI_MR_DATA_ACK : SIM_TWI_MR_DATA_NACK, 9);
+	g_operationData = g_memory[g_pointer];
+	g_operationHasData = 1;
+	g_pointer = (g_pointer + 1) & (SIM_EEPROM_SIZE - 1);
+}
+
+void SIM_twiGlitch(void)
+{
+	g_glitchAt = SIM_cycles;
+}
+
+static void SIM_twiInit(void)
+{
+	FILE *file;
+
+	memset(g_memory, 0xFF, sizeof(g_memory));
+	g_writeCycle = SIM_optionNumber("HAL_EEPROM_WRITE_US", 5000) * SIM_CYCLES_PER_US;
+	g_file = SIM_option("HAL_EEPROM_FILE", NULL);
+	if(SIM_option("HAL_TWI_GLITCH_MS", NULL) != NULL)
+	{
+		g_glitchAt = SIM_optionNumber("HAL_TWI_GLITCH_MS", 0) * SIM_CYCLES_PER_MS;
+	}
+	if(g_file != NULL)
+	{
+		file = fopen(g_file, "rb");
+		if(file != NULL)
+		{
+			if(fread(g_memory, 1, SIM_EEPROM_SIZE, file) != SIM_EEPROM_SIZE)
+			{
+				SIM_log("EEPROM file %s is shorter than %d bytes", g_file, SIM_EEPROM_SIZE);
+			}
+			fclose(file);
+		}
+	}
+}
+
+static int SIM_twiAccess(uint8_t address, uint8_t *presented)
+{
+	if(address != SIM_TWCR)
+	{
+		return 0;
+	}
+
+	/* TWWC is never set by the model, it marks the value as not written */
+	presented[0] = (uint8_t)(g_control | (g_interruptFlag << SIM_TWINT) | (1 << SIM_TWWC));
+	return 1;
+}
+
+static void SIM_twiCommit(uint8_t address, const uint8_t *presented, const uint8_t *accessed, uint8_t vector)
+{
+	uint8_t value = accessed[0];
+
+	(void)address;
+	(void)vector;
+
+	if((value & (1 << SIM_TWWC)) && (value == presented[0]))
+	{
+		/* read */
+		return;
+	}
+
+	g_control = value & SIM_TWCR_CONTROL_BITS;
+	if(!(value & (1 << SIM_TWEN)))
+	{
+		/* the TWI is switched off, the transmission in progress is lost */
+		g_interruptFlag = 0;
+		g_operationDone = SIM_NO_EVENT;
+		g_busState = SIM_BUS_IDLE;
+		return;
+	}
+	if(!(value & (1 << SIM_TWINT)))
+	{
+		/* only the enable bits are changed */
+		return;
+	}
+
+	/* writing one to TWINT clears it & starts the next operation */
+	g_interruptFlag = 0;
+	if(value & (1 << SIM_TWSTO))
+	{
+		SIM_twiStop();
+	}
+
+	if(value & (1 << SIM_TWSTA))
+	{
+		SIM_twiSchedule((g_busState == SIM_BUS_IDLE) ? SIM_TWI_START : SIM_TWI_REP_START, 1);
+		g_busState = SIM_BUS_STARTED;
+		return;
+	}
+
+	switch(g_busState)
+	{
+	case SIM_BUS_STARTED:
+		SIM_twiAddress(SIM_io[SIM_TWDR]);
+		break;
+	case SIM_BUS_TRANSMIT:
+		SIM_twiTransmit(SIM_io[SIM_TWDR]);
+		break;
+	case SIM_BUS_RECEIVE:
+		SIM_twiReceive((value & (1 << SIM_TWEA)) != 0);
+		break;
+	default:
+		/* nothing to do after a stop or a NACK */
+		break;
+	}
+}
+
+static uint64_t SIM_twiNextEvent(void)
+{
+	return g_operationDone;
+}
+
+static void SIM_twiAdvance(void)
+{
+	if(g_operationDone > SIM_cycles)
+	{
+		return;
+	}
+	g_operationDone = SIM_NO_EVENT;
+	SIM_io[SIM_TWSR] = (uint8_t)(g_operationStatus | (SIM_io[SIM_TWSR] & 0x03));
+	if(g_operationHasData)
+	{
+		SIM_io[SIM_TWDR] = g_operationData;
+	}
+	g_interruptFlag = 1;
+}
+
+static uint32_t SIM_twiPending(void)
+{
+	if(g_interruptFlag && (g_control & (1 << SIM_TWIE)) && (g_control & (1 << SIM_TWEN)))
+	{
+		return SIM_VECTOR_MASK(SIM_TWI_VECTOR);
+	}
+	return 0;
+}
+
+static void SIM_twiExit(void)
+{
+	SIM_log("EEPROM %llu write cycles, %llu NACKs, %llu lost TWI operations",
+			(unsigned long long)g_writeCycles, (unsigned long long)g_nacks, (unsigned long long)g_glitches);
+}
+
+static const SIM_ModelType g_twiModel =
+{
+	"twi",
+	SIM_twiInit,
+	NULL,
+	SIM_twiAccess,
+	SIM_twiCommit,
+	SIM_twiNextEvent,
+	SIM_twiAdvance,
+	SIM_twiPending,
+	NULL,
+	SIM_twiExit
+};
+
+__attribute__((constructor)) static void SIM_twiRegister(void)
+{
+	SIM_register(&g_twiModel);
+}
@@ -0,0 +1,454 @@
+ /******************************************************************************
+ * Module: Simulator
+ * File Name: sim_uart.c
+ * Description: Model of the ATmega32 USART & of the serial link to the other ECU.
+ *
+ * The link is a stream socket (HAL_UART_FD) carrying time stamped messages, each
+ * ECU only runs up to the time the other one has reached plus the link lookahead,
+ * so the two simulations stay in step and a run is the same on any host.
+ * Author: Yousif Adel
+ *******************************************************************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "sim.h"
+#include "sim_link.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* UCSRA bits */
+#define SIM_RXC							7
+#define SIM_TXC							6
+#define SIM_UDRE						5
+#define SIM_DOR							3
+#define SIM_U2X							1
+#define SIM_MPCM						0
+
+/* UCSRB bits */
+#define SIM_RXCIE						7
+#define SIM_TXCIE						6
+#define SIM_UDRIE						5
+#define SIM_RXEN						4
+#define SIM_TXEN						3
+#define SIM_UCSZ2						2
+
+/* UCSRC bits */
+#define SIM_URSEL						7
+#define SIM_UPM1						5
+#define SIM_USBS						3
+
+/* Put in the unused high byte of the UDR access to tell a read from a write */
+#define SIM_UDR_MARKER					0xA5
+
+/* Bytes on the wire waiting for their arrival time, power of 2 */
+#define SIM_LINK_QUEUE_SIZE				1024
+
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint64_t time;
+	uint8_t data;
+}SIM_LinkByteType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Receiver: two bytes FIFO behind UDR */
+static uint8_t g_rxFifo[2];
+static uint8_t g_rxCount = 0;
+static uint8_t g_dataOverRun = 0;
+
+/* Transmitter: UDR buffer & shift register */
+static uint8_t g_txData;
+static uint8_t g_txFull = 0;
+static uint64_t g_shiftDone = SIM_NO_EVENT;
+static uint8_t g_txComplete = 0;
+
+/* UBRRH & UCSRC share the same address, URSEL selects the written one */
+static uint8_t g_ubrrh = 0;
+static uint8_t g_ucsrc = 0x86;
+static uint8_t g_sharedRegister = 0;
+
+/* Link to the other ECU */
+static int g_fd = -1;
+static int g_trace = 0;
+static uint64_t g_lookahead;
+static uint64_t g_peerTime = 0;
+static uint64_t g_lastSent = 0;
+static SIM_LinkByteType g_linkQueue[SIM_LINK_QUEUE_SIZE];
+static uint16_t g_linkHead = 0;
+static uint16_t g_linkTail = 0;
+static uint8_t g_message[SIM_LINK_MESSAGE_SIZE];
+static uint8_t g_messageLength = 0;
+
+/* Statistics */
+static uint64_t g_txBytes = 0;
+static uint64_t g_rxBytes = 0;
+static uint64_t g_lostBytes = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * CPU cycles to send one frame with the current baud rate & frame format.
+ */
+static uint64_t SIM_uartFrameCycles(void)
+{
+	uint32_t ubrr = ((uint32_t)(g_ubrrh & 0x0F) << 8) | SIM_io[SIM_UBRRL];
+	uint32_t divider = (SIM_io[SIM_UCSRA] & (1 << SIM_U2X)) ? 8 : 16;
+	uint32_t bits;
+
+	/* start bit + 5 .. 9 data bits + parity + stop bits */
+	bits = 1 + 5 + ((g_ucsrc >> 1) & 0x03) + ((SIM_io[SIM_UCSRB] & (1 << SIM_UCSZ2)) ? 4 : 0);
+	bits += (g_ucsrc & (1 << SIM_UPM1)) ? 1 : 0;
+	bits += (g_ucsrc & (1 << SIM_USBS)) ? 2 : 1;
+
+	return (uint64_t)bits * divider * (ubrr + 1);
+}
+
+static void SIM_linkClosed(void)
+{
+	SIM_log("link closed by the other ECU");
+	close(g_fd);
+	g_fd = -1;
+	if(SIM_optionNumber("HAL_EXIT_ON_LINK_CLOSE", 1))
+	{
+		SIM_exit(EXIT_SUCCESS);
+	}
+}
+
+static void SIM_linkSend(uint8_t type, uint8_t data, uint64_t arrival)
+{
+	uint8_t message[SIM_LINK_MESSAGE_SIZE];
+	ssize_t sent;
+	size_t offset = 0;
+
+	message[SIM_LINK_TYPE_OFFSET] = type;
+	message[SIM_LINK_DATA_OFFSET] = data;
+	SIM_linkPut64(&message[SIM_LINK_SENDER_TIME_OFFSET], SIM_cycles);
+	SIM_linkPut64(&message[SIM_LINK_ARRIVAL_OFFSET], arrival);
+
+	while(offset < SIM_LINK_MESSAGE_SIZE)
+	{
+		/* no SIGPIPE when the other ECU has already ended */
+		sent = send(g_fd, &message[offset], SIM_LINK_MESSAGE_SIZE - offset, MSG_NOSIGNAL);
+		if(sent < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			SIM_linkClosed();
+			return;
+		}
+		offset += (size_t)sent;
+	}
+	g_lastSent = SIM_cycles;
+}
+
+static void SIM_linkReceive(void)
+{
+	uint8_t buffer[64 * SIM_LINK_MESSAGE_SIZE];
+	ssize_t received;
+	ssize_t i;
+	uint16_t next;
+
+	received = read(g_fd, buffer, sizeof(buffer));
+	if(received < 0 && errno == EINTR)
+	{
+		return;
+	}
+	if(received <= 0)
+	{
+		SIM_linkClosed();
+		return;
+	}
+
+	for(i = 0; i < received; i++)
+	{
+		g_message[g_messageLength++] = buffer[i];
+		if(g_messageLength < SIM_LINK_MESSAGE_SIZE)
+		{
+			continue;
+		}
+		g_messageLength = 0;
+		g_peerTime = SIM_linkGet64(&g_message[SIM_LINK_SENDER_TIME_OFFSET]);
+
+		if(g_message[SIM_LINK_TYPE_OFFSET] == SIM_LINK_DATA)
+		{
+			next = (g_linkHead + 1) & (SIM_LINK_QUEUE_SIZE - 1);
+			if(next == g_linkTail)
+			{
+				g_lostBytes++;
+				continue;
+			}
+			g_linkQueue[g_linkHead].time = SIM_linkGet64(&g_message[SIM_LINK_ARRIVAL_OFFSET]);
+			g_linkQueue[g_linkHead].data = g_message[SIM_LINK_DATA_OFFSET];
+			g_linkHead = next;
+		}
+	}
+}
+
+/*
+ * Description :
+ * The last cycle this ECU may reach before hearing from the other one, it waits on
+ * the link when it is already there. A byte sent by the other ECU at its time T
+ * arrives at T + lookahead or later, so running before that never misses a byte.
+ */
+static uint64_t SIM_linkHorizon(void)
+{
+	while((g_fd >= 0) && (g_peerTime + g_lookahead <= SIM_cycles + 1))
+	{
+		/* let the other ECU run up to our time before waiting for it */
+		if(g_lastSent != SIM_cycles)
+		{
+			SIM_linkSend(SIM_LINK_TIME, 0, SIM_cycles);
+		}
+		if(g_fd >= 0)
+		{
+			SIM_linkReceive();
+		}
+	}
+	return (g_fd >= 0) ? (g_peerTime + g_lookahead - 1) : SIM_NO_EVENT;
+}
+
+/*
+ * Description :
+ * Move a byte into the shift register, it reaches the other ECU after one frame.
+ */
+static void SIM_uartStartShift(uint8_t data, uint64_t start)
+{
+	uint64_t arrival;
+
+	g_shiftDone = start + SIM_uartFrameCycles();
+	g_txComplete = 0;
+	g_txBytes++;
+
+	if(g_trace)
+	{
+		SIM_log("UART TX 0x%02X", data);
+	}
+	if(g_fd >= 0)
+	{
+		/* the other ECU may already be up to one lookahead ahead of this time */
+		arrival = g_shiftDone;
+		if(arrival < SIM_cycles + g_lookahead)
+		{
+			arrival = SIM_cycles + g_lookahead;
+		}
+		SIM_linkSend(SIM_LINK_DATA, data, arrival);
+	}
+}
+
+static void SIM_uartInit(void)
+{
+	g_fd = (int)SIM_optionNumber("HAL_UART_FD", (uint64_t)-1);
+	g_trace = (int)SIM_optionNumber("HAL_TRACE_UART", 0);
+	g_lookahead = SIM_optionNumber("HAL_LINK_LOOKAHEAD_US", 1000) * SIM_CYCLES_PER_US;
+	if(g_lookahead < 2)
+	{
+		g_lookahead = 2;
+	}
+	SIM_io[SIM_UCSRA] = (1 << SIM_UDRE);
+}
+
+static void SIM_uartObserve(void)
+{
+	uint8_t flags = 0;
+
+	if(SIM_io[SIM_UCSRC_UBRRH] != g_sharedRegister)
+	{
+		g_sharedRegister = SIM_io[SIM_UCSRC_UBRRH];
+		if(g_sharedRegister & (1 << SIM_URSEL))
+		{
+			g_ucsrc = g_sharedRegister;
+		}
+		else
+		{
+			g_ubrrh = g_sharedRegister;
+		}
+	}
+
+	/* the status flags belong to the hardware, only U2X & MPCM are written */
+	if(g_rxCount != 0)
+		flags |= (1 << SIM_RXC);
+	if(g_txComplete)
+		flags |= (1 << SIM_TXC);
+	if(!g_txFull)
+		flags |= (1 << SIM_UDRE);
+	if(g_dataOverRun)
+		flags |= (1 << SIM_DOR);
+	SIM_io[SIM_UCSRA] = (uint8_t)((SIM_io[SIM_UCSRA] & ((1 << SIM_U2X) | (1 << SIM_MPCM))) | flags);
+}
+
+static int SIM_uartAccess(uint8_t address, uint8_t *presented)
+{
+	if(address != SIM_UDR)
+	{
+		return 0;
+	}
+	presented[0] = (g_rxCount != 0) ? g_rxFifo[0] : 0;
+	presented[1] = SIM_UDR_MARKER;
+	return 1;
+}
+
+static void SIM_uartCommit(uint8_t address, const uint8_t *presented, const uint8_t *accessed, uint8_t vector)
+{
+	(void)address;
+
+	if((accessed[1] == SIM_UDR_MARKER) && (accessed[0] == presented[0]) && (vector != SIM_USART_UDRE_VECTOR))
+	{
+		/* read: pop the receive FIFO */
+		if(g_rxCount != 0)
+		{
+			g_rxFifo[0] = g_rxFifo[1];
+			g_rxCount--;
+		}
+		g_dataOverRun = 0;
+		return;
+	}
+
+	/* write */
+	if(!(SIM_io[SIM_UCSRB] & (1 << SIM_TXEN)))
+	{
+		return;
+	}
+	if(g_shiftDone == SIM_NO_EVENT)
+	{
+		SIM_uartStartShift(accessed[0], SIM_cycles);
+	}
+	else
+	{
+		/* a byte written while UDRE is cleared replaces the waiting one */
+		g_txData = accessed[0];
+		g_txFull = 1;
+	}
+}
+
+static uint64_t SIM_uartNextEvent(void)
+{
+	uint64_t next = SIM_linkHorizon();
+
+	if(g_shiftDone < next)
+	{
+		next = g_shiftDone;
+	}
+	if((g_linkTail != g_linkHead) && (g_linkQueue[g_linkTail].time < next))
+	{
+		next = g_linkQueue[g_linkTail].time;
+	}
+	return next;
+}
+
+static void SIM_uartAdvance(void)
+{
+	uint64_t done;
+	uint8_t data;
+
+	if((g_fd >= 0) && (SIM_cycles >= g_lastSent + (g_lookahead / 2)))
+	{
+		SIM_linkSend(SIM_LINK_TIME, 0, SIM_cycles);
+	}
+
+	if(g_shiftDone <= SIM_cycles)
+	{
+		done = g_shiftDone;
+		g_shiftDone = SIM_NO_EVENT;
+		if(g_txFull)
+		{
+			g_txFull = 0;
+			SIM_uartStartShift(g_txData, done);
+		}
+		else
+		{
+			g_txComplete = 1;
+		}
+	}
+
+	while((g_linkTail != g_linkHead) && (g_linkQueue[g_linkTail].time <= SIM_cycles))
+	{
+		data = g_linkQueue[g_linkTail].data;
+		g_linkTail = (g_linkTail + 1) & (SIM_LINK_QUEUE_SIZE - 1);
+
+		if(!(SIM_io[SIM_UCSRB] & (1 << SIM_RXEN)))
+		{
+			g_lostBytes++;
+			continue;
+		}
+		if(g_rxCount == 2)
+		{
+			/* the FIFO is full, the new byte is lost */
+			g_dataOverRun = 1;
+			g_lostBytes++;
+			continue;
+		}
+		if(g_trace)
+		{
+			SIM_log("UART RX 0x%02X", data);
+		}
+		g_rxFifo[g_rxCount++] = data;
+		g_rxBytes++;
+	}
+
+	SIM_uartObserve();
+}
+
+static uint32_t SIM_uartPending(void)
+{
+	uint8_t ucsrb = SIM_io[SIM_UCSRB];
+	uint32_t pending = 0;
+
+	if((g_rxCount != 0) && (ucsrb & (1 << SIM_RXCIE)))
+		pending |= SIM_VECTOR_MASK(SIM_USART_RXC_VECTOR);
+	if(!g_txFull && (ucsrb & (1 << SIM_UDRIE)))
+		pending |= SIM_VECTOR_MASK(SIM_USART_UDRE_VECTOR);
+	if(g_txComplete && (ucsrb & (1 << SIM_TXCIE)))
+		pending |= SIM_VECTOR_MASK(SIM_USART_TXC_VECTOR);
+	return pending;
+}
+
+static void SIM_uartAcknowledge(uint8_t vector)
+{
+	if(vector == SIM_USART_TXC_VECTOR)
+	{
+		g_txComplete = 0;
+	}
+}
+
+static void SIM_uartExit(void)
+{
+	SIM_log("UART %llu bytes sent, %llu received, %llu lost",
+			(unsigned long long)g_txBytes, (unsigned long long)g_rxBytes, (unsigned long long)g_lostBytes);
+	if(g_fd >= 0)
+	{
+		close(g_fd);
+		g_fd = -1;
+	}
+}
+
+static const SIM_ModelType g_uartModel =
+{
+	"uart",
+	SIM_uartInit,
+	SIM_uartObserve,
+	SIM_uartAccess,
+	SIM_uartCommit,
+	SIM_uartNextEvent,
+	SIM_uartAdvance,
+	SIM_uartPending,
+	SIM_uartAcknowledge,
+	SIM_uartExit
+};
+
+__attribute__((constructor)) static void SIM_uartRegister(void)
+{
+	SIM_register(&g_uartModel);
+}